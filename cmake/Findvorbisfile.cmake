@@ -0,0 +1,70 @@
+#.rst:
+# Findvorbisfile
+# -------------
+#
+# Locate the libvorbisfile ogg vorbis decoder, the music is streamed with it
+#
+# This module defines:
+#
+# ::
+#
+#   VORBISFILE_LIBRARIES, the libraries to link against, vorbisfile, vorbis
+#                         and ogg
+#   VORBISFILE_INCLUDE_DIRS, where to find the headers
+#   VORBISFILE_FOUND, if false, do not try to link against
+#
+#
+#
+# $VORBISDIR and $OGGDIR are environment variables pointing at the install
+# prefixes, when they aren't in the system paths.
+
+find_path(VORBISFILE_INCLUDE_DIR vorbis/vorbisfile.h
+  HINTS
+    ENV VORBISDIR
+  PATH_SUFFIXES include
+)
+
+find_path(OGG_INCLUDE_DIR ogg/ogg.h
+  HINTS
+    ENV OGGDIR
+    ENV VORBISDIR
+  PATH_SUFFIXES include
+)
+
+if(CMAKE_SIZEOF_VOID_P EQUAL 8)
+  set(VC_LIB_PATH_SUFFIX lib/x64)
+else()
+  set(VC_LIB_PATH_SUFFIX lib/x86)
+endif()
+
+find_library(VORBISFILE_LIBRARY
+  NAMES vorbisfile libvorbisfile
+  HINTS
+    ENV VORBISDIR
+  PATH_SUFFIXES lib ${VC_LIB_PATH_SUFFIX}
+)
+
+find_library(VORBIS_LIBRARY
+  NAMES vorbis libvorbis
+  HINTS
+    ENV VORBISDIR
+  PATH_SUFFIXES lib ${VC_LIB_PATH_SUFFIX}
+)
+
+find_library(OGG_LIBRARY
+  NAMES ogg libogg
+  HINTS
+    ENV OGGDIR
+    ENV VORBISDIR
+  PATH_SUFFIXES lib ${VC_LIB_PATH_SUFFIX}
+)
+
+set(VORBISFILE_LIBRARIES ${VORBISFILE_LIBRARY} ${VORBIS_LIBRARY} ${OGG_LIBRARY})
+set(VORBISFILE_INCLUDE_DIRS ${VORBISFILE_INCLUDE_DIR} ${OGG_INCLUDE_DIR})
+
+include(FindPackageHandleStandardArgs)
+
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(vorbisfile
+                                  REQUIRED_VARS VORBISFILE_LIBRARY VORBIS_LIBRARY OGG_LIBRARY VORBISFILE_INCLUDE_DIR OGG_INCLUDE_DIR)
+
+mark_as_advanced(VORBISFILE_LIBRARY VORBIS_LIBRARY OGG_LIBRARY VORBISFILE_INCLUDE_DIR OGG_INCLUDE_DIR)
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Packs values into the fewest bits, least significant bit first. Network
+// packets are built with it, so the layout doesn't depend on the platform.
+class BitWriter {
+public:
+  // the low bits of value
+  void Write(uint32_t value, int bits);
+  void WriteBool(bool value) { this->Write(value ? 1 : 0, 1); }
+  // small values in fewer bits, a 2 bit size class then 4, 8, 16 or 32 bits
+  void WriteVarUnsigned(uint32_t value);
+  // zigzag encoded, so small negative values stay small too
+  void WriteVarSigned(int32_t value);
+
+  void Clear();
+  // padded to a whole byte
+  const std::vector<uint8_t> &GetData() const { return this->data; }
+  size_t GetBitCount() const { return this->bits; }
+
+private:
+  std::vector<uint8_t> data;
+  size_t bits = 0;
+};
+
+// Reads what a BitWriter wrote. Reading past the end returns zeros and sets
+// the overflow flag, so a packet is only checked once after decoding it.
+class BitReader {
+public:
+  BitReader(const uint8_t *data, size_t size) : data(data), size(size) {}
+
+  uint32_t Read(int bits);
+  bool ReadBool() { return this->Read(1) != 0; }
+  uint32_t ReadVarUnsigned();
+  int32_t ReadVarSigned();
+
+  bool HasOverflowed() const { return this->overflowed; }
+  size_t GetBitCount() const { return this->bits; }
+
+private:
+  const uint8_t *data;
+  size_t size; // in bytes
+  size_t bits = 0;
+  bool overflowed = false;
+};
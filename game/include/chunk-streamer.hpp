@@ -0,0 +1,80 @@
+#pragma once
+
+#include "level-format.hpp"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#ifndef EMSCRIPTEN
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+static_assert(LEVEL_CHUNK_TILES <= 32, "a chunk row has to fit in a uint32_t");
+
+// the tiles of one level chunk, ready to be drawn and collided with
+struct TilemapChunk {
+  uint32_t index; // in the level's chunk table
+  // layerCount * LEVEL_CHUNK_TILES^2 gids, empty if the chunk has no tiles
+  std::vector<uint32_t> gids;
+  uint8_t classes[LEVEL_CHUNK_TILES * LEVEL_CHUNK_TILES];
+  uint32_t solidRows[LEVEL_CHUNK_TILES]; // 1 bit per tile
+  // the solid tiles greedily merged into as few rects as possible, in pixels
+  std::vector<SDL_Rect> solidRects;
+  // the chunk's range of the level's spawns, empty if it was out of bounds
+  uint32_t firstSpawn;
+  uint32_t spawnCount;
+};
+
+// Loads level chunks on a background thread. Request() queues a chunk, the
+// worker reads its chunk table entry and tiles from its own file handle and
+// merges the solid tiles, and Poll() hands the finished chunks to the main
+// thread. Chunks handed back with Recycle() are reused so streaming doesn't
+// allocate once it's warm.
+// On EMSCRIPTEN there are no threads and Request() loads right away.
+class ChunkStreamer {
+public:
+  ChunkStreamer() = default;
+  ChunkStreamer(const ChunkStreamer &) = delete;
+  ChunkStreamer &operator=(const ChunkStreamer &) = delete;
+  ~ChunkStreamer();
+
+  bool Open(const char *path, const LevelHeader &header, uint8_t solidClass);
+  void Close();
+
+  void Request(uint32_t chunk);
+  // appends the chunks that finished loading since the last Poll
+  void Poll(std::vector<std::unique_ptr<TilemapChunk>> &out);
+  // blocks until every requested chunk has finished loading
+  void Wait();
+  void Recycle(std::unique_ptr<TilemapChunk> chunk);
+
+private:
+  // fills chunk with the chunk at index, allocates it if it is null
+  void load(uint32_t index, std::unique_ptr<TilemapChunk> &chunk);
+  void mergeSolidTiles(TilemapChunk &chunk) const;
+
+  SDL_RWops *file = nullptr;
+  LevelHeader header = {};
+  uint8_t solidClass = 0;
+  std::vector<uint8_t> readBuffer; // worker only
+
+  // guarded by mutex when there is a worker
+  std::deque<uint32_t> requests;
+  std::vector<std::unique_ptr<TilemapChunk>> loaded;
+  std::vector<std::unique_ptr<TilemapChunk>> spare;
+  uint32_t inFlight = 0; // requested and not loaded yet
+  bool quit = false;
+
+#ifndef EMSCRIPTEN
+  void run();
+
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable wake; // there is a request or quit is set
+  std::condition_variable idle; // inFlight dropped to 0
+#endif
+};
@@ -1,37 +1,63 @@
 #pragma once
+#include <cmath>
 #include <flecs.h>
 #include <glm/glm.hpp>
 #include <memory>
+#include <random>
+#include <span>
 #include <spritesheet.hpp>
 #include <string>
 #include <texture.hpp>
+#include <unordered_map>
 
+// position, scale and rotation are relative to the parent, the global_
+// values are composed from them by Transform2DPlugin once per tick
 struct Transform2D {
   glm::vec2 position;
   glm::vec2 scale;
   float rotation;
   glm::vec2 global_position;
+  glm::vec2 global_scale;
+  float global_rotation;
+  // global position as of the previous tick, and interpolated between the
+  // two for the current frame. draw with render_position
+  glm::vec2 previous_global_position;
+  glm::vec2 render_position;
+
+  // set when the global transform changed this tick, children of an
+  // unchanged parent are only recomposed if their own values changed
+  bool changed;
+  glm::vec2 composed_position;
+  glm::vec2 composed_scale;
+  float composed_rotation; // NAN until the first compose
 
   Transform2D(glm::vec2 position, glm::vec2 scale, float rotation)
       : position(position), scale(scale), rotation(rotation),
-        global_position(position) {}
+        global_position(position), global_scale(scale),
+        global_rotation(rotation), previous_global_position(position),
+        render_position(position), changed(true), composed_position(position),
+        composed_scale(scale), composed_rotation(NAN) {}
 
-  Transform2D()
-      : position(glm::vec2(0, 0)), scale(glm::vec2(1, 1)), rotation(0),
-        global_position(position) {}
+  Transform2D() : Transform2D(glm::vec2(0, 0), glm::vec2(1, 1), 0) {}
 
   Transform2D WithPosition(glm::vec2 position) {
+    // spawned this tick, there is nothing to interpolate from
     this->position = position;
+    this->global_position = position;
+    this->previous_global_position = position;
+    this->render_position = position;
     return *this;
   }
 
   Transform2D WithScale(glm::vec2 scale) {
     this->scale = scale;
+    this->global_scale = scale;
     return *this;
   }
 
   Transform2D WithRotation(float rotation) {
     this->rotation = rotation;
+    this->global_rotation = rotation;
     return *this;
   }
 };
@@ -45,12 +71,42 @@ struct Health {
   float value;
 };
 
-struct Path {
+// world singleton, gameplay randomness has to come from here so a recorded
+// session replays the same way. seeded once per level by the game
+struct Random {
+  std::minstd_rand engine;
+};
+
+typedef uint32_t PathHandle;
+
+// world singleton, every patrol route of the level stored once in one
+// contiguous buffer. entities on the same route share it
+struct PathTable {
+  struct Route {
+    uint32_t firstPoint;
+    uint32_t pointCount;
+  };
+
   std::vector<glm::vec2> points;
-  int targetPointIndex;
+  std::vector<Route> routes;
+  // by the uid of the level object a route came from, so spawns that are
+  // streamed in again reuse their route
+  std::unordered_map<uint32_t, PathHandle> byObject;
+
+  PathHandle AddRoute(std::span<const glm::vec2> route) {
+    this->routes.push_back({static_cast<uint32_t>(this->points.size()),
+                            static_cast<uint32_t>(route.size())});
+    this->points.insert(this->points.end(), route.begin(), route.end());
+    return this->routes.size() - 1;
+  }
+};
+
+// a route in the PathTable and how far along it the entity is
+struct Path {
+  PathHandle route;
+  uint32_t targetPointIndex;
 
-  Path() : targetPointIndex(0) {}
+  Path() : route(0), targetPointIndex(0) {}
 
-  Path(std::vector<glm::vec2> points, int targetPointIndex)
-      : points(points), targetPointIndex(0) {}
+  Path(PathHandle route) : route(route), targetPointIndex(0) {}
 };
@@ -2,9 +2,15 @@
 
 #include "flecs.h"
 #include <components.hpp>
+#include <deque>
 #include <font.hpp>
+#include <input-recording.hpp>
+#include <level-cache.hpp>
 #include <memory>
 #include <mixer.hpp>
+#include <plugins/timestep.hpp>
+#include <replay.hpp>
+#include <rollback-world.hpp>
 #include <shared-data.hpp>
 #include <sprite-batch.hpp>
 #include <spritesheet.hpp>
@@ -20,12 +26,49 @@ public:
   int unload();
   int close();
 
+  // the level at path from the cache, seeded on first use
+  flecs::world *getLevel(const std::string &path);
+
   std::unique_ptr<SpriteBatch> spriteBatcher;
-  flecs::world world;
+  LevelCache levels;
+  flecs::world *world = nullptr; // the level being played, owned by levels
 
   bool level1 = true;
 
   std::unique_ptr<Mixer> mixer;
 
   bool drawColliders = false;
+
+  // simulation tick rate and catch up limit, applied every frame
+  TimestepSettings timestep = {DEFAULT_TICK_RATE, DEFAULT_MAX_CATCH_UP_STEPS,
+                               DEFAULT_WORKER_THREADS};
+  // audio device and mixing, applied when the mixer is created
+  MixerSettings audio = {DEFAULT_MIXER_FREQUENCY, DEFAULT_MIXER_BUFFER_FRAMES,
+                         false};
+  Uint64 lastFrame = 0;
+  // the last sampled input has been seen by at least one tick
+  bool inputConsumed = true;
+
+  // input recording and replay, see SharedData::input_mode
+  SharedData *sharedData = nullptr;
+  InputRecorder recorder;
+  InputPlayer player;
+  ReplayStats replayStats;
+  uint32_t seed = 0; // of every level's Random
+
+  // with SharedData::rollback_ticks the level runs through a rollback
+  // session, player 0 gets the local input that many ticks late and the
+  // local player 1 drives nothing. a benchmark of the re-simulation that
+  // ends on the same state hash as a plain replay
+  void startRollback();
+  // delivers the late inputs, corrects the world and logs the stats
+  void settleRollback();
+  void stepRollback();
+  std::unique_ptr<RollbackWorld> rollbackWorld;
+  std::unique_ptr<RollbackSession> rollback;
+  std::deque<std::pair<uint32_t, RollbackInput>> lateInputs;
+  int lateTicks = 0;
+  // by tick, the map's stream epoch it ran with. the chunks of the oldest
+  // tick that can still be re-simulated stay pinned
+  uint32_t streamEpochs[ROLLBACK_HISTORY] = {};
 };
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "flecs.h"
+#include <memory>
+#include <plugins/timestep.hpp>
+#include <sprite-batch.hpp>
+#include <string>
+#include <vector>
+
+// levels kept resident, the one being played and the one to switch to
+#define LEVEL_CACHE_SIZE 2
+
+// Keeps recently played levels around as fully built worlds, switching to a
+// resident level is a pointer swap and it resumes where it was left instead
+// of going through LoadLevel again.
+class LevelCache {
+public:
+  LevelCache(size_t capacity = LEVEL_CACHE_SIZE);
+
+  // the world for the tilemap at path, built if it isn't resident. may evict
+  // the least recently used level
+  flecs::world *Get(const std::string &path, SpriteBatch *renderer,
+                    TimestepSettings settings);
+
+  // builds the level ahead of time without making it the most recent, does
+  // nothing if it is resident. the spawns create textures, so this has to
+  // run on the gl thread and can't be done in the background
+  void Prefetch(const std::string &path, SpriteBatch *renderer,
+                TimestepSettings settings);
+
+  // rebuilds the level cached under path from the tilemap at source, for hot
+  // reloading an edited copy. Get(path) returns the new world after this
+  void Reload(const std::string &path, const std::string &source,
+              SpriteBatch *renderer, TimestepSettings settings);
+
+private:
+  struct Level {
+    std::string path;
+    std::unique_ptr<flecs::world> world;
+    uint64_t lastUsed; // 0 if only prefetched
+  };
+
+  // about to be destroyed, stops being the active level
+  void forget(const Level &level);
+  Level *find(const std::string &path);
+  Level &load(const std::string &path, const std::string &source,
+              SpriteBatch *renderer, TimestepSettings settings);
+
+  std::vector<Level> levels;
+  size_t capacity;
+  uint64_t useCount;
+  flecs::world *active; // the last world Get returned, with worker threads
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+
+// Binary cooked level format, written by scripts/level_cooker.py from tiled
+// .tmx maps. Every section is 4 byte aligned and little-endian, offsets are in
+// bytes from the start of the file so the metadata can be used in place once
+// it is mapped into memory. The tiles are stored last in square chunks that are
+// streamed in around the camera instead (see ChunkStreamer).
+
+#define LEVEL_MAGIC 0x564C4C47 // "GLLV"
+#define LEVEL_VERSION 2
+#define LEVEL_NO_OBJECT 0xFFFFFFFF
+#define LEVEL_EMPTY_CHUNK 0xFFFFFFFF
+
+// chunks are LEVEL_CHUNK_TILES^2 tiles, edge chunks are padded with empty tiles
+#define LEVEL_CHUNK_TILES 32
+// layerCount * LEVEL_CHUNK_TILES^2 uint32_t gids then LEVEL_CHUNK_TILES^2
+// uint8_t tile classes, both row major
+#define LEVEL_CHUNK_BYTES(layerCount)                                          \
+  (((layerCount) * sizeof(uint32_t) + 1) * LEVEL_CHUNK_TILES *               \
+   LEVEL_CHUNK_TILES)
+
+struct LevelString {
+  uint32_t offset; // from the start of the strings section
+  uint32_t length; // without the null terminator
+};
+
+struct LevelHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t width;  // in tiles
+  uint32_t height; // in tiles
+  uint32_t tileWidth;
+  uint32_t tileHeight;
+  uint32_t layerCount;
+  uint32_t chunkColumns;
+  uint32_t chunkRows;
+  uint32_t chunksOffset; // chunkColumns * chunkRows LevelChunk, row major
+  uint32_t classCount;
+  uint32_t classesOffset; // classCount LevelString, class 0 is "no class"
+  uint32_t spawnCount;
+  uint32_t spawnsOffset; // spawnCount LevelSpawn sorted by chunk then uid
+  uint32_t uidCount;
+  uint32_t uidIndexOffset; // uidCount uint32_t spawn indices
+  uint32_t pointCount;
+  uint32_t pointsOffset; // pointCount x, y float pairs in world space
+  uint32_t stringsOffset;
+  uint32_t stringsSize;
+  uint32_t tilesetImage; // string offset, relative to the level file
+  uint32_t tilesetFirstGid;
+  // the chunk tiles, everything before this is loaded up front
+  uint32_t chunkDataOffset;
+};
+
+struct LevelChunk {
+  // the tiles are at chunkDataOffset + dataIndex * LEVEL_CHUNK_BYTES, or
+  // LEVEL_EMPTY_CHUNK if the chunk has no tiles
+  uint32_t dataIndex;
+  uint32_t firstSpawn;
+  uint32_t spawnCount;
+};
+
+struct LevelSpawn {
+  uint32_t uid;
+  LevelString className;
+  LevelString name;
+  float x;
+  float y;
+  float w;
+  float h;
+  uint32_t path; // uid of the "path" object property or LEVEL_NO_OBJECT
+  uint32_t firstPoint;
+  uint32_t pointCount; // polyline / polygon points
+};
+
+static_assert(sizeof(LevelHeader) == 23 * sizeof(uint32_t));
+static_assert(sizeof(LevelChunk) == 3 * sizeof(uint32_t));
+static_assert(sizeof(LevelSpawn) == 12 * sizeof(uint32_t));
@@ -0,0 +1,50 @@
+#pragma once
+#ifndef EMSCRIPTEN
+#include "rtc/rtc.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A stand-in for the online signaling backend, a WebSocket server on
+// localhost that speaks the same json messages to NetManager:
+//   {"type": "host"}                      -> {"type": "roomCode", ...}
+//   {"type": "join", "roomCode": code}    -> {"type": "requestOffer", "id"}
+//                                            once per peer already in the
+//                                            room, or {"type": "exception"}
+//   offer, answer and candidate messages are relayed to their "id", which
+//   is swapped for the sender's
+// The peers connect to each other directly afterwards, over host candidates
+// when NetManager is given no ice servers.
+class LocalSignalingServer {
+public:
+  // port 0 picks a free one
+  LocalSignalingServer(uint16_t port = 0);
+  ~LocalSignalingServer();
+
+  uint16_t getPort() const;
+  // for NetSettings::signalingUrl
+  std::string getUrl() const;
+  // whether a host has opened the room, the joins before that fail
+  bool hasRoom(const std::string &code);
+
+private:
+  struct Client {
+    std::shared_ptr<rtc::WebSocket> ws;
+    std::string room;
+  };
+
+  void onMessage(const std::string &id, const std::string &text);
+  void onClosed(const std::string &id);
+  void send(const std::string &id, const std::string &message);
+
+  std::unique_ptr<rtc::WebSocketServer> server;
+  std::mutex mutex;
+  std::unordered_map<std::string, Client> clients;
+  std::unordered_map<std::string, std::vector<std::string>> rooms;
+  uint32_t nextClient = 1;
+  uint32_t nextRoom = 1;
+};
+#endif
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// seconds, the conditioners and the loopback take their time from one so
+// the tests can step it by hand
+typedef std::function<double()> NetClock;
+
+// the performance counter in seconds
+double NetWallClock();
+
+// How the game talks to its peers, over WebRTC with NetManager or in process
+// with LoopbackTransport. The callbacks may run on the transport's own
+// threads, unless it says otherwise.
+class NetTransport {
+public:
+  virtual ~NetTransport() = default;
+
+  void setCallbacks(
+      std::function<void(std::string)> onConnection,
+      std::function<void(std::string, std::string)> onMessage,
+      std::function<void(std::string, const std::vector<uint8_t> &)>
+          onBinary) {
+    this->onConnection = onConnection;
+    this->onMessage = onMessage;
+    this->onBinary = onBinary;
+  }
+
+  virtual void connect() = 0;
+  virtual void sendTo(std::string id, std::string message) = 0;
+  virtual void sendBinaryTo(std::string id,
+                            const std::vector<uint8_t> &data) = 0;
+  // runs the callbacks of the messages that arrived, for the transports
+  // that queue them
+  virtual void poll() {}
+
+protected:
+  std::function<void(std::string)> onConnection;
+  std::function<void(std::string, std::string)> onMessage;
+  std::function<void(std::string, const std::vector<uint8_t> &)> onBinary;
+};
+
+// an emulated network link, all zero is a perfect one
+struct LinkConditions {
+  float latencyMs; // one way
+  float jitterMs;  // added or taken off the latency at random, reorders
+  float loss;      // 0 to 1, of the messages dropped
+  float bandwidthKbps; // 0 is unlimited
+  // messages waiting longer than this for the bandwidth are dropped, like a
+  // full router queue
+  float queueMs;
+};
+
+struct LinkStats {
+  uint64_t sent;
+  uint64_t dropped; // lost or over the queue
+  uint64_t bytes;   // of the messages that weren't dropped
+};
+
+// Decides when a message arrives over a link, or that it doesn't. Seeded so
+// a soak run loses the same messages every time.
+class LinkConditioner {
+public:
+  LinkConditioner(const LinkConditions &conditions, uint32_t seed)
+      : conditions(conditions), random(seed) {}
+
+  void SetConditions(const LinkConditions &conditions) {
+    this->conditions = conditions;
+  }
+  // false if the message is dropped, otherwise its arrival time
+  bool Schedule(double now, size_t bytes, double &arrival);
+
+  const LinkStats &GetStats() const { return this->stats; }
+
+private:
+  LinkConditions conditions;
+  std::minstd_rand random;
+  double linkFree = 0.0; // when the last message is done going out
+  LinkStats stats = {};
+};
+
+// messages waiting for their arrival time, delivered in arrival order
+class NetInbox {
+public:
+  enum Kind { CONNECTION, MESSAGE, BINARY };
+
+  struct Delivery {
+    double arrival;
+    uint64_t order; // of the push, breaks ties
+    Kind kind;
+    std::string peer;
+    std::string message;
+    std::vector<uint8_t> data;
+  };
+
+  // any thread
+  void Push(Delivery delivery);
+  // the deliveries due at now, in order
+  void PopDue(double now, std::vector<Delivery> &out);
+
+private:
+  std::mutex mutex;
+  std::vector<Delivery> heap;
+  uint64_t pushed = 0;
+};
+
+// Runs another transport's messages through a LinkConditioner as they come
+// in, the callbacks run from poll() once they are due. Wraps NetManager to
+// play over a bad connection on purpose.
+class ConditionedTransport : public NetTransport {
+public:
+  ConditionedTransport(std::unique_ptr<NetTransport> inner,
+                       const LinkConditions &conditions, uint32_t seed,
+                       NetClock clock = NetWallClock);
+
+  void connect() override { this->inner->connect(); }
+  void sendTo(std::string id, std::string message) override {
+    this->inner->sendTo(id, message);
+  }
+  void sendBinaryTo(std::string id,
+                    const std::vector<uint8_t> &data) override {
+    this->inner->sendBinaryTo(id, data);
+  }
+  void poll() override;
+
+  // the inner transport calls back from its own threads
+  LinkStats GetStats();
+
+private:
+  void receive(NetInbox::Kind kind, std::string peer, std::string message,
+               std::vector<uint8_t> data);
+
+  NetClock clock;
+  std::mutex mutex;
+  LinkConditioner conditioner;
+  NetInbox inbox;
+  std::vector<NetInbox::Delivery> due;
+  // last, destroyed first. its threads call receive() until it is gone
+  std::unique_ptr<NetTransport> inner;
+};
+
+class LoopbackTransport;
+
+// An in-process network for tests and benchmarks, no sockets and no outside
+// services. Every pair of peers is connected by a conditioned link in each
+// direction, the messages are delivered by the receiver's poll(). Single
+// threaded.
+class LoopbackNetwork {
+public:
+  LoopbackNetwork(const LinkConditions &conditions = {}, uint32_t seed = 0,
+                  NetClock clock = NetWallClock);
+
+  // every link, the existing ones too
+  void SetConditions(const LinkConditions &conditions);
+  // a peer named id, it connects to the others on connect()
+  std::unique_ptr<LoopbackTransport> CreatePeer(const std::string &id);
+
+  // summed over the links
+  LinkStats GetStats() const;
+
+private:
+  friend class LoopbackTransport;
+
+  void join(LoopbackTransport *peer);
+  void leave(LoopbackTransport *peer);
+  void send(LoopbackTransport *from, const std::string &to,
+            NetInbox::Kind kind, std::string message,
+            std::vector<uint8_t> data);
+
+  LinkConditions conditions;
+  uint32_t seed;
+  NetClock clock;
+  std::vector<LoopbackTransport *> peers; // connected
+  std::unordered_map<std::string, LinkConditioner> links; // by "from>to"
+};
+
+class LoopbackTransport : public NetTransport {
+public:
+  LoopbackTransport(LoopbackNetwork *network, const std::string &id)
+      : network(network), id(id) {}
+  ~LoopbackTransport() override;
+
+  const std::string &getId() const { return this->id; }
+
+  void connect() override;
+  void sendTo(std::string id, std::string message) override;
+  void sendBinaryTo(std::string id,
+                    const std::vector<uint8_t> &data) override;
+  // the callbacks run from here, on the calling thread
+  void poll() override;
+
+private:
+  friend class LoopbackNetwork;
+
+  LoopbackNetwork *network;
+  std::string id;
+  NetInbox inbox;
+  std::vector<NetInbox::Delivery> due;
+};
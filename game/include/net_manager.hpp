@@ -1,4 +1,5 @@
 #pragma once
+#include "net-transport.hpp"
 #include "rtc/rtc.hpp"
 #include <functional>
 #include <string>
@@ -20,10 +21,19 @@ using std::shared_ptr;
 using std::weak_ptr;
 template <class T> weak_ptr<T> make_weak_ptr(shared_ptr<T> ptr) { return ptr; }
 
-class NetManager {
+#define NET_SIGNALING_URL "wss://gl-game-backend.deno.dev"
+
+// where NetManager finds its peers, point it at a LocalSignalingServer with
+// no ice servers to play on one machine without going online
+struct NetSettings {
+  std::string signalingUrl = NET_SIGNALING_URL;
+  std::vector<std::string> iceServers = {
+      "stun:stun1.l.google.com:19302", "stun:stun2.l.google.com:19302",
+      "stun:stun3.l.google.com:19302", "stun:stun4.l.google.com:19302"};
+};
+
+class NetManager : public NetTransport {
 private:
-  std::function<void(std::string)> onConnection;
-  std::function<void(std::string, std::string)> onMessage;
   std::unordered_map<std::string, shared_ptr<rtc::PeerConnection>>
       peerConnections;
   std::unordered_map<std::string, shared_ptr<rtc::DataChannel>> dataChannels;
@@ -31,6 +41,7 @@ private:
   rtc::Configuration config;
   std::string hostJoin;
   std::string roomCode;
+  NetSettings settings;
 
   void createDataChannel(shared_ptr<rtc::PeerConnection> pc, std::string id) {
     // We are the offerer, so create a data channel to initiate the process
@@ -55,11 +66,14 @@ private:
     });
 
     dc->onMessage([this, id, wdc = make_weak_ptr(dc)](auto data) {
-      // data holds either std::string or rtc::binary; we need string
+      // data holds either std::string or rtc::binary, the binary messages
+      // are game state packets
       if (std::holds_alternative<std::string>(data)) {
         onMessage(id, std::get<std::string>(data));
-      } else {
-        return;
+      } else if (onBinary) {
+        const auto &bytes = std::get<rtc::binary>(data);
+        const auto *begin = reinterpret_cast<const uint8_t *>(bytes.data());
+        onBinary(id, std::vector<uint8_t>(begin, begin + bytes.size()));
       }
     });
   }
@@ -104,13 +118,14 @@ private:
 public:
   NetManager(std::string hostJoin, std::string roomCode,
              std::function<void(std::string)> onConnection,
-             std::function<void(std::string, std::string)> onMessage)
-      : hostJoin(hostJoin), roomCode(roomCode), onConnection(onConnection),
-        onMessage(onMessage) {
-    config.iceServers.emplace_back("stun:stun1.l.google.com:19302");
-    config.iceServers.emplace_back("stun:stun2.l.google.com:19302");
-    config.iceServers.emplace_back("stun:stun3.l.google.com:19302");
-    config.iceServers.emplace_back("stun:stun4.l.google.com:19302");
+             std::function<void(std::string, std::string)> onMessage,
+             const NetSettings &settings = {})
+      : hostJoin(hostJoin), roomCode(roomCode), settings(settings) {
+    this->onConnection = onConnection;
+    this->onMessage = onMessage;
+    for (const auto &server : settings.iceServers) {
+      config.iceServers.emplace_back(server);
+    }
   }
 
   ~NetManager() {
@@ -205,13 +220,24 @@ public:
       }
     });
 
-    ws->open("wss://gl-game-backend.deno.dev");
-    SDL_Log("swag. (talking to deno)\n");
+    ws->open(settings.signalingUrl);
+    SDL_Log("swag. (talking to %s)\n", settings.signalingUrl.c_str());
   }
 
-  void sendTo(std::string id, std::string message) {
+  void connect() override { connectToSignaling(); }
+
+  void sendTo(std::string id, std::string message) override {
     if (auto jt = dataChannels.find(id); jt != dataChannels.end()) {
       jt->second->send(message);
     }
   }
+
+  // binary messages, see replication.hpp
+  void sendBinaryTo(std::string id,
+                    const std::vector<uint8_t> &data) override {
+    if (auto jt = dataChannels.find(id); jt != dataChannels.end()) {
+      jt->second->send(reinterpret_cast<const std::byte *>(data.data()),
+                       data.size());
+    }
+  }
 };
\ No newline at end of file
@@ -7,6 +7,7 @@
 // components
 struct Camera {
   glm::vec2 position;
+  flecs::entity target; // followed if set, see SpawnPlayer
 };
 
 // plugin
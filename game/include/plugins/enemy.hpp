@@ -3,6 +3,7 @@
 #include <components.hpp>
 #include <flecs.h>
 #include <glm/glm.hpp>
+#include <plugins/graphics.hpp>
 #include <plugins/physics.hpp>
 
 // components
@@ -12,7 +13,8 @@ struct Enemy {
 };
 
 // systems
-void enemyUpdate(Enemy *e, Velocity *v, Path *p, Transform2D *t);
+void enemyUpdate(const PathTable &paths, int count, Velocity *v, Path *p,
+                 Transform2D *t, Sprite *s);
 
 // plugin
 struct EnemyPlugin {
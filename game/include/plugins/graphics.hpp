@@ -9,22 +9,25 @@
 
 // components:
 
+// only used by the render pipeline, which runs on the main thread
 struct Renderer {
   SpriteBatch *renderer;
 };
 
 struct Sprite {
   std::shared_ptr<Texture> texture;
+  bool flipX; // facing, kept out of the transform so children don't mirror
 };
 
 struct AnimatedSprite {
   std::shared_ptr<SpriteSheet> spriteSheet;
   float currentTime;
   int currentFrame;
-  SpriteAnimation *currentAnimation;
+  AnimationHandle currentAnimation;
   bool isAnimationFinished;
+  bool flipX; // facing, kept out of the transform so children don't mirror
 
-  void SetAnimation(SpriteAnimation *animation) {
+  void SetAnimation(AnimationHandle animation) {
     if (this->currentAnimation == animation) {
       return;
     }
@@ -34,14 +37,20 @@ struct AnimatedSprite {
     this->isAnimationFinished = false;
   };
 
+  const SpriteAnimation &GetAnimation() const {
+    return this->spriteSheet->GetAnimation(this->currentAnimation);
+  }
+
   AnimatedSprite(std::shared_ptr<SpriteSheet> spriteSheet,
-                 SpriteAnimation *animation)
+                 AnimationHandle animation)
       : spriteSheet(spriteSheet), currentTime(0), currentFrame(0),
-        currentAnimation(animation), isAnimationFinished(false) {}
+        currentAnimation(animation), isAnimationFinished(false),
+        flipX(false) {}
 
   AnimatedSprite()
       : spriteSheet(nullptr), currentTime(0), currentFrame(0),
-        currentAnimation(nullptr) {}
+        currentAnimation(DEFAULT_ANIMATION), isAnimationFinished(false),
+        flipX(false) {}
 };
 
 struct UIFilledRect {
@@ -77,12 +86,17 @@ struct AdjustingTextBox {
 
 void renderSprite(SpriteBatch *renderer, Transform2D &t, Sprite &s);
 
-void renderAnimatedSprite(SpriteBatch *renderer, float delta, Transform2D &t,
-                          AnimatedSprite &s);
+// plays delta seconds of the animation, runs with the simulation ticks
+void advanceAnimation(AnimatedSprite &s, float delta);
+
+void renderAnimatedSprite(SpriteBatch *renderer, const Transform2D &t,
+                          const AnimatedSprite &s);
 
 void renderUIFilledRect(SpriteBatch *renderer, Transform2D &t, UIFilledRect &r);
 
-void renderAdjustingTextBox(SpriteBatch *renderer, Transform2D &t,
+// the box and its text above t by the height of the text, which it measures
+// for the next frame. nothing the simulation sees is written
+void renderAdjustingTextBox(SpriteBatch *renderer, const Transform2D &t,
                             UIFilledRect &u, AdjustingTextBox &b);
 
 // plugin:
@@ -9,10 +9,40 @@ struct Map {
   std::shared_ptr<Tilemap> value;
 };
 
+// spawned from a level object when its chunk was streamed in, despawned when
+// the chunk is unloaded
+struct StreamedFrom {
+  uint32_t chunk;
+  uint32_t spawn; // index into the level's spawns
+};
+
+// world singleton, by spawn index whether the spawn's entity is out or was
+// killed. cleared when its chunk unloads with the entity still alive, so only
+// those come back when the chunk is streamed in again
+struct SpawnState {
+  std::vector<bool> consumed;
+};
+
+// world singleton, the chunks streamed in and out since the last tick. the
+// tick spawns and despawns what came with them
+struct StreamedChunks {
+  std::vector<uint32_t> loaded;
+  std::vector<uint32_t> unloaded;
+  // the map's stream epoch the tick collides against. setting the singleton
+  // sets it on the map, a rollback gives a re-simulated tick its old one
+  uint32_t epoch;
+};
+
 // systems:
-void collideWithMap(Tilemap *map, flecs::entity e, Transform2D &t,
-                    CollisionVolume &c, Groundable &g);
+void collideWithMap(const Tilemap *map, Transform2D &t, CollisionVolume &c,
+                    Groundable &g);
+
+// streams the map's chunks around center in and out, their spawns come and
+// go with the next tick
+void streamMap(Tilemap &map, StreamedChunks &streamed, glm::vec2 center);
 
+// builds the level into a fresh world that has its Renderer and
+// FixedTimestep set
 void LoadLevel(flecs::world &ecs, std::shared_ptr<Tilemap> map);
 
 void DrawColliders(flecs::world &ecs, SpriteBatch *sb);
@@ -4,28 +4,36 @@
 #include <SDL.h>
 #include <components.hpp>
 #include <flecs.h>
+#include <spatial-grid.hpp>
+#include <span>
+#include <timer-wheel.hpp>
+
+class Tilemap;
+
 // components:
 struct Groundable {
   bool isGrounded;
+  bool isTouchingMap; // overlapping or next to a solid tile
 };
 
 struct CollisionVolume {
   glm::vec4 vertices;
 };
 
+// a contact between two broadphase items, written by the narrowphase
 struct CollisionEvent {
-  flecs::entity entity1;
-  flecs::entity entity2;
-  Transform2D *transform1;
-  Transform2D *transform2;
-  CollisionVolume *collisionVolume1;
-  CollisionVolume *collisionVolume2;
+  uint32_t a;
+  uint32_t b;
 };
 
 struct PhysicsBody {};
 
 struct StaticBody {};
 
+// fast movers, moved by sweeping against the map and static bodies instead of
+// stepping and pushing out, so they can't tunnel through thin walls
+struct ContinuousCollision {};
+
 struct Velocity {
   glm::vec2 value;
 };
@@ -34,11 +42,61 @@ struct Gravity {
   float value;
 };
 
+// despawned seconds after it is set, the deadline is kept by the Timers
 struct LiveFor {
   float seconds;
+  TimerHandle timer; // the pending deadline, older ones are ignored
+};
+
+// collider flags snapshot by the broadphase
+#define COLLIDER_HURTBOX (1 << 0) // has an active Hurtbox
+#define COLLIDER_HEALTH (1 << 1)
+#define COLLIDER_PHYSICS_BODY (1 << 2)
+#define COLLIDER_STATIC_BODY (1 << 3)
+
+// the narrowphase splits the grid cells into at most this many ranges
+#define NARROWPHASE_RANGES 8
+
+// one range of grid cells, the narrowphase runs over these entities so the
+// flecs workers share the cells out
+struct NarrowphaseRange {
+  int index;
+};
+
+// world singleton, rebuilt every tick from <Transform2D, CollisionVolume>
+struct Broadphase {
+  SpatialGrid grid;
+
+  // per grid item, snapshot when the grid is built so the pair loop never
+  // has to look at the entity
+  std::vector<flecs::entity> entities;
+  std::vector<SDL_Rect> rects;
+  std::vector<uint8_t> flags;
+  std::vector<float> damage; // of the hurtbox
+
+  // contacts for this tick, in cell order so they don't depend on threading
+  std::vector<CollisionEvent> events;
+  std::vector<std::vector<CollisionEvent>> workerEvents; // per range
+
+  // filled by the response handlers, applied in one batch
+  std::vector<float> damageTaken;
+  std::vector<flecs::entity> despawns;
+
+  // gameplay queries against the colliders as of the last physics tick
+  void QueryAABB(glm::vec4 aabb, std::vector<flecs::entity> &out);
+  void QueryRadius(glm::vec2 center, float radius,
+                   std::vector<flecs::entity> &out);
+  // time of impact against the static bodies, see SpatialGrid::sweep. const,
+  // so the swept movers can query it from several threads
+  float Sweep(glm::vec4 aabb, glm::vec2 delta, glm::vec2 &normal) const;
+
+private:
+  std::vector<uint32_t> results;
 };
 
 // utils:
+glm::vec4 collision_aabb(const Transform2D &t, const CollisionVolume &c);
+
 void push_rect_transform(const SDL_Rect &rect, const SDL_Rect &pushedBy,
                          Transform2D &t1, CollisionVolume &c1);
 
@@ -47,14 +105,41 @@ void applyGravity(flecs::iter it, Velocity *v, Groundable *g);
 
 void applyVelocity(flecs::iter it, Velocity *v, Transform2D *t);
 
-void runEntityCollisions(flecs::entity e1, Transform2D &t1, CollisionVolume &c1,
-                         flecs::entity e2, Transform2D &t2,
-                         CollisionVolume &c2);
+// moves one swept body by velocity * dt against the map and the static
+// bodies, sliding along what it hits. velocity is zeroed on the axes it hit
+void sweepBody(const Tilemap &map, const Broadphase &b,
+               const CollisionVolume &c, glm::vec2 &position,
+               glm::vec2 &velocity, float dt);
+
+void applySweptVelocity(flecs::iter it, Velocity *v, Transform2D *t,
+                        CollisionVolume *c);
+
+void runBroadphase(Broadphase &b,
+                   const flecs::query<Transform2D, CollisionVolume> &colliders);
+
+// the pairs of one NarrowphaseRange, safe to run for several at once
+void runNarrowphase(Broadphase &b, int range);
+
+void mergeNarrowphase(Broadphase &b);
+
+void applyCollisionDamage(flecs::iter it, Broadphase &b);
 
-void dieOfOldAge(flecs::iter it, LiveFor *l);
+void applyCollisionPushOut(flecs::iter it, Broadphase &b);
 
-// plugin:
+void applyCollisionDespawns(flecs::iter it, Broadphase &b);
+
+void expireLifetimes(flecs::iter &it, std::span<const TimerEntry> due);
+
+// plugins:
+// movement, runs before the transforms are propagated
 class PhysicsPlugin : public Plugin {
+public:
+  void addSystems(flecs::world &ecs) override;
+};
+
+// entity vs entity collisions, reads the global transforms so it has to be
+// added after Transform2DPlugin
+class CollisionPlugin : public Plugin {
 public:
   void addSystems(flecs::world &ecs) override;
 };
\ No newline at end of file
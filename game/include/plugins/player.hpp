@@ -6,20 +6,40 @@
 #include "plugin.hpp"
 #include "plugins/graphics.hpp"
 #include "plugins/physics.hpp"
+#include "plugins/pool.hpp"
 #include <mixer.hpp>
 
 // components:
+// animations are resolved to handles once when the player is spawned
+struct PlayerAnimations {
+  AnimationHandle idle;
+  AnimationHandle run;
+  AnimationHandle jump;
+  AnimationHandle attack;
+};
+
 struct Player {
   std::string name;
   bool isAttacking;                         // @TODO move to child collider
   std::shared_ptr<SoundEffect> soundEffect; // @TODO make own component
   std::shared_ptr<Music> music;             // @TODO make own component
   glm::vec4 defaultRect;                    // @TODO move this
+  PlayerAnimations animations;
+  // which of the RollbackInputs drives it, when the world has them
+  int inputSlot = 0;
+};
+
+// the player's children, resolved once when the player is spawned so the
+// systems follow the ids instead of looking up names
+struct PlayerRig {
+  flecs::entity hurtbox;
+  flecs::entity arrow;
 };
 
 // systems:
-void playerUpdate(flecs::iter it, Player *p, Velocity *v, CollisionVolume *c,
-                  AnimatedSprite *s, Transform2D *t, Groundable *g);
+void playerUpdate(flecs::iter it, Player *p, PlayerRig *r, Velocity *v,
+                  CollisionVolume *c, AnimatedSprite *s, Transform2D *t,
+                  Groundable *g, EntityPool *pool);
 
 // plugin:
 class PlayerPlugin : public Plugin {
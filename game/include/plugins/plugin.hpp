@@ -1,6 +1,10 @@
 #pragma once
 #include "flecs.h"
 
+// pipelines, systems pick one with .kind<Phase>()
+struct SimulationPhase {}; // runs at the fixed tick rate
+struct RenderPhase {};     // runs once per frame
+
 class Plugin {
 public:
   virtual void addSystems(flecs::world &ecs) = 0;
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "plugins/plugin.hpp"
+#include <flecs.h>
+#include <unordered_map>
+#include <vector>
+
+// components:
+// on instances handed out by the EntityPool
+struct Pooled {
+  flecs::entity prefab;
+};
+
+// world singleton, recycles the instances of short lived prefabs. despawned
+// instances are disabled instead of destroyed and handed out again by the
+// next Acquire of the same prefab, so firing doesn't churn entity ids
+struct EntityPool {
+  // disabled instances per prefab, rebuilt at the start of every tick
+  std::unordered_map<flecs::entity_t, std::vector<flecs::entity>> free;
+
+  // a recycled instance of prefab, or a new one if there is none free. world
+  // is the stage of the calling system, the enable is deferred to its merge
+  flecs::entity Acquire(const flecs::world &world, flecs::entity prefab);
+};
+
+// systems:
+void collectFreeInstances(EntityPool &pool,
+                          const flecs::query<const Pooled> &disabled);
+
+// utils:
+// destroys e or, if it came from the pool, disables it. deferred, so it is
+// safe to call from multi_threaded systems
+void despawnEntity(flecs::iter &it, flecs::entity e);
+
+// plugin:
+// has to be added before the systems that Acquire
+class PoolPlugin : public Plugin {
+public:
+  void addSystems(flecs::world &ecs) override;
+};
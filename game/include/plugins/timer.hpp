@@ -0,0 +1,38 @@
+#pragma once
+
+#include "plugins/plugin.hpp"
+#include "plugins/timestep.hpp"
+#include <flecs.h>
+#include <span>
+#include <timer-wheel.hpp>
+#include <vector>
+
+// called once per tick with every timer of its event that came due
+typedef void (*TimerCallback)(flecs::iter &it,
+                              std::span<const TimerEntry> due);
+
+// components:
+// world singleton, deadlines for the simulation. register an event once,
+// schedule against it and the callback gets the expired timers in a batch
+struct Timers {
+  TimerWheel wheel;
+  float tick = 1.0f / DEFAULT_TICK_RATE; // seconds per wheel tick
+  std::vector<TimerCallback> callbacks;  // indexed by TimerEntry::event
+
+  std::vector<TimerEntry> due;
+  std::vector<std::vector<TimerEntry>> dueByEvent;
+
+  uint32_t AddEvent(TimerCallback callback);
+  // rounded up to whole ticks
+  TimerHandle Schedule(float seconds, flecs::entity target, uint32_t event);
+};
+
+// systems:
+void advanceTimers(flecs::iter &it, Timers &timers);
+
+// plugin:
+// has to be added before the systems and observers that Schedule
+class TimerPlugin : public Plugin {
+public:
+  void addSystems(flecs::world &ecs) override;
+};
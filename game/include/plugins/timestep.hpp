@@ -0,0 +1,96 @@
+#pragma once
+
+#include "plugins/plugin.hpp"
+#include <cmath>
+#include <components.hpp>
+#include <flecs.h>
+#include <thread>
+
+#define DEFAULT_TICK_RATE 60.0f
+// ticks run per frame before the simulation gives up and slows down
+#define DEFAULT_MAX_CATCH_UP_STEPS 5
+// threads for the multi_threaded simulation systems, 0 is one per core
+#define DEFAULT_WORKER_THREADS 0
+
+// components:
+struct TimestepSettings {
+  float tickRate; // simulation ticks per second
+  int maxCatchUpSteps;
+  int workerThreads;
+};
+
+// world singleton, survives LoadLevel
+struct FixedTimestep {
+  TimestepSettings settings;
+  float accumulator; // unsimulated time, in seconds
+  float alpha;       // how far the render frame is into the next tick
+  flecs::entity simulation;
+  flecs::entity render;
+};
+
+// systems:
+void storePreviousTransform(Transform2D &t);
+
+void interpolateTransform(Transform2D &t, float alpha);
+
+// runs as many simulation ticks as the frame needs then the render pipeline
+// once, returns the number of ticks that ran. beforeTick runs before every
+// tick after the first, runTick(seconds) runs a tick
+template <class F, class T>
+int StepWorld(flecs::world &ecs, float frameDelta, F &&beforeTick,
+              T &&runTick) {
+  FixedTimestep timestep = *ecs.get<FixedTimestep>();
+  const float tick = 1.0f / timestep.settings.tickRate;
+
+#ifndef EMSCRIPTEN
+  // the worker threads are gone after a world reset too
+  const int threads = glm::max(
+      timestep.settings.workerThreads > 0
+          ? timestep.settings.workerThreads
+          : static_cast<int>(std::thread::hardware_concurrency()),
+      1);
+  if (ecs.get_stage_count() != threads) {
+    ecs.set_threads(threads);
+  }
+#endif
+
+  timestep.accumulator += frameDelta;
+  int steps = 0;
+  while (timestep.accumulator >= tick &&
+         steps < timestep.settings.maxCatchUpSteps) {
+    if (steps > 0) {
+      beforeTick();
+    }
+    runTick(tick);
+    timestep.accumulator -= tick;
+    steps++;
+  }
+  // too far behind, drop the time instead of spiraling
+  if (timestep.accumulator >= tick) {
+    timestep.accumulator = fmodf(timestep.accumulator, tick);
+  }
+  timestep.alpha = timestep.accumulator / tick;
+  ecs.set<FixedTimestep>(timestep);
+
+  ecs.set_pipeline(timestep.render);
+  ecs.progress(frameDelta);
+  return steps;
+}
+
+// the ticks as runs of the simulation pipeline
+template <class F>
+int StepWorld(flecs::world &ecs, float frameDelta, F &&beforeTick) {
+  const flecs::entity simulation = ecs.get<FixedTimestep>()->simulation;
+  return StepWorld(ecs, frameDelta, beforeTick,
+                   [&ecs, simulation](float tick) {
+                     ecs.set_pipeline(simulation);
+                     ecs.progress(tick);
+                   });
+}
+
+// plugin:
+class TimestepPlugin : public Plugin {
+public:
+  // add first, the other plugins' systems are ordered after these
+  void addSystems(flecs::world &ecs) override;
+};
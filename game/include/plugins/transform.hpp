@@ -5,6 +5,12 @@
 #include <glm/glm.hpp>
 #include <plugins/plugin.hpp>
 
+// systems:
+void updateRootTransform(Transform2D &t);
+
+void updateChildTransform(Transform2D &t, const Transform2D &parent);
+
+// plugin:
 class Transform2DPlugin : public Plugin {
 public:
   void addSystems(flecs::world &world) override;
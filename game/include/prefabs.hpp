@@ -5,6 +5,16 @@
 #include "plugins/enemy.hpp"
 #include <glm/glm.hpp>
 
+// world singleton, the prefabs made by SpawnPlayer so systems can
+// instantiate them without looking them up by name
+struct PrefabRegistry {
+  flecs::entity tink;
+  flecs::entity ball;
+  flecs::entity hpBar;
+  flecs::entity directionArrow;
+  flecs::entity textArea;
+};
+
 void SpawnPlayer(flecs::world &ecs, glm::vec2 pos);
 
-void SpawnAnya(flecs::world &ecs, glm::vec2 pos, Path path);
\ No newline at end of file
+flecs::entity SpawnAnya(flecs::world &ecs, glm::vec2 pos, PathHandle route);
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "flecs.h"
+#include <cstdint>
+#include <vector>
+
+// Frame times of a replayed session, to compare builds against each other.
+struct ReplayStats {
+  std::vector<float> frameTimes; // milliseconds, wall clock
+
+  // logs the frame time percentiles and the final state hash
+  void Report(const char *path, uint64_t stateHash) const;
+};
+
+// hash of the simulation state that matters for a replay, the transforms,
+// velocities and health of the enabled entities. two runs of the same
+// recording have to end on the same hash
+uint64_t HashWorldState(flecs::world &ecs);
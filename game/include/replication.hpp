@@ -0,0 +1,128 @@
+#pragma once
+
+#include "bit-stream.hpp"
+#include "flecs.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// snapshots kept to delta against, a peer that hasn't acked one of the last
+// NET_SNAPSHOT_HISTORY gets a full snapshot
+#define NET_SNAPSHOT_HISTORY 32
+#define NET_SNAPSHOT_HISTORY_BITS 5
+// quantization steps per unit, a position is kept to an eighth of a pixel
+#define NET_POSITION_PRECISION 8.0f
+#define NET_VELOCITY_PRECISION 4.0f
+#define NET_HEALTH_PRECISION 256.0f
+
+// first byte of every binary packet
+enum NetPacketType : uint8_t {
+  NET_PACKET_SNAPSHOT = 1, // server to client
+  NET_PACKET_ACK = 2,      // client to server, the last snapshot decoded
+};
+
+// which of the optional components a replicated entity has
+#define NET_HAS_VELOCITY (1 << 0)
+#define NET_HAS_HEALTH (1 << 1)
+
+// entities carrying this are sent to the peers, the id is the same on every
+// peer while the flecs ids aren't
+struct Replicated {
+  uint32_t netId;
+};
+
+// a replicated entity as it goes over the wire, quantized so both ends delta
+// against exactly the same values
+struct NetEntityState {
+  uint32_t netId;
+  uint8_t components; // NET_HAS_*
+  glm::ivec2 position;
+  glm::ivec2 velocity;
+  int32_t health;
+};
+
+struct NetSnapshot {
+  uint32_t sequence;
+  uint32_t tick;
+  std::vector<NetEntityState> entities; // by netId
+};
+
+struct ReplicationStats {
+  uint64_t packets;
+  uint64_t bytes;
+  uint64_t entities;       // captured, summed over the packets
+  uint64_t changedRecords; // entities actually written
+  uint64_t ticks;          // performance counter, encoding or decoding
+
+  // logs the bandwidth per entity and the throughput
+  void Report(const char *name) const;
+};
+
+// Sends the Replicated entities as per-tick snapshots. Each snapshot is
+// delta encoded against the last one the peer acked, so unchanged entities
+// cost nothing and the rest only their changed fields. Nothing relies on
+// delivery, a lost packet just means a larger delta next time.
+class ReplicationServer {
+public:
+  // stamps entity with the next netId
+  uint32_t Track(flecs::entity entity);
+
+  // once per simulation tick, after the systems ran
+  void Capture(flecs::world &world, uint32_t tick);
+  // the packet with the last capture for peer, false before the first one
+  bool Encode(const std::string &peer, BitWriter &out);
+  // a NET_PACKET_ACK from peer, read past the type. false if it is malformed
+  bool ReadAck(const std::string &peer, BitReader &in);
+  void RemovePeer(const std::string &peer);
+
+  const ReplicationStats &GetStats() const { return this->stats; }
+
+private:
+  NetSnapshot history[NET_SNAPSHOT_HISTORY] = {};
+  uint32_t sequence = 0; // of the last capture, 0 before the first
+  uint32_t nextNetId = 1;
+  // by peer, the last sequence they acked
+  std::unordered_map<std::string, uint32_t> acked;
+  ReplicationStats stats = {};
+};
+
+// Decodes the snapshots of one server and applies them to a world, then
+// acks them so the server can delta against them.
+class ReplicationClient {
+public:
+  // a NET_PACKET_SNAPSHOT, read past the type. false if it is malformed, out
+  // of order or its baseline is gone
+  bool Decode(BitReader &in);
+  // moves, creates and destroys the Replicated entities to match the last
+  // decoded snapshot
+  void Apply(flecs::world &world);
+  // the ack to send back, after a successful Decode
+  void EncodeAck(BitWriter &out) const;
+
+  const NetSnapshot &GetLatest() const;
+  const ReplicationStats &GetStats() const { return this->stats; }
+
+private:
+  NetSnapshot history[NET_SNAPSHOT_HISTORY] = {};
+  uint32_t sequence = 0;
+  uint32_t applied = 0; // the sequence in the world
+  std::unordered_map<uint32_t, flecs::entity> entities;
+  ReplicationStats stats = {};
+};
+
+// quantized copies of the replicated components of the world, by netId
+void CaptureNetState(flecs::world &world,
+                     std::vector<NetEntityState> &entities);
+
+// writes the entities of current that changed since baseline, in netId
+// order. baseline is empty for a full snapshot. returns the records written
+uint32_t EncodeNetDelta(const std::vector<NetEntityState> &baseline,
+                        const std::vector<NetEntityState> &current,
+                        BitWriter &out);
+// rebuilds current from baseline and what EncodeNetDelta wrote, records is
+// set to the records read
+bool DecodeNetDelta(const std::vector<NetEntityState> &baseline,
+                    BitReader &in, std::vector<NetEntityState> &current,
+                    uint32_t &records);
@@ -2,12 +2,13 @@
 
 // resource paths:
 
-#define RES_SHEET_PLAYER "assets/textures/spritesheet.atlas"
+#define RES_SHEET_PLAYER "assets/textures/spritesheet.sheet"
 
 #define RES_FONT_VERA "assets/fonts/Vera.ttf"
 
-#define RES_TILEMAP_DEMO "assets/tilemaps/demo.tmx"
-#define RES_TILEMAP_DEMO2 "assets/tilemaps/demo2.tmx"
+// cooked from the .tmx maps with scripts/level_cooker.py
+#define RES_TILEMAP_DEMO "assets/tilemaps/demo.level"
+#define RES_TILEMAP_DEMO2 "assets/tilemaps/demo2.level"
 
 #define RES_TEXTURE_AMIIBO "assets/textures/amiibo.png"
 #define RES_TEXTURE_ARROW "assets/textures/arrow.png"
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "flecs.h"
+#include "input.hpp"
+#include "rollback.hpp"
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// slot of the between tick singletons for what was set since the last tick
+#define ROLLBACK_SINCE_LAST_TICK ROLLBACK_HISTORY
+
+// world singleton, the inputs of the tick being simulated. the player
+// systems read these instead of InputManager while it is set
+struct RollbackInputs {
+  InputSnapshot players[ROLLBACK_MAX_PLAYERS];
+  bool resimulating; // sounds and such are skipped
+};
+
+// A level's world as a RollbackSimulation. The states are flecs snapshots,
+// a tick is one run of the simulation pipeline with the inputs in
+// RollbackInputs and the checksum is HashWorldState.
+class RollbackWorld : public RollbackSimulation {
+public:
+  RollbackWorld(flecs::world &ecs);
+  ~RollbackWorld() override;
+
+  // a singleton the ticks change, saved and loaded with the snapshots. those
+  // leave out the component entities the singletons live on
+  template <class T> void Track() {
+    this->singletons.push_back(this->slots<T>(ROLLBACK_HISTORY));
+  }
+
+  // a singleton set between the ticks for the next one to use, like the
+  // chunks the camera streamed in. a re-simulated tick gets the value it got
+  // the first time, and what was set since the last tick is kept through a
+  // rollback
+  template <class T> void TrackBetweenTicks() {
+    const Singleton singleton = this->slots<T>(ROLLBACK_HISTORY + 1);
+    this->singletons.push_back(singleton);
+    this->betweenTicks.push_back(singleton);
+  }
+
+  void SaveState(uint32_t tick) override;
+  void LoadState(uint32_t tick) override;
+  void Step(const RollbackInput *inputs, bool resimulating) override;
+  uint64_t Checksum() override;
+
+private:
+  struct Singleton {
+    std::function<void(int)> save;
+    std::function<void(int)> load;
+  };
+
+  template <class T> Singleton slots(int count) {
+    auto saved = std::make_shared<std::vector<std::optional<T>>>(count);
+    flecs::world *ecs = &this->ecs;
+    return {[ecs, saved](int slot) {
+              const T *value = ecs->get<T>();
+              (*saved)[slot] =
+                  value != nullptr ? std::optional<T>(*value) : std::nullopt;
+            },
+            [ecs, saved](int slot) {
+              if ((*saved)[slot].has_value()) {
+                ecs->set<T>(*(*saved)[slot]);
+              } else {
+                ecs->remove<T>();
+              }
+            }};
+  }
+
+  flecs::world &ecs;
+  std::unique_ptr<flecs::snapshot> snapshots[ROLLBACK_HISTORY];
+  std::vector<Singleton> singletons;
+  std::vector<Singleton> betweenTicks; // also in singletons
+  uint32_t saved = 0;    // the tick of the last save
+  uint32_t loaded = 0;   // and load
+  uint32_t frontier = 0; // the ticks before it ran at least once
+};
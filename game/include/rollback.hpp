@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+
+#define ROLLBACK_MAX_PLAYERS 4
+// saved states, a rollback can go back at most ROLLBACK_HISTORY - 1 ticks
+#define ROLLBACK_HISTORY 16
+// inputs kept per player, the remote ones may run ahead of the local tick
+#define ROLLBACK_INPUT_HISTORY (2 * ROLLBACK_HISTORY)
+#define DEFAULT_ROLLBACK_MAX_TICKS 8
+// of the frame, for the re-simulation and the tick after it
+#define DEFAULT_ROLLBACK_BUDGET_MS 8.0f
+// ticks between the checksums the peers compare
+#define DEFAULT_ROLLBACK_CHECKSUM_INTERVAL 30
+// final checksums kept for the remote ones that are late
+#define ROLLBACK_CHECKSUM_HISTORY 64
+
+// one player's input for one tick, a bit per InputAction
+typedef uint32_t RollbackInput;
+
+// A deterministic fixed step simulation, the same state and inputs have to
+// give the same next state on every peer.
+class RollbackSimulation {
+public:
+  virtual ~RollbackSimulation() = default;
+
+  // the state before tick, the last ROLLBACK_HISTORY of them are kept
+  virtual void SaveState(uint32_t tick) = 0;
+  virtual void LoadState(uint32_t tick) = 0;
+  // the tick after the last save, with ROLLBACK_MAX_PLAYERS inputs. those
+  // past the players are 0. resimulating is set while replaying ticks after
+  // a rollback, for the effects that shouldn't go off twice
+  virtual void Step(const RollbackInput *inputs, bool resimulating) = 0;
+  // of the state that has to match between the peers
+  virtual uint64_t Checksum() = 0;
+};
+
+struct RollbackSettings {
+  int players; // up to ROLLBACK_MAX_PLAYERS
+  int localPlayer;
+  // furthest the simulation runs ahead of the confirmed inputs, below
+  // ROLLBACK_HISTORY
+  int maxRollbackTicks;
+  // fewer ticks are predicted when re-simulating them wouldn't fit, 0 doesn't
+  // limit them
+  float frameBudgetMs;
+  uint32_t checksumInterval;
+};
+
+struct RollbackStats {
+  uint64_t ticks;  // simulated for the first time
+  uint64_t stalls; // AdvanceTick waited for the remote inputs
+  uint64_t rollbacks;
+  uint64_t resimulatedTicks;
+  // performance counter, every step and every rollback with its load
+  uint64_t stepCounter;
+  uint64_t resimulateCounter;
+  uint64_t maxResimulateCounter;
+  uint64_t checksumsCompared;
+
+  // logs the rollback rate and the re-simulation cost
+  void Report() const;
+};
+
+// Runs a RollbackSimulation ahead of the remote inputs by predicting them
+// as the last confirmed one. When an input comes in that the prediction got
+// wrong the state before its tick is loaded and the ticks since are run
+// again, all within the same frame. The peers exchange checksums of the
+// ticks every input is confirmed for to catch a desync.
+class RollbackSession {
+public:
+  RollbackSession(RollbackSimulation &simulation,
+                  const RollbackSettings &settings);
+
+  // the next tick AdvanceTick runs
+  uint32_t GetTick() const { return this->tick; }
+
+  // the local input for GetTick(). the first one given for a tick is kept,
+  // so what the peers get is what runs here. true if it was taken and should
+  // be sent with the tick
+  bool AddLocalInput(RollbackInput input);
+  // a remote player's input, in any order and repeated or not
+  void AddRemoteInput(int player, uint32_t tick, RollbackInput input);
+
+  // corrects any misprediction, then runs the next tick. false if it is
+  // too far ahead of the remote inputs or the local input is missing, try
+  // again next frame
+  bool AdvanceTick();
+  // just the correction, once the last inputs are in and no tick follows
+  void Rollback();
+
+  // a checksum of a tick every input is confirmed for, to send to the peers.
+  // false if there is no new one
+  bool PopChecksum(uint32_t &tick, uint64_t &checksum);
+  void AddRemoteChecksum(int player, uint32_t tick, uint64_t checksum);
+  // the first tick the checksums didn't match, if any
+  bool IsDesynced() const { return this->desynced; }
+  uint32_t GetDesyncTick() const { return this->desyncTick; }
+
+  // ticks predicted past the confirmed inputs right now, and at most
+  int GetPredictedTicks() const;
+  int GetPredictionLimit() const;
+  const RollbackStats &GetStats() const { return this->stats; }
+
+private:
+  struct InputRecord {
+    uint32_t tick; // the record is stale unless it matches
+    RollbackInput input;
+    bool confirmed;
+    RollbackInput used; // what the last run of the tick was given
+    bool ran;
+  };
+
+  InputRecord &record(int player, uint32_t tick);
+  RollbackInput predict(int player) const;
+  void simulate(uint32_t tick, bool resimulating);
+  uint32_t confirmedTick() const; // every input before it is confirmed
+  // moves the checksums of the ticks that can't change anymore to final
+  void settleChecksums();
+  void compare(uint32_t tick, uint64_t local, uint64_t remote);
+
+  RollbackSimulation &simulation;
+  RollbackSettings settings;
+  uint32_t tick = 0;
+  // the oldest ran tick with a wrong prediction, UINT32_MAX if there is none
+  uint32_t rollbackTick = UINT32_MAX;
+  InputRecord inputs[ROLLBACK_MAX_PLAYERS][ROLLBACK_INPUT_HISTORY] = {};
+  // per player, every input before it is in
+  uint32_t confirmed[ROLLBACK_MAX_PLAYERS] = {};
+  RollbackInput lastConfirmed[ROLLBACK_MAX_PLAYERS] = {};
+  // the mean cost of a step in counter ticks, for the prediction limit
+  double meanStep = 0.0;
+
+  // by tick, the checksums waiting to be final and the final ones waiting on
+  // the remote ones
+  std::map<uint32_t, uint64_t> pendingChecksums;
+  std::map<uint32_t, uint64_t> finalChecksums;
+  uint32_t nextPop = 0; // the ones before it were popped
+  // by tick * ROLLBACK_MAX_PLAYERS + player
+  std::map<uint64_t, uint64_t> remoteChecksums;
+  bool desynced = false;
+  uint32_t desyncTick = 0;
+
+  RollbackStats stats = {};
+};
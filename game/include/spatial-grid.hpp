@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Uniform grid broadphase, rebuilt from scratch every tick:
+//   Clear() -> Insert() each collider -> Build() -> ForEachPair() / Query*()
+// AABBs are (min x, min y, max x, max y) in world space. The grid covers the
+// bounds of everything inserted, items are referred to by insertion index.
+class SpatialGrid {
+public:
+  SpatialGrid(float cellSize = 128.0f);
+
+  void Clear();
+  uint32_t Insert(glm::vec4 aabb);
+  void Build();
+
+  // calls fn(a, b) exactly once for every pair of overlapping items
+  template <class F> void ForEachPair(F &&fn) const {
+    this->ForEachPair(0, this->CellCount(), fn);
+  }
+
+  // only the pairs reported by cells [cellBegin, cellEnd), disjoint cell
+  // ranges report disjoint pairs so they can run on different threads
+  template <class F>
+  void ForEachPair(int cellBegin, int cellEnd, F &&fn) const {
+    for (int cell = cellBegin; cell < cellEnd; cell++) {
+      const uint32_t start = this->cellStart[cell];
+      const uint32_t end = this->cellStart[cell + 1];
+      for (uint32_t i = start; i < end; i++) {
+        const uint32_t a = this->cellItems[i];
+        for (uint32_t j = i + 1; j < end; j++) {
+          const uint32_t b = this->cellItems[j];
+          // a pair can share several cells, only the cell holding the min
+          // corner of the overlap reports it
+          if (overlaps(this->aabbs[a], this->aabbs[b]) &&
+              this->pairCell(a, b) == cell) {
+            fn(a, b);
+          }
+        }
+      }
+    }
+  }
+
+  // calls fn(item) once for every item overlapping the aabb. const, so any
+  // number of threads can query a built grid at once
+  template <class F> void ForEachInAABB(glm::vec4 aabb, F &&fn) const {
+    if (this->columns == 0 || !overlaps(aabb, this->bounds)) {
+      return;
+    }
+    const glm::ivec2 min = this->cellOf(glm::vec2(aabb.x, aabb.y));
+    const glm::ivec2 max = this->cellOf(glm::vec2(aabb.z, aabb.w));
+    for (int y = min.y; y <= max.y; y++) {
+      for (int x = min.x; x <= max.x; x++) {
+        const int cell = x + y * this->columns;
+        for (uint32_t i = this->cellStart[cell]; i < this->cellStart[cell + 1];
+             i++) {
+          const uint32_t item = this->cellItems[i];
+          const glm::vec4 &itemAABB = this->aabbs[item];
+          // an item spanning several cells is only reported by the cell
+          // holding the min corner of the overlap
+          if (overlaps(aabb, itemAABB) &&
+              this->cornerCell(glm::max(aabb.x, itemAABB.x),
+                               glm::max(aabb.y, itemAABB.y)) == cell) {
+            fn(item);
+          }
+        }
+      }
+    }
+  }
+
+  // appends every item overlapping the aabb / circle to out, once each
+  void QueryAABB(glm::vec4 aabb, std::vector<uint32_t> &out) const;
+  void QueryRadius(glm::vec2 center, float radius,
+                   std::vector<uint32_t> &out) const;
+
+  size_t Size() const { return this->aabbs.size(); }
+  int CellCount() const { return this->columns * this->rows; }
+  const glm::vec4 &GetAABB(uint32_t item) const { return this->aabbs[item]; }
+
+  static bool overlaps(const glm::vec4 &a, const glm::vec4 &b) {
+    return a.x < b.z && b.x < a.z && a.y < b.w && b.y < a.w;
+  }
+
+  // time of impact in [0, 1] of moving swept by delta into target, or > 1 if
+  // it doesn't hit. normal is the face of target that was hit. boxes that
+  // already overlap are left to the push out and never hit
+  static float sweep(const glm::vec4 &moving, glm::vec2 delta,
+                     const glm::vec4 &target, glm::vec2 &normal);
+
+private:
+  glm::ivec2 cellOf(glm::vec2 point) const;
+  int cornerCell(float x, float y) const;
+  int pairCell(uint32_t a, uint32_t b) const;
+
+  float cellSize;
+  float minCellSize;
+  glm::vec2 origin;
+  int columns;
+  int rows;
+
+  std::vector<glm::vec4> aabbs;
+  glm::vec4 bounds;
+
+  // items sorted by cell, cell n owns cellItems[cellStart[n], cellStart[n+1])
+  std::vector<uint32_t> cellStart;
+  std::vector<uint32_t> cellItems;
+};
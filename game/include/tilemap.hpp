@@ -1,33 +1,123 @@
 #pragma once
+#include "chunk-streamer.hpp"
+#include "level-format.hpp"
+#include "mapped-file.hpp"
+#include "spatial-grid.hpp"
 #include "sprite-batch.hpp"
 #include "texture.hpp"
-#include "tmxlite/Map.hpp"
-#include "tmxlite/TileLayer.hpp"
 #include <SDL2/SDL.h>
 #include <glm/glm.hpp>
 #include <memory>
-#include <set>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+// interned tile class, index into the level's class table
+typedef uint8_t TileClass;
+#define NO_TILE_CLASS 0
+
+// chunks this close to the streaming center (in chunks) have to be resident,
+// Stream() waits for them if the prefetch didn't get them in time
+#define TILEMAP_STREAM_RADIUS 1
+// chunks this close are requested ahead of time
+#define TILEMAP_PREFETCH_RADIUS 2
+// resident chunks further out than the prefetch radius plus this are unloaded
+#define TILEMAP_UNLOAD_SLACK 1
+// memory ceiling, the furthest chunks are unloaded when there are more
+#define TILEMAP_MAX_RESIDENT_CHUNKS 64
+// PinEpoch() value that unloads the chunks right away
+#define TILEMAP_NO_PIN UINT32_MAX
+
+// Tilemap backed by a cooked .level file (see scripts/level_cooker.py). The
+// metadata is mapped up front and the tiles are streamed in chunks around the
+// point passed to Stream(). Chunks that aren't resident are empty, nothing is
+// drawn there and nothing collides with them.
 class Tilemap {
 public:
   std::vector<std::shared_ptr<Texture>> textures;
   Tilemap(const char *path);
   ~Tilemap();
+  // the resident tiles in view
   void Draw(SpriteBatch *spriteBatch);
   void DrawColliders(SpriteBatch *spriteBatch);
-  void IsCollidingWith(SDL_Rect *other, SDL_Rect &found, uint64_t entity,
-                       bool &isGrounded);
 
-  std::vector<tmx::Object> GetObjects();
-  tmx::Object GetObjectByHandle(const int handle);
-  SDL_Rect GetBounds();
+  // makes the chunks around center resident, loaded and unloaded get the
+  // indices of the chunks that came in and went out. main thread only, while
+  // none of the collision queries are running
+  void Stream(glm::vec2 center, std::vector<uint32_t> &loaded,
+              std::vector<uint32_t> &unloaded);
+  // every requested chunk is waited for so the spawns stream in on the same
+  // frame every run, for recording and replaying input. applies to all maps
+  static void SetDeterministicStreaming(bool enabled);
+
+  // Stream() calls are counted as epochs. the queries see the chunks that
+  // were resident after the visible epoch's call, the last one unless a
+  // rollback re-simulates a tick against the epoch it first ran with
+  uint32_t GetStreamEpoch() const;
+  void SetVisibleEpoch(uint32_t epoch);
+  // chunks that went out after epoch are kept for the ticks that ran while
+  // they were in, until a later pin lets them go
+  void PinEpoch(uint32_t epoch);
+
+  // the collision queries are const and safe to call from several threads
+
+  // found is the union of the overlapped solid tiles, isTouching and
+  // isGrounded are only ever set to true
+  void IsCollidingWith(SDL_Rect *other, SDL_Rect &found, bool &isTouching,
+                       bool &isGrounded) const;
+
+  // earliest time of impact in [0, 1] of the aabb (min, max) moving by delta
+  // against the solid tiles, or > 1 if it doesn't hit anything
+  float Sweep(glm::vec4 aabb, glm::vec2 delta, glm::vec2 &normal) const;
+
+  // resolve class names once and compare the returned ids
+  TileClass FindTileClass(std::string_view name);
+  TileClass GetTileClass(int x, int y) const;
+  bool IsSolid(int x, int y) const;
 
-  bool HasCollision(uint64_t entity);
+  std::span<const LevelSpawn> GetSpawns();
+  // the spawns inside a resident chunk, to spawn when it is streamed in
+  std::span<const LevelSpawn> GetChunkSpawns(uint32_t chunk);
+  // returns nullptr if there is no object with the handle
+  const LevelSpawn *GetSpawnByHandle(const uint32_t handle);
+  std::span<const glm::vec2> GetPoints(const LevelSpawn &spawn);
+  std::string_view GetString(const LevelString &string);
+  SDL_Rect GetBounds() const;
 
 private:
-  void initObjects();
-  tmx::Map map;
-  std::vector<tmx::Object> objects;
-  std::set<uint64_t> entitiesCollidingWithMap;
-};
\ No newline at end of file
+  bool load(const char *path);
+  const TilemapChunk *findChunk(int chunkX, int chunkY) const;
+  // the chunk holding the tile, nullptr if it isn't resident
+  const TilemapChunk *chunkOfTile(int x, int y) const;
+  glm::ivec2 chunkOf(glm::vec2 point) const;
+  int chunkDistance(uint32_t chunk, glm::ivec2 center) const;
+  // calls fn(rect) for every resident solid rect overlapping the aabb
+  template <class F> void forEachSolidRect(glm::vec4 aabb, F &&fn) const;
+
+  MappedFile file; // everything before the chunk tiles
+  const LevelHeader *header = nullptr;
+  TileClass solidClass = NO_TILE_CLASS;
+
+  struct ResidentChunk {
+    std::unique_ptr<TilemapChunk> chunk;
+    uint32_t loaded;   // the epoch it came in with
+    uint32_t unloaded; // and went out with, if it did
+  };
+
+  std::unordered_map<uint32_t, ResidentChunk> resident;
+  // went out, but a pinned epoch still sees them
+  std::vector<ResidentChunk> pinned;
+  std::unordered_set<uint32_t> requested; // not resident yet
+  std::vector<std::unique_ptr<TilemapChunk>> arrived;
+
+  uint32_t epoch = 0;
+  uint32_t visibleEpoch = 0;
+  uint32_t pinnedEpoch = TILEMAP_NO_PIN;
+
+  static bool deterministicStreaming;
+
+  // declared last so its worker is stopped before the chunk table goes away
+  ChunkStreamer streamer;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_LEVELS 4
+// deadlines further out than this are parked in the last level and moved
+// closer every time it comes around, 64^4 ticks is ~77 hours at 60hz
+#define TIMER_WHEEL_RANGE                                                      \
+  (uint64_t(1) << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS))
+
+typedef uint32_t TimerHandle;
+#define NO_TIMER 0
+
+struct TimerEntry {
+  uint64_t deadline; // in ticks
+  uint64_t target;   // what the timer is for, usually an entity id
+  TimerHandle handle;
+  uint32_t event;
+};
+
+// Hierarchical timer wheel counting in ticks. Level n has 64 slots of 64^n
+// ticks each, a timer sits in the level its deadline is in and drops down a
+// level each time its slot comes around, so Advance() only touches the slot
+// that is due plus the occasional cascade, never every pending timer.
+// Timers can't be cancelled, the owner keeps the handle and ignores entries
+// whose handle doesn't match anymore.
+class TimerWheel {
+public:
+  TimerWheel();
+
+  // fires delayTicks from now, at least 1
+  TimerHandle Schedule(uint64_t delayTicks, uint64_t target, uint32_t event);
+
+  // moves time forward one tick and appends the entries due on it to due
+  void Advance(std::vector<TimerEntry> &due);
+
+  uint64_t Now() const { return this->now; }
+  size_t Size() const { return this->size; }
+
+private:
+  void insert(const TimerEntry &entry);
+
+  uint64_t now;
+  size_t size;
+  TimerHandle nextHandle;
+  std::vector<TimerEntry> slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  std::vector<TimerEntry> cascading;
+};
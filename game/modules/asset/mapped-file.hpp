@@ -0,0 +1,106 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if !defined(_WIN32) && !defined(EMSCRIPTEN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_USE_MMAP
+#endif
+
+// Read only view of a whole file, or of its first maxLength bytes. Uses mmap
+// where it is available, otherwise the file is read into memory in a single
+// pass.
+class MappedFile {
+public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() { this->close(); }
+
+  bool open(const char *path, size_t maxLength = SIZE_MAX) {
+    this->close();
+#ifdef MAPPED_FILE_USE_MMAP
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open file: %s",
+                   path);
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to stat file: %s",
+                   path);
+      ::close(fd);
+      return false;
+    }
+    const size_t length = std::min(static_cast<size_t>(st.st_size), maxLength);
+    void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference
+    if (mapped == MAP_FAILED) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map file: %s",
+                   path);
+      return false;
+    }
+    this->bytes = static_cast<const uint8_t *>(mapped);
+    this->length = length;
+#else
+    SDL_RWops *rw = SDL_RWFromFile(path, "rb");
+    if (rw == nullptr) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open file: %s",
+                   path);
+      return false;
+    }
+    this->buffer.resize(
+        std::min(static_cast<size_t>(SDL_RWsize(rw)), maxLength));
+    const size_t read = SDL_RWread(rw, this->buffer.data(), 1, buffer.size());
+    SDL_RWclose(rw);
+    if (read != this->buffer.size()) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to read file: %s",
+                   path);
+      this->buffer.clear();
+      return false;
+    }
+    this->bytes = this->buffer.data();
+    this->length = this->buffer.size();
+#endif
+    return true;
+  }
+
+  void close() {
+#ifdef MAPPED_FILE_USE_MMAP
+    if (this->bytes != nullptr) {
+      munmap(const_cast<uint8_t *>(this->bytes), this->length);
+    }
+#else
+    this->buffer.clear();
+#endif
+    this->bytes = nullptr;
+    this->length = 0;
+  }
+
+  const uint8_t *data() const { return this->bytes; }
+  size_t size() const { return this->length; }
+
+  // typed view of the bytes at offset, nullptr if count T don't fit
+  template <class T>
+  const T *at(size_t offset, size_t count = 1) const {
+    if (offset + count * sizeof(T) > this->length) {
+      return nullptr;
+    }
+    return reinterpret_cast<const T *>(this->bytes + offset);
+  }
+
+private:
+  const uint8_t *bytes = nullptr;
+  size_t length = 0;
+#ifndef MAPPED_FILE_USE_MMAP
+  std::vector<uint8_t> buffer;
+#endif
+};
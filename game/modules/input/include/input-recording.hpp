@@ -0,0 +1,81 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define INPUT_RECORDING_MAGIC 0x52495754 // "TWIR"
+#define INPUT_RECORDING_VERSION 1
+
+// frame record flags
+#define INPUT_FRAME_KEYS 0x1
+#define INPUT_FRAME_TEXT 0x2
+// set on a transition's scancode if the key went down
+#define INPUT_KEY_PRESSED 0x8000
+
+// A recording is the header followed by one record per sampled frame:
+//   float frameDelta, seconds
+//   uint8_t flags
+//   INPUT_FRAME_KEYS: uint16_t count, count uint16_t scancode transitions
+//   INPUT_FRAME_TEXT: uint16_t length, the text buffer without terminator
+// a frame where nothing changed is 5 bytes. everything is little endian
+struct InputRecordingHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t seed; // the game's rng seed for the session
+  uint32_t frameCount;
+};
+
+static_assert(sizeof(InputRecordingHeader) == 4 * sizeof(uint32_t));
+
+// one frame of input, as it was sampled from SDL
+struct InputFrame {
+  float frameDelta;
+  const uint8_t *keyState; // SDL_NUM_SCANCODES states
+  const char *text;        // the text input buffer
+};
+
+// Collects the key transitions and text input of a session in memory,
+// Save() writes them out.
+class InputRecorder {
+public:
+  void Begin(uint32_t seed);
+  void Record(float frameDelta, const uint8_t *keyState, int numKeys,
+              const char *text);
+  bool Save(const char *path) const;
+
+  bool IsRecording() const { return this->recording; }
+
+private:
+  bool recording = false;
+  InputRecordingHeader header = {};
+  std::vector<uint8_t> data;
+  uint8_t keys[SDL_NUM_SCANCODES] = {};
+  std::string text;
+};
+
+// Plays a recording back a frame at a time, in place of SDL's keyboard state
+// and the host's text input.
+class InputPlayer {
+public:
+  bool Load(const char *path);
+  // false once every frame has been played
+  bool Next(InputFrame &frame);
+
+  bool IsPlaying() const { return this->playing; }
+  uint32_t GetSeed() const { return this->header.seed; }
+  uint32_t GetFrameCount() const { return this->header.frameCount; }
+  uint32_t GetFramesPlayed() const { return this->frame; }
+
+private:
+  // false if the record runs past the end of the data
+  bool read(void *out, size_t size);
+
+  bool playing = false;
+  InputRecordingHeader header = {};
+  std::vector<uint8_t> data;
+  size_t cursor = 0;
+  uint32_t frame = 0;
+  uint8_t keys[SDL_NUM_SCANCODES] = {};
+  std::string text;
+};
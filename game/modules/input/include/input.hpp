@@ -1,9 +1,10 @@
 #pragma once
 #include <SDL2/SDL.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <glm/glm.hpp>
-#include <map>
 #include <memory>
-#include <mutex>
 
 class InputStates {
 public:
@@ -26,26 +27,87 @@ private:
   Value value;
 };
 
+// game input, bound to keys with InputManager::Bind
+enum InputAction {
+  ACTION_MOVE_LEFT,
+  ACTION_MOVE_RIGHT,
+  ACTION_MOVE_UP,
+  ACTION_MOVE_DOWN,
+  ACTION_JUMP,
+  ACTION_ATTACK,
+  ACTION_FIRE,
+  ACTION_COUNT,
+};
+
+static_assert(ACTION_COUNT <= 32, "actions are stored in a uint32_t");
+
+#define INPUT_KEY_WORDS ((SDL_NUM_SCANCODES + 63) / 64)
+
+// one bit per scancode
+typedef std::array<uint64_t, INPUT_KEY_WORDS> KeyBits;
+
+// The input as of the last Update, never changed once it is published.
+// Grab it once per system run and query it, it doesn't lock.
+struct InputSnapshot {
+  KeyBits down;
+  KeyBits pressed;  // down now, up the update before
+  KeyBits released; // up now, down the update before
+
+  // the bound actions, one bit per InputAction
+  uint32_t actionsDown;
+  uint32_t actionsPressed;
+  uint32_t actionsReleased;
+
+  float axis_horizontal_movement; // -1 left to +1 right
+  float axis_vertical_movement;   // -1 up to +1 down
+  glm::vec2 movement;             // normalized
+
+  // the actions and the movement from the actions held now and the update
+  // before, for the inputs that come as actions instead of keys
+  void SetActions(uint32_t down, uint32_t lastDown);
+
+  InputStates GetKey(SDL_Scancode key) const;
+  bool IsDown(InputAction action) const {
+    return this->actionsDown & (1u << action);
+  }
+  bool IsJustPressed(InputAction action) const {
+    return this->actionsPressed & (1u << action);
+  }
+  bool IsJustReleased(InputAction action) const {
+    return this->actionsReleased & (1u << action);
+  }
+};
+
+// Update builds the next snapshot into the back buffer and publishes it with
+// an atomic swap, the readers never wait. Update, Bind and the text input
+// toggle belong to the main thread and run between ticks, a snapshot stays
+// valid until the second Update after the one that published it.
 class InputManager {
 private:
-  std::map<unsigned int, InputStates> key_map;
-  std::mutex mtx; // thread safety since we are using singleton pattern
+  InputSnapshot snapshots[2] = {};
+  std::atomic<int> front = 0;
 
-  // store game input mapping here
-  float axis_vertical_movement = 0.0f;   // (W || ←) to (S || →)
-  float axis_horizontal_movement = 0.0f; // (A || ↑) to (D || ↓)
+  // keys bound to each action
+  std::array<KeyBits, ACTION_COUNT> bindings = {};
 
-  bool use_text_input = false;
+  std::atomic<bool> use_text_input = false;
 
-  const char *text_input_buffer = "";
+  std::atomic<const char *> text_input_buffer = "";
 
 public:
+  InputManager();
+
   static void Update(const uint8_t *key_state, const int num_keys);
 
-  // useful for debugging, prefer mapping values for actual game input
-  static InputStates GetKey(SDL_Scancode key);
+  // the last published snapshot
+  static const InputSnapshot &GetSnapshot();
+
+  // action also triggers on key, on top of its other bindings
+  static void Bind(InputAction action, SDL_Scancode key);
+  static void ClearBindings(InputAction action);
 
-  // create getters for game input mapping here
+  // useful for debugging, prefer actions for actual game input
+  static InputStates GetKey(SDL_Scancode key);
 
   // returns a normalized vector for movement
   static glm::vec2 GetVectorMovement();
@@ -61,4 +123,4 @@ public:
   static void SetTextInputBuffer(const char *text);
 
   static bool IsTextInputActive();
-};
\ No newline at end of file
+};
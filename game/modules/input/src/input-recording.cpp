@@ -0,0 +1,170 @@
+#include "input-recording.hpp"
+#include <cstring>
+
+template <class T>
+static void append(std::vector<uint8_t> &data, const T &value) {
+  const auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+  data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+void InputRecorder::Begin(uint32_t seed) {
+  this->recording = true;
+  this->header = {INPUT_RECORDING_MAGIC, INPUT_RECORDING_VERSION, seed, 0};
+  this->data.clear();
+  memset(this->keys, 0, sizeof(this->keys));
+  this->text.clear();
+}
+
+void InputRecorder::Record(float frameDelta, const uint8_t *keyState,
+                           int numKeys, const char *text) {
+  if (!this->recording) {
+    return;
+  }
+  append(this->data, frameDelta);
+  const size_t flagsAt = this->data.size();
+  this->data.push_back(0);
+  uint8_t flags = 0;
+
+  // only the keys that changed since the last frame
+  const size_t countAt = this->data.size();
+  uint16_t count = 0;
+  append(this->data, count);
+  for (int i = 0; i < SDL_NUM_SCANCODES; i++) {
+    const uint8_t down = i < numKeys && keyState[i] ? 1 : 0;
+    if (down != this->keys[i]) {
+      this->keys[i] = down;
+      append(this->data,
+             static_cast<uint16_t>(i | (down ? INPUT_KEY_PRESSED : 0)));
+      count++;
+    }
+  }
+  if (count > 0) {
+    flags |= INPUT_FRAME_KEYS;
+    memcpy(&this->data[countAt], &count, sizeof(count));
+  } else {
+    this->data.resize(countAt);
+  }
+
+  // the whole buffer when it changed, backspace removes from it too
+  if (this->text != text) {
+    this->text = text;
+    flags |= INPUT_FRAME_TEXT;
+    append(this->data, static_cast<uint16_t>(this->text.size()));
+    this->data.insert(this->data.end(), this->text.begin(), this->text.end());
+  }
+
+  this->data[flagsAt] = flags;
+  this->header.frameCount++;
+}
+
+bool InputRecorder::Save(const char *path) const {
+  SDL_RWops *file = SDL_RWFromFile(path, "wb");
+  if (file == nullptr) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "Failed to open input recording %s: %s", path, SDL_GetError());
+    return false;
+  }
+  const bool written =
+      SDL_RWwrite(file, &this->header, sizeof(this->header), 1) == 1 &&
+      (this->data.empty() ||
+       SDL_RWwrite(file, this->data.data(), this->data.size(), 1) == 1);
+  SDL_RWclose(file);
+  if (!written) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "Failed to write input recording %s: %s", path,
+                 SDL_GetError());
+    return false;
+  }
+  SDL_Log("Recorded %u frames of input to %s (%zu bytes)",
+          this->header.frameCount, path,
+          sizeof(this->header) + this->data.size());
+  return true;
+}
+
+bool InputPlayer::Load(const char *path) {
+  this->playing = false;
+  SDL_RWops *file = SDL_RWFromFile(path, "rb");
+  if (file == nullptr) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "Failed to open input recording %s: %s", path, SDL_GetError());
+    return false;
+  }
+  const Sint64 size = SDL_RWsize(file);
+  bool valid = size >= static_cast<Sint64>(sizeof(this->header)) &&
+               SDL_RWread(file, &this->header, sizeof(this->header), 1) == 1;
+  if (valid) {
+    this->data.resize(size - sizeof(this->header));
+    valid = this->data.empty() ||
+            SDL_RWread(file, this->data.data(), this->data.size(), 1) == 1;
+  }
+  SDL_RWclose(file);
+  if (!valid || this->header.magic != INPUT_RECORDING_MAGIC ||
+      this->header.version != INPUT_RECORDING_VERSION) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "%s is not a version %d input recording", path,
+                 INPUT_RECORDING_VERSION);
+    return false;
+  }
+
+  this->cursor = 0;
+  this->frame = 0;
+  memset(this->keys, 0, sizeof(this->keys));
+  this->text.clear();
+  this->playing = true;
+  return true;
+}
+
+bool InputPlayer::read(void *out, size_t size) {
+  if (this->cursor + size > this->data.size()) {
+    return false;
+  }
+  memcpy(out, &this->data[this->cursor], size);
+  this->cursor += size;
+  return true;
+}
+
+bool InputPlayer::Next(InputFrame &frame) {
+  if (!this->playing || this->frame >= this->header.frameCount) {
+    this->playing = false;
+    return false;
+  }
+
+  uint8_t flags = 0;
+  bool valid = this->read(&frame.frameDelta, sizeof(frame.frameDelta)) &&
+               this->read(&flags, sizeof(flags));
+  if (valid && (flags & INPUT_FRAME_KEYS)) {
+    uint16_t count = 0;
+    valid = this->read(&count, sizeof(count));
+    for (uint16_t i = 0; valid && i < count; i++) {
+      uint16_t transition = 0;
+      valid = this->read(&transition, sizeof(transition));
+      const uint16_t scancode = transition & ~INPUT_KEY_PRESSED;
+      valid = valid && scancode < SDL_NUM_SCANCODES;
+      if (valid) {
+        this->keys[scancode] = transition & INPUT_KEY_PRESSED ? 1 : 0;
+      }
+    }
+  }
+  if (valid && (flags & INPUT_FRAME_TEXT)) {
+    uint16_t length = 0;
+    valid = this->read(&length, sizeof(length)) &&
+            this->cursor + length <= this->data.size();
+    if (valid) {
+      const auto *text =
+          reinterpret_cast<const char *>(&this->data[this->cursor]);
+      this->text.assign(text, length);
+      this->cursor += length;
+    }
+  }
+  if (!valid) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "Input recording is truncated at frame %u", this->frame);
+    this->playing = false;
+    return false;
+  }
+
+  frame.keyState = this->keys;
+  frame.text = this->text.c_str();
+  this->frame++;
+  return true;
+}
@@ -3,87 +3,135 @@
 static std::unique_ptr<InputManager> instance =
     std::make_unique<InputManager>();
 
-void InputManager::Update(const uint8_t *key_state, const int num_keys) {
-  std::lock_guard<std::mutex> lock(instance->mtx); // thread safety
-
-  for (int i = 0; i < num_keys; i++) {
-
-    // ignore other input if text input is active
-    if (instance->use_text_input && i != SDL_SCANCODE_RETURN) {
-      continue;
-    }
+static void setKeyBit(KeyBits &bits, SDL_Scancode key) {
+  bits[key / 64] |= 1ull << (key % 64);
+}
 
-    // set released, pressed, just_released, just_pressed
-    if (key_state[i]) {
-      if (instance->key_map[i] == InputStates::RELEASED) {
-        instance->key_map[i] = InputStates::JUST_PRESSED;
-      } else {
-        instance->key_map[i] = InputStates::HELD;
-      }
-    } else {
-      if (instance->key_map[i] == InputStates::HELD) {
-        instance->key_map[i] = InputStates::JUST_RELEASED;
-      } else {
-        instance->key_map[i] = InputStates::RELEASED;
-      }
-    }
+InputManager::InputManager() {
+  // default game input mapping
+  const struct {
+    InputAction action;
+    SDL_Scancode key;
+  } defaults[] = {
+      {ACTION_MOVE_LEFT, SDL_SCANCODE_LEFT},
+      {ACTION_MOVE_LEFT, SDL_SCANCODE_A},
+      {ACTION_MOVE_RIGHT, SDL_SCANCODE_RIGHT},
+      {ACTION_MOVE_RIGHT, SDL_SCANCODE_D},
+      {ACTION_MOVE_UP, SDL_SCANCODE_UP},
+      {ACTION_MOVE_UP, SDL_SCANCODE_W},
+      {ACTION_MOVE_DOWN, SDL_SCANCODE_DOWN},
+      {ACTION_MOVE_DOWN, SDL_SCANCODE_S},
+      {ACTION_JUMP, SDL_SCANCODE_SPACE},
+      {ACTION_JUMP, SDL_SCANCODE_LALT},
+      {ACTION_ATTACK, SDL_SCANCODE_LCTRL},
+      {ACTION_FIRE, SDL_SCANCODE_Z},
+  };
+  for (const auto &binding : defaults) {
+    setKeyBit(this->bindings[binding.action], binding.key);
   }
+}
 
-  // update axis values
+void InputSnapshot::SetActions(uint32_t down, uint32_t lastDown) {
+  this->actionsDown = down;
+  this->actionsPressed = down & ~lastDown;
+  this->actionsReleased = lastDown & ~down;
 
-  // horizontal
-  // +1 = ARROW_RIGHT OR D
-  // -1 = ARROW_LEFT OR A
-  instance->axis_horizontal_movement = 0.0f;
-  instance->axis_vertical_movement = 0.0f;
+  // update axis values
+  this->axis_horizontal_movement =
+      static_cast<float>(this->IsDown(ACTION_MOVE_RIGHT)) -
+      static_cast<float>(this->IsDown(ACTION_MOVE_LEFT));
+  this->axis_vertical_movement =
+      static_cast<float>(this->IsDown(ACTION_MOVE_DOWN)) -
+      static_cast<float>(this->IsDown(ACTION_MOVE_UP));
+  const glm::vec2 movement =
+      glm::vec2(this->axis_horizontal_movement, this->axis_vertical_movement);
+  this->movement =
+      glm::length(movement) == 0 ? movement : glm::normalize(movement);
+}
 
-  if (instance->key_map[SDL_SCANCODE_RIGHT].IsDown() ||
-      instance->key_map[SDL_SCANCODE_D].IsDown()) {
-    instance->axis_horizontal_movement += 1.0f;
+InputStates InputSnapshot::GetKey(SDL_Scancode key) const {
+  const int word = key / 64;
+  const uint64_t bit = 1ull << (key % 64);
+  if (this->pressed[word] & bit) {
+    return InputStates::JUST_PRESSED;
+  }
+  if (this->down[word] & bit) {
+    return InputStates::HELD;
   }
-  if (instance->key_map[SDL_SCANCODE_LEFT].IsDown() ||
-      instance->key_map[SDL_SCANCODE_A].IsDown()) {
-    instance->axis_horizontal_movement -= 1.0f;
+  if (this->released[word] & bit) {
+    return InputStates::JUST_RELEASED;
   }
+  return InputStates::RELEASED;
+}
 
-  // vertical
-  // +1 = ARROW_UP OR W
-  // -1 = ARROW_DOWN OR S
-  if (instance->key_map[SDL_SCANCODE_UP].IsDown() ||
-      instance->key_map[SDL_SCANCODE_W].IsDown()) {
-    instance->axis_vertical_movement -= 1.0f;
+void InputManager::Update(const uint8_t *key_state, const int num_keys) {
+  const int back = 1 - instance->front.load(std::memory_order_relaxed);
+  const InputSnapshot &last = instance->snapshots[1 - back];
+  InputSnapshot &next = instance->snapshots[back];
+
+  // pack the key states into bits
+  KeyBits sampled = {};
+  const int count = glm::min(num_keys, static_cast<int>(SDL_NUM_SCANCODES));
+  for (int i = 0; i < count; i++) {
+    sampled[i / 64] |= static_cast<uint64_t>(key_state[i] != 0) << (i % 64);
   }
-  if (instance->key_map[SDL_SCANCODE_DOWN].IsDown() ||
-      instance->key_map[SDL_SCANCODE_S].IsDown()) {
-    instance->axis_vertical_movement += 1.0f;
+
+  // ignore other input if text input is active, those keys keep their state
+  const bool text = instance->use_text_input.load(std::memory_order_relaxed);
+  for (int w = 0; w < INPUT_KEY_WORDS; w++) {
+    uint64_t live = ~0ull;
+    if (text) {
+      live = w == SDL_SCANCODE_RETURN / 64
+                 ? 1ull << (SDL_SCANCODE_RETURN % 64)
+                 : 0;
+    }
+    next.down[w] = (sampled[w] & live) | (last.down[w] & ~live);
+    next.pressed[w] = next.down[w] & ~last.down[w];
+    next.released[w] = last.down[w] & ~next.down[w];
+  }
+
+  // resolve the bindings once, the queries only test a bit
+  uint32_t actions = 0;
+  for (int a = 0; a < ACTION_COUNT; a++) {
+    uint64_t bound = 0;
+    for (int w = 0; w < INPUT_KEY_WORDS; w++) {
+      bound |= next.down[w] & instance->bindings[a][w];
+    }
+    actions |= static_cast<uint32_t>(bound != 0) << a;
   }
+  next.SetActions(actions, last.actionsDown);
+
+  // publish, the readers see all of the above or the previous snapshot
+  instance->front.store(back, std::memory_order_release);
 }
 
-InputStates InputManager::GetKey(SDL_Scancode key) {
-  std::lock_guard<std::mutex> lock(instance->mtx); // thread safety
-  return instance->key_map[key];
+const InputSnapshot &InputManager::GetSnapshot() {
+  return instance->snapshots[instance->front.load(std::memory_order_acquire)];
 }
 
-glm::vec2 InputManager::GetVectorMovement() {
-  std::lock_guard<std::mutex> lock(instance->mtx); // thread safety
-  glm::vec2 movement = glm::vec2(instance->axis_horizontal_movement,
-                                 instance->axis_vertical_movement);
-  return glm::length(movement) == 0 ? movement : glm::normalize(movement);
+void InputManager::Bind(InputAction action, SDL_Scancode key) {
+  setKeyBit(instance->bindings[action], key);
 }
 
+void InputManager::ClearBindings(InputAction action) {
+  instance->bindings[action] = {};
+}
+
+InputStates InputManager::GetKey(SDL_Scancode key) {
+  return GetSnapshot().GetKey(key);
+}
+
+glm::vec2 InputManager::GetVectorMovement() { return GetSnapshot().movement; }
+
 float InputManager::GetAxisHorizontalMovement() {
-  std::lock_guard<std::mutex> lock(instance->mtx); // thread safety
-  return instance->axis_horizontal_movement;
+  return GetSnapshot().axis_horizontal_movement;
 }
 
 bool InputManager::GetTriggerJump() {
-  std::lock_guard<std::mutex> lock(instance->mtx); // thread safety
-  return instance->key_map[SDL_SCANCODE_SPACE].IsJustPressed() ||
-         instance->key_map[SDL_SCANCODE_LALT].IsJustPressed();
+  return GetSnapshot().IsJustPressed(ACTION_JUMP);
 }
 
 void InputManager::ToggleTextInput() {
-  std::lock_guard<std::mutex> lock(instance->mtx); // thread safety
   if (instance->use_text_input) {
     SDL_StopTextInput();
   } else {
@@ -93,16 +141,11 @@ void InputManager::ToggleTextInput() {
 }
 
 const char *InputManager::GetTextInputBuffer() {
-  std::lock_guard<std::mutex> lock(instance->mtx); // thread safety
   return instance->text_input_buffer;
 }
 
 void InputManager::SetTextInputBuffer(const char *text) {
-  std::lock_guard<std::mutex> lock(instance->mtx); // thread safety
   instance->text_input_buffer = text;
 }
 
-bool InputManager::IsTextInputActive() {
-  std::lock_guard<std::mutex> lock(instance->mtx); // thread safety
-  return instance->use_text_input;
-}
+bool InputManager::IsTextInputActive() { return instance->use_text_input; }
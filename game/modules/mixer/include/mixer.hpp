@@ -1,13 +1,29 @@
 #pragma once
+#include "music-stream.hpp"
+#include "soft-mixer.hpp"
+#include "voice-pool.hpp"
 #include <SDL.h>
 #include <SDL_mixer.h>
 #include <memory>
+#include <string>
 
-#define MAX_SOUND_CHANNELS 8
+#define DEFAULT_MIXER_FREQUENCY 44100
+// frames per audio callback, smaller is lower latency and more callbacks
+#define DEFAULT_MIXER_BUFFER_FRAMES 1024
+
+struct MixerSettings {
+  int frequency;
+  int bufferFrames;
+  // mix the sound effects with the SoftMixer instead of SDL_mixer channels
+  bool softMixer;
+  // the web build always plays the music through SDL_mixer
+  MusicBackend music = MusicBackend::Streams;
+};
 
 class Mixer {
 public:
-  Mixer();
+  Mixer(const MixerSettings &settings = {DEFAULT_MIXER_FREQUENCY,
+                                         DEFAULT_MIXER_BUFFER_FRAMES, false});
   ~Mixer();
 
   void ToggleMute();
@@ -16,15 +32,19 @@ private:
   bool isMuted = false;
 };
 
+// streamed by the MusicPlayer, only the web build and the SdlMixer backend
+// load it through SDL_mixer
 class Music {
 public:
   Music(const char *path);
   ~Music();
 
+  // crossfades from the music playing, if it isn't this already
   void play_on_loop();
 
 private:
-  Mix_Music *sdl_music;
+  std::string path;
+  Mix_Music *sdl_music = nullptr;
 };
 
 class SoundEffect {
@@ -32,8 +52,16 @@ public:
   SoundEffect(const char *path);
   ~SoundEffect();
 
+  // both go through the VoicePool and can be dropped
   void play();
+  // at a world position, culled and attenuated by the distance to the
+  // listener
+  void playAt(float x, float y);
+
+  SoundSettings settings;
 
 private:
   Mix_Chunk *sdl_chunk;
+  // decoded for the SoftMixer, if it was open when this was loaded
+  std::unique_ptr<PcmClip> pcm;
 };
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// how far ahead of the audio thread the music is decoded
+#define MUSIC_BUFFER_MS 250
+// source frames decoded at a time
+#define MUSIC_DECODE_FRAMES 4096
+// frames the music hook mixes at a time, larger callbacks are split
+#define MUSIC_MIX_FRAMES 1024
+// tracks playing at once, the current one and those fading out
+#define MUSIC_MAX_STREAMS 4
+#define MUSIC_CROSSFADE_SECONDS 1.0f
+
+struct MusicCallbackStats {
+  float maxMs; // the slowest music callback
+  float meanMs;
+  uint32_t callbacks;
+  uint32_t underruns; // callbacks the decoder was behind for
+};
+
+// the music the MusicPlayer plays it through
+enum class MusicBackend {
+  Streams,
+  // Mix_PlayMusic, SDL_mixer decodes on the audio thread. kept to compare
+  // the callback times against
+  SdlMixer,
+};
+
+// One ogg track decoded by its own worker thread into a lock-free ring, the
+// audio thread only copies out of it. The worker opens the file too, so
+// starting a track doesn't block the caller. The track loops gaplessly
+// between the LOOPSTART and LOOPLENGTH or LOOPEND comments, or over the whole
+// file, resampled to the device frequency if it differs.
+class MusicStream {
+public:
+  MusicStream(const std::string &path, int frequency);
+  MusicStream(const MusicStream &) = delete;
+  MusicStream &operator=(const MusicStream &) = delete;
+  ~MusicStream();
+
+  const std::string &GetPath() const { return this->path; }
+
+  // game thread, gain ramps linearly to target over seconds
+  void FadeTo(float target, float seconds);
+  // faded out, it can be dropped
+  bool IsSilent() const { return this->silent.load(); }
+
+  // audio thread. adds up to frames frames into out, interleaved stereo,
+  // false if the decoder couldn't keep up
+  bool Mix(float *out, int frames);
+
+private:
+  void run();
+  bool open();
+  // decodes a block into the ring, false at the end of the track
+  bool decode();
+  void write(const float *frames, int count);
+
+  std::string path;
+  int frequency;
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool quit = false;
+
+  // worker
+  struct Decoder;
+  std::unique_ptr<Decoder> decoder;
+
+  // interleaved stereo, capacity is a power of two in frames
+  std::vector<float> ring;
+  uint32_t capacity;
+  std::atomic<uint32_t> readIndex = 0;  // audio thread
+  std::atomic<uint32_t> writeIndex = 0; // worker
+  std::atomic<bool> ended = false;      // the worker won't write any more
+
+  // fading, set by the game thread and run by the audio thread
+  std::atomic<float> fadeTarget = 1.0f;
+  std::atomic<float> fadeStep = 1.0f; // per frame
+  float gain = 0.0f;                  // audio thread
+  bool primed = false;                // audio thread, half the ring was filled
+  std::atomic<bool> silent = false;
+};
+
+// Plays MusicStreams in place of SDL_mixer's music through Mix_HookMusic.
+// Switching tracks crossfades, the old stream is dropped once it is silent.
+// Game thread only, except for the hook.
+//
+// With the SdlMixer backend it plays a Mix_Music instead, with the callbacks
+// counted from Mix_SetPostMix. SDL_mixer has no hook before it mixes its
+// music, so those are timed by the cpu time the audio thread spent since the
+// last post mix.
+class MusicPlayer {
+public:
+  MusicPlayer();
+
+  // for the music started after this
+  static void SetBackend(MusicBackend backend);
+  static MusicBackend GetBackend();
+
+  // starts path, fading from the current track. does nothing if path is
+  // already playing
+  static void Play(const std::string &path,
+                   float fadeSeconds = MUSIC_CROSSFADE_SECONDS);
+  // loops music with the SdlMixer backend, cut instead of crossfaded
+  static void PlaySdl(Mix_Music *music);
+  static void Stop(float fadeSeconds = MUSIC_CROSSFADE_SECONDS);
+  // unhooks and drops every stream
+  static void Close();
+  // 0 mutes
+  static void SetVolume(float volume);
+
+  static MusicCallbackStats GetCallbackStats();
+
+private:
+  static void hook(void *udata, Uint8 *stream, int len);
+  static void postMix(void *udata, Uint8 *stream, int len);
+  // audio thread
+  void countCallback(uint64_t ticks, bool starved);
+  void resetCallbackStats();
+  // frees the faded out streams, waiting for the hook to let go of them
+  void dropSilent();
+  // hands the streams to the hook
+  void publish();
+
+  std::unique_ptr<MusicStream> current;
+  std::vector<std::unique_ptr<MusicStream>> fading;
+  bool hooked = false;
+  bool postMixed = false;
+  MusicBackend backend = MusicBackend::Streams;
+  int frequency = 0;
+
+  // read by the hook
+  std::atomic<MusicStream *> streams[MUSIC_MAX_STREAMS] = {};
+  std::atomic<float> volume = 1.0f;
+  std::vector<float> scratch;
+
+  // written by the hook
+  std::atomic<uint64_t> callbackTicks = 0; // performance counter
+  std::atomic<uint64_t> maxCallbackTicks = 0;
+  std::atomic<uint32_t> callbacks = 0;
+  std::atomic<uint32_t> underruns = 0;
+  uint64_t lastPostMix = 0; // the audio thread's cpu time, 0 before any
+};
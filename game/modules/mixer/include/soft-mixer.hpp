@@ -0,0 +1,100 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// voices, mixed here or on SDL_mixer's channels
+#define MAX_SOUND_CHANNELS 8
+// commands the game can queue between two audio callbacks
+#define SOFT_MIXER_QUEUE_SIZE 256
+
+// a sound effect decoded up front, interleaved stereo float at the device
+// frequency
+struct PcmClip {
+  std::vector<float> samples;
+  int frames;
+
+  // converts a chunk loaded by SDL_mixer, which is in the device format.
+  // nullptr if that isn't 16 bit stereo
+  static std::unique_ptr<PcmClip> FromChunk(const Mix_Chunk *chunk);
+};
+
+// adds frames of in, scaled by the left and right gains, into out. both are
+// interleaved stereo
+void MixStereo(float *out, const float *in, int frames, float left,
+               float right);
+
+// In-house sound effect mixing. SDL_mixer still owns the device, decodes the
+// clips and plays the music, the voices are mixed into its output from its
+// post mix hook on the audio thread. The game thread talks to the mixer
+// through a lock-free command queue and reads back per-voice generation
+// counters, it only takes the audio lock to Release a clip.
+class SoftMixer {
+public:
+  // mix buffers are at most bufferFrames long, larger requests are split
+  SoftMixer(int bufferFrames);
+  SoftMixer(const SoftMixer &) = delete;
+  SoftMixer &operator=(const SoftMixer &) = delete;
+
+  // hooks a mixer into the device SDL_mixer opened, false if the device
+  // format isn't 16 bit stereo
+  static bool Open(int bufferFrames);
+  static void Close();
+  // the hooked mixer, nullptr when the voices go through SDL_mixer channels
+  static SoftMixer *Get();
+
+  // game thread. volume is 0 to 1, pan is -1 left to +1 right
+  bool Play(int voice, const PcmClip *clip, float volume, float pan);
+  void Stop(int voice);
+  void SetVolume(int voice, float volume, float pan);
+  bool IsPlaying(int voice) const;
+  // stops every voice playing clip, it can be freed once this returns
+  void Release(const PcmClip *clip);
+
+  // audio thread. adds the playing voices into out, interleaved stereo
+  void Mix(float *out, int frames);
+
+private:
+  enum CommandType { COMMAND_PLAY, COMMAND_STOP, COMMAND_VOLUME };
+
+  struct Command {
+    CommandType type;
+    int voice;
+    const PcmClip *clip;
+    float left;
+    float right;
+    uint32_t generation;
+  };
+
+  struct Voice {
+    const PcmClip *clip; // nullptr when idle
+    int position;        // in frames
+    float left;
+    float right;
+    uint32_t generation;
+  };
+
+  static void postMix(void *udata, Uint8 *stream, int len);
+  bool push(const Command &command);
+  void applyCommands();
+  void finish(int voice);
+
+  // written by the game thread, read by the audio thread
+  Command queue[SOFT_MIXER_QUEUE_SIZE];
+  std::atomic<uint32_t> head = 0; // next to read, audio thread
+  std::atomic<uint32_t> tail = 0; // next to write, game thread
+
+  // audio thread
+  Voice voices[MAX_SOUND_CHANNELS] = {};
+  std::vector<float> scratch;
+  int bufferFrames;
+
+  // a voice is playing from when the game starts a generation until the
+  // audio thread finishes it or the game stops it
+  uint32_t started[MAX_SOUND_CHANNELS] = {};
+  uint32_t stopped[MAX_SOUND_CHANNELS] = {};
+  std::atomic<uint32_t> finished[MAX_SOUND_CHANNELS] = {};
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include "soft-mixer.hpp"
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <memory>
+#include <unordered_map>
+
+// positional sounds further than this from the listener aren't played
+#define VOICE_CULL_DISTANCE 1200.0f
+// positional sounds this far to the side are panned all the way, only the
+// SoftMixer pans
+#define VOICE_PAN_DISTANCE 600.0f
+
+enum SoundPriority {
+  SOUND_PRIORITY_LOW,    // ambience, first to be stolen
+  SOUND_PRIORITY_NORMAL, // most effects
+  SOUND_PRIORITY_HIGH,   // player feedback
+};
+
+// which voice of the lowest priority is stolen when they are all busy
+enum VoiceStealPolicy {
+  STEAL_OLDEST,
+  STEAL_QUIETEST,
+};
+
+// how a clip competes for voices
+struct SoundSettings {
+  SoundPriority priority = SOUND_PRIORITY_NORMAL;
+  float volume = 1.0f;
+  int maxInstances = 4; // playing at the same time
+  // starts past maxPerWindow within windowMs are dropped, 1 dedupes
+  int maxPerWindow = 1;
+  uint32_t windowMs = 50;
+};
+
+struct VoiceStats {
+  uint32_t played;
+  uint32_t stolen;  // played by cutting off another voice
+  uint32_t culled;  // too far from the listener
+  uint32_t limited; // over the clip's instance or rate limit
+  uint32_t dropped; // every voice was busy with something more important
+};
+
+// Hands out the MAX_SOUND_CHANNELS voices, on the SoftMixer when it is open
+// and on SDL_mixer's channels otherwise. A sound that finds every channel
+// busy steals one of a lower or equal priority, picked by the steal policy,
+// or is dropped. Identical clips are rate limited and positional sounds are
+// culled and attenuated by their distance to the listener. Main thread only.
+class VoicePool {
+private:
+  struct Voice {
+    Mix_Chunk *chunk;
+    SoundPriority priority;
+    float volume; // after attenuation, without the master volume
+    float pan;
+    uint32_t started;
+  };
+
+  struct ClipState {
+    uint32_t windowStart;
+    int startsInWindow;
+  };
+
+  Voice voices[MAX_SOUND_CHANNELS] = {};
+  std::unordered_map<Mix_Chunk *, ClipState> clips;
+  VoiceStealPolicy policy = STEAL_OLDEST;
+  float listenerX = 0.0f;
+  float listenerY = 0.0f;
+  float masterVolume = 1.0f;
+  VoiceStats stats = {};
+
+  // the channel to play on, -1 to drop the sound
+  int findChannel(SoundPriority priority);
+
+public:
+  // returns the channel, -1 if the sound wasn't played. pcm is the chunk
+  // decoded for the SoftMixer, it may be nullptr when that isn't open
+  static int Play(Mix_Chunk *chunk, const PcmClip *pcm,
+                  const SoundSettings &settings, float pan = 0.0f);
+  static int PlayAt(Mix_Chunk *chunk, const PcmClip *pcm,
+                    const SoundSettings &settings, float x, float y);
+
+  static void SetListener(float x, float y);
+  static void SetStealPolicy(VoiceStealPolicy policy);
+  // applied to every voice, 0 mutes
+  static void SetMasterVolume(float volume);
+
+  static VoiceStats GetStats();
+  // voices playing right now
+  static int GetActiveVoices();
+};
@@ -1,15 +1,26 @@
 #include "mixer.hpp"
 
-Mixer::Mixer() {
-  // frequency of 44100 (CD quality), the default format, 2 channels (stereo)
-  if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 1024) == -1) {
+Mixer::Mixer(const MixerSettings &settings) {
+  // the default format, 2 channels (stereo)
+  if (Mix_OpenAudio(settings.frequency, MIX_DEFAULT_FORMAT, 2,
+                    settings.bufferFrames) == -1) {
     SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Couldn't initialize SDL Mixer\n");
     return;
   }
   Mix_AllocateChannels(MAX_SOUND_CHANNELS);
+  if (settings.softMixer) {
+    SoftMixer::Open(settings.bufferFrames);
+  }
+#ifndef EMSCRIPTEN
+  MusicPlayer::SetBackend(settings.music);
+#endif
 }
 
 Mixer::~Mixer() {
+#ifndef EMSCRIPTEN
+  MusicPlayer::Close();
+#endif
+  SoftMixer::Close();
   Mix_CloseAudio();
   Mix_Quit();
   SDL_Log("Mixer closed\n");
@@ -18,17 +29,30 @@ Mixer::~Mixer() {
 void Mixer::ToggleMute() {
   SDL_Log("Toggle Mute\n");
   if (!this->isMuted) {
+#ifdef EMSCRIPTEN
     Mix_VolumeMusic(0);
-    Mix_Volume(-1, 0);
+#else
+    MusicPlayer::SetVolume(0.0f);
+#endif
+    VoicePool::SetMasterVolume(0.0f);
     this->isMuted = true;
   } else {
+#ifdef EMSCRIPTEN
     Mix_VolumeMusic(MIX_MAX_VOLUME);
-    Mix_Volume(-1, MIX_MAX_VOLUME);
+#else
+    MusicPlayer::SetVolume(1.0f);
+#endif
+    VoicePool::SetMasterVolume(1.0f);
     this->isMuted = false;
   }
 }
 
-Music::Music(const char *path) {
+Music::Music(const char *path) : path(path) {
+#ifndef EMSCRIPTEN
+  if (MusicPlayer::GetBackend() == MusicBackend::Streams) {
+    return;
+  }
+#endif
   this->sdl_music = Mix_LoadMUS(path);
 
   if (this->sdl_music == nullptr) {
@@ -40,15 +64,26 @@ Music::Music(const char *path) {
 Music::~Music() {
   if (this->sdl_music != nullptr) {
     Mix_FreeMusic(this->sdl_music);
-    SDL_Log("Music closed\n");
   }
+  SDL_Log("Music closed\n");
 }
 
 void Music::play_on_loop() {
+#ifdef EMSCRIPTEN
   if (Mix_PlayMusic(this->sdl_music, -1) == -1) {
     SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to play music: %s\n",
                  Mix_GetError());
   }
+#else
+  if (MusicPlayer::GetBackend() == MusicBackend::SdlMixer) {
+    if (this->sdl_music != nullptr) {
+      MusicPlayer::PlaySdl(this->sdl_music);
+    }
+    return;
+  }
+  // decoded on the stream's worker, never on the audio thread
+  MusicPlayer::Play(this->path);
+#endif
 }
 
 SoundEffect::SoundEffect(const char *path) {
@@ -58,10 +93,15 @@ SoundEffect::SoundEffect(const char *path) {
   if (this->sdl_chunk == nullptr) {
     SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to load sound effect: %s\n",
                  Mix_GetError());
+  } else if (SoftMixer::Get() != nullptr) {
+    this->pcm = PcmClip::FromChunk(this->sdl_chunk);
   }
 }
 
 SoundEffect::~SoundEffect() {
+  if (this->pcm != nullptr && SoftMixer::Get() != nullptr) {
+    SoftMixer::Get()->Release(this->pcm.get());
+  }
   if (this->sdl_chunk != nullptr) {
     Mix_FreeChunk(this->sdl_chunk);
     SDL_Log("Sound effect closed\n");
@@ -69,8 +109,14 @@ SoundEffect::~SoundEffect() {
 }
 
 void SoundEffect::play() {
-  if (Mix_PlayChannel(-1, this->sdl_chunk, 0) == -1) {
-    SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to play sound effect: %s\n",
-                 Mix_GetError());
+  if (this->sdl_chunk != nullptr) {
+    VoicePool::Play(this->sdl_chunk, this->pcm.get(), this->settings);
+  }
+}
+
+void SoundEffect::playAt(float x, float y) {
+  if (this->sdl_chunk != nullptr) {
+    VoicePool::PlayAt(this->sdl_chunk, this->pcm.get(), this->settings, x,
+                      y);
   }
 }
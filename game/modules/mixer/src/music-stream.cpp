@@ -0,0 +1,502 @@
+#ifndef EMSCRIPTEN
+#include "music-stream.hpp"
+#include <algorithm>
+#include <chrono>
+#include <vorbis/vorbisfile.h>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static std::unique_ptr<MusicPlayer> instance = std::make_unique<MusicPlayer>();
+
+// the music decodes from SDL_RWops, the same files SDL_mixer reads
+static size_t rwRead(void *ptr, size_t size, size_t count, void *source) {
+  return SDL_RWread(static_cast<SDL_RWops *>(source), ptr, size, count);
+}
+
+static int rwSeek(void *source, ogg_int64_t offset, int whence) {
+  return SDL_RWseek(static_cast<SDL_RWops *>(source), offset, whence) < 0
+             ? -1
+             : 0;
+}
+
+static int rwClose(void *source) {
+  return SDL_RWclose(static_cast<SDL_RWops *>(source));
+}
+
+static long rwTell(void *source) {
+  return static_cast<long>(SDL_RWtell(static_cast<SDL_RWops *>(source)));
+}
+
+// the cpu time of the calling thread in performance counter ticks, it
+// doesn't count while the thread waits on the device
+static uint64_t threadTicks() {
+#ifdef _WIN32
+  FILETIME creation, exited, kernel, user;
+  GetThreadTimes(GetCurrentThread(), &creation, &exited, &kernel, &user);
+  const double seconds =
+      ((static_cast<uint64_t>(kernel.dwHighDateTime) << 32 |
+        kernel.dwLowDateTime) +
+       (static_cast<uint64_t>(user.dwHighDateTime) << 32 |
+        user.dwLowDateTime)) /
+      1e7;
+#else
+  timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  const double seconds = now.tv_sec + now.tv_nsec / 1e9;
+#endif
+  return static_cast<uint64_t>(seconds * SDL_GetPerformanceFrequency());
+}
+
+// a loop point in source frames from the vorbis comments, -1 if missing
+static ogg_int64_t loopTag(vorbis_comment *comment, const char *tag) {
+  const char *value = vorbis_comment_query(comment, tag, 0);
+  return value != nullptr ? SDL_strtoll(value, nullptr, 10) : -1;
+}
+
+struct MusicStream::Decoder {
+  OggVorbis_File file;
+  bool opened = false;
+  int channels;
+  ogg_int64_t loopStart;
+  ogg_int64_t loopEnd;
+
+  // linear resampling, step is source frames per output frame. phase is the
+  // position between last and the next source frame
+  double step;
+  double phase = 0.0;
+  float last[2] = {};
+
+  std::vector<float> stereo;
+  std::vector<float> resampled;
+
+  ~Decoder() {
+    if (this->opened) {
+      ov_clear(&this->file);
+    }
+  }
+};
+
+MusicStream::MusicStream(const std::string &path, int frequency)
+    : path(path), frequency(frequency),
+      decoder(std::make_unique<Decoder>()) {
+  // a power of two that holds the latency target and a couple of blocks
+  const uint32_t target = std::max(MUSIC_BUFFER_MS * frequency / 1000,
+                                   2 * MUSIC_DECODE_FRAMES);
+  this->capacity = 1;
+  while (this->capacity < target) {
+    this->capacity <<= 1;
+  }
+  this->ring.resize(this->capacity * 2);
+  this->worker = std::thread(&MusicStream::run, this);
+}
+
+MusicStream::~MusicStream() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->quit = true;
+  }
+  this->wake.notify_one();
+  this->worker.join();
+}
+
+void MusicStream::FadeTo(float target, float seconds) {
+  const float step =
+      seconds > 0.0f ? 1.0f / (seconds * this->frequency) : 1.0f;
+  this->fadeStep.store(step, std::memory_order_relaxed);
+  this->fadeTarget.store(target, std::memory_order_relaxed);
+}
+
+bool MusicStream::open() {
+  SDL_RWops *source = SDL_RWFromFile(this->path.c_str(), "rb");
+  if (source == nullptr) {
+    SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to open music %s: %s\n",
+                 this->path.c_str(), SDL_GetError());
+    return false;
+  }
+  Decoder &decoder = *this->decoder;
+  const ov_callbacks callbacks = {rwRead, rwSeek, rwClose, rwTell};
+  if (ov_open_callbacks(source, &decoder.file, nullptr, 0, callbacks) != 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to decode music %s\n",
+                 this->path.c_str());
+    SDL_RWclose(source);
+    return false;
+  }
+  decoder.opened = true;
+
+  const vorbis_info *info = ov_info(&decoder.file, -1);
+  decoder.channels = info->channels;
+  decoder.step = static_cast<double>(info->rate) / this->frequency;
+
+  // LOOPSTART with LOOPLENGTH or LOOPEND, as RPG Maker tags them
+  const ogg_int64_t total = ov_pcm_total(&decoder.file, -1);
+  if (total <= 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Music %s is empty\n",
+                 this->path.c_str());
+    return false;
+  }
+  vorbis_comment *comment = ov_comment(&decoder.file, -1);
+  const ogg_int64_t start = loopTag(comment, "LOOPSTART");
+  const ogg_int64_t length = loopTag(comment, "LOOPLENGTH");
+  ogg_int64_t end = loopTag(comment, "LOOPEND");
+  if (length > 0 && start >= 0) {
+    end = start + length;
+  }
+  decoder.loopStart = std::clamp<ogg_int64_t>(start, 0, total);
+  decoder.loopEnd = end > decoder.loopStart && end <= total ? end : total;
+
+  decoder.stereo.resize(MUSIC_DECODE_FRAMES * 2);
+  decoder.resampled.resize((MUSIC_DECODE_FRAMES / decoder.step + 2) * 2);
+  return true;
+}
+
+void MusicStream::run() {
+  if (this->open()) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (!this->quit) {
+      const uint32_t used =
+          this->writeIndex.load(std::memory_order_relaxed) -
+          this->readIndex.load(std::memory_order_acquire);
+      if (this->capacity - used >= MUSIC_DECODE_FRAMES / 2) {
+        lock.unlock();
+        const bool more = this->decode();
+        lock.lock();
+        if (!more) {
+          break;
+        }
+        continue;
+      }
+      // the audio thread can't signal without risking a lock, poll often
+      // enough that the ring never drains
+      this->wake.wait_for(lock,
+                          std::chrono::milliseconds(MUSIC_BUFFER_MS / 4));
+    }
+  }
+  this->ended.store(true, std::memory_order_release);
+}
+
+bool MusicStream::decode() {
+  Decoder &decoder = *this->decoder;
+  const uint32_t free = this->capacity -
+                        (this->writeIndex.load(std::memory_order_relaxed) -
+                         this->readIndex.load(std::memory_order_acquire));
+
+  // gapless, the loop seeks to the exact frame before the ring sees the end
+  ogg_int64_t position = ov_pcm_tell(&decoder.file);
+  if (position >= decoder.loopEnd) {
+    if (ov_pcm_seek(&decoder.file, decoder.loopStart) != 0) {
+      return false;
+    }
+    position = decoder.loopStart;
+  }
+
+  // as many source frames as still fit in the ring once resampled
+  int wanted = std::min<ogg_int64_t>(MUSIC_DECODE_FRAMES,
+                                     decoder.loopEnd - position);
+  wanted = std::min(wanted, static_cast<int>((free - 2) * decoder.step));
+  if (wanted <= 0) {
+    return true;
+  }
+  float **channels;
+  int section;
+  const long frames =
+      ov_read_float(&decoder.file, &channels, wanted, &section);
+  if (frames == OV_HOLE) {
+    return true;
+  }
+  if (frames < 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to decode music %s\n",
+                 this->path.c_str());
+    return false;
+  }
+  if (frames == 0) {
+    // the end of the file came before the loop end, loop from there
+    decoder.loopEnd = position;
+    return position > decoder.loopStart;
+  }
+
+  // mono is played on both sides, past stereo only the front pair
+  const int right = decoder.channels > 1 ? 1 : 0;
+  for (long i = 0; i < frames; i++) {
+    decoder.stereo[i * 2] = channels[0][i];
+    decoder.stereo[i * 2 + 1] = channels[right][i];
+  }
+  if (decoder.step == 1.0) {
+    this->write(decoder.stereo.data(), frames);
+    return true;
+  }
+
+  int count = 0;
+  for (long i = 0; i < frames; i++) {
+    const float *next = &decoder.stereo[i * 2];
+    while (decoder.phase < 1.0) {
+      const float t = static_cast<float>(decoder.phase);
+      decoder.resampled[count * 2] =
+          decoder.last[0] + (next[0] - decoder.last[0]) * t;
+      decoder.resampled[count * 2 + 1] =
+          decoder.last[1] + (next[1] - decoder.last[1]) * t;
+      decoder.phase += decoder.step;
+      count++;
+    }
+    decoder.phase -= 1.0;
+    decoder.last[0] = next[0];
+    decoder.last[1] = next[1];
+  }
+  this->write(decoder.resampled.data(), count);
+  return true;
+}
+
+void MusicStream::write(const float *frames, int count) {
+  const uint32_t mask = this->capacity - 1;
+  const uint32_t index = this->writeIndex.load(std::memory_order_relaxed);
+  for (int i = 0; i < count; i++) {
+    const uint32_t slot = (index + i) & mask;
+    this->ring[slot * 2] = frames[i * 2];
+    this->ring[slot * 2 + 1] = frames[i * 2 + 1];
+  }
+  this->writeIndex.store(index + count, std::memory_order_release);
+}
+
+bool MusicStream::Mix(float *out, int frames) {
+  // ended first, once it is set the write index is final
+  const bool ended = this->ended.load(std::memory_order_acquire);
+  const uint32_t index = this->readIndex.load(std::memory_order_relaxed);
+  const uint32_t available =
+      this->writeIndex.load(std::memory_order_acquire) - index;
+
+  // starts on a half full ring so the first callbacks don't starve
+  if (!this->primed) {
+    if (available < this->capacity / 2 && !ended) {
+      return true;
+    }
+    this->primed = true;
+  }
+
+  const float target = this->fadeTarget.load(std::memory_order_relaxed);
+  const float step = this->fadeStep.load(std::memory_order_relaxed);
+  const uint32_t mask = this->capacity - 1;
+  const int count = std::min(frames, static_cast<int>(available));
+  for (int i = 0; i < frames; i++) {
+    this->gain = this->gain < target ? std::min(this->gain + step, target)
+                                     : std::max(this->gain - step, target);
+    if (i < count) {
+      const uint32_t slot = (index + i) & mask;
+      out[i * 2] += this->ring[slot * 2] * this->gain;
+      out[i * 2 + 1] += this->ring[slot * 2 + 1] * this->gain;
+    }
+  }
+  this->readIndex.store(index + count, std::memory_order_release);
+
+  if ((this->gain == 0.0f && target == 0.0f) ||
+      (ended && count == static_cast<int>(available))) {
+    this->silent.store(true, std::memory_order_release);
+  }
+  return count == frames || ended;
+}
+
+MusicPlayer::MusicPlayer() { this->scratch.resize(MUSIC_MIX_FRAMES * 2); }
+
+void MusicPlayer::SetBackend(MusicBackend backend) {
+  instance->backend = backend;
+}
+
+MusicBackend MusicPlayer::GetBackend() { return instance->backend; }
+
+void MusicPlayer::PlaySdl(Mix_Music *music) {
+  if (!instance->postMixed) {
+    instance->resetCallbackStats();
+    Mix_SetPostMix(postMix, instance.get());
+    instance->postMixed = true;
+  }
+  if (Mix_PlayMusic(music, -1) == -1) {
+    SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to play music: %s\n",
+                 Mix_GetError());
+  }
+}
+
+void MusicPlayer::Play(const std::string &path, float fadeSeconds) {
+  if (!instance->hooked) {
+    int frequency, channels;
+    Uint16 format;
+    if (!Mix_QuerySpec(&frequency, &format, &channels) ||
+        format != AUDIO_S16SYS || channels != 2) {
+      SDL_LogError(SDL_LOG_CATEGORY_AUDIO,
+                   "Music streaming needs a 16 bit stereo device\n");
+      return;
+    }
+    instance->frequency = frequency;
+    instance->resetCallbackStats();
+    Mix_HookMusic(hook, instance.get());
+    instance->hooked = true;
+  }
+  if (instance->current != nullptr &&
+      instance->current->GetPath() == path &&
+      !instance->current->IsSilent()) {
+    return;
+  }
+  if (instance->current != nullptr) {
+    instance->current->FadeTo(0.0f, fadeSeconds);
+    instance->fading.push_back(std::move(instance->current));
+  }
+  instance->current = std::make_unique<MusicStream>(path, instance->frequency);
+  instance->current->FadeTo(1.0f, fadeSeconds);
+  instance->dropSilent();
+  instance->publish();
+}
+
+void MusicPlayer::Stop(float fadeSeconds) {
+  if (instance->current == nullptr) {
+    return;
+  }
+  instance->current->FadeTo(0.0f, fadeSeconds);
+  instance->fading.push_back(std::move(instance->current));
+  instance->dropSilent();
+  instance->publish();
+}
+
+void MusicPlayer::Close() {
+  // both take the audio lock, the callbacks aren't running once they return
+  if (instance->hooked) {
+    Mix_HookMusic(nullptr, nullptr);
+    instance->hooked = false;
+  }
+  if (instance->postMixed) {
+    Mix_HaltMusic();
+    Mix_SetPostMix(nullptr, nullptr);
+    instance->postMixed = false;
+  }
+  const MusicCallbackStats stats = GetCallbackStats();
+  if (stats.callbacks > 0) {
+    SDL_Log("Music callback worst %.3f ms, mean %.3f ms over %u callbacks, "
+            "%u underruns\n",
+            stats.maxMs, stats.meanMs, stats.callbacks, stats.underruns);
+  }
+  for (auto &stream : instance->streams) {
+    stream.store(nullptr, std::memory_order_relaxed);
+  }
+  instance->current.reset();
+  instance->fading.clear();
+}
+
+void MusicPlayer::SetVolume(float volume) {
+  instance->volume.store(std::clamp(volume, 0.0f, 1.0f),
+                         std::memory_order_relaxed);
+}
+
+MusicCallbackStats MusicPlayer::GetCallbackStats() {
+  const double frequency =
+      static_cast<double>(SDL_GetPerformanceFrequency()) / 1000.0;
+  const uint32_t callbacks = instance->callbacks.load();
+  MusicCallbackStats stats = {};
+  stats.maxMs = static_cast<float>(instance->maxCallbackTicks.load() /
+                                   frequency);
+  stats.meanMs = callbacks > 0
+                     ? static_cast<float>(instance->callbackTicks.load() /
+                                          frequency / callbacks)
+                     : 0.0f;
+  stats.callbacks = callbacks;
+  stats.underruns = instance->underruns.load();
+  return stats;
+}
+
+void MusicPlayer::dropSilent() {
+  std::vector<std::unique_ptr<MusicStream>> dropped;
+  for (auto it = this->fading.begin(); it != this->fading.end();) {
+    if ((*it)->IsSilent()) {
+      dropped.push_back(std::move(*it));
+      it = this->fading.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  // out of slots, the oldest fade is cut short
+  while (this->fading.size() > MUSIC_MAX_STREAMS - 1) {
+    dropped.push_back(std::move(this->fading.front()));
+    this->fading.erase(this->fading.begin());
+  }
+  if (dropped.empty()) {
+    return;
+  }
+  this->publish();
+  // takes the audio lock, the hook is done with the dropped streams once this
+  // returns and they can stop their workers
+  if (this->hooked) {
+    Mix_HookMusic(hook, this);
+  }
+}
+
+void MusicPlayer::publish() {
+  int slot = 0;
+  this->streams[slot++].store(this->current.get(), std::memory_order_release);
+  for (const auto &stream : this->fading) {
+    this->streams[slot++].store(stream.get(), std::memory_order_release);
+  }
+  while (slot < MUSIC_MAX_STREAMS) {
+    this->streams[slot++].store(nullptr, std::memory_order_release);
+  }
+}
+
+void MusicPlayer::hook(void *udata, Uint8 *stream, int len) {
+  auto *player = static_cast<MusicPlayer *>(udata);
+  const uint64_t start = SDL_GetPerformanceCounter();
+
+  auto *pcm = reinterpret_cast<int16_t *>(stream);
+  int frames = len / (2 * sizeof(int16_t));
+  const float volume = player->volume.load(std::memory_order_relaxed);
+  bool starved = false;
+  while (frames > 0) {
+    const int count = std::min(frames, MUSIC_MIX_FRAMES);
+    float *mix = player->scratch.data();
+    std::fill(mix, mix + count * 2, 0.0f);
+    for (auto &slot : player->streams) {
+      MusicStream *music = slot.load(std::memory_order_acquire);
+      if (music != nullptr && !music->Mix(mix, count)) {
+        starved = true;
+      }
+    }
+    for (int i = 0; i < count * 2; i++) {
+      pcm[i] = static_cast<int16_t>(
+          std::clamp(mix[i] * volume * 32768.0f, -32768.0f, 32767.0f));
+    }
+    pcm += count * 2;
+    frames -= count;
+  }
+
+  player->countCallback(SDL_GetPerformanceCounter() - start, starved);
+}
+
+void MusicPlayer::postMix(void *udata, Uint8 *stream, int len) {
+  auto *player = static_cast<MusicPlayer *>(udata);
+  // the whole callback since the last one, SDL_mixer decoding its music
+  // included. it decodes inline so it can't underrun
+  const uint64_t now = threadTicks();
+  if (player->lastPostMix != 0) {
+    player->countCallback(now - player->lastPostMix, false);
+  }
+  player->lastPostMix = now;
+}
+
+void MusicPlayer::countCallback(uint64_t ticks, bool starved) {
+  // one writer, the game thread only reads these
+  this->callbackTicks.store(this->callbackTicks.load() + ticks);
+  this->callbacks.store(this->callbacks.load() + 1);
+  if (ticks > this->maxCallbackTicks.load()) {
+    this->maxCallbackTicks.store(ticks);
+  }
+  if (starved) {
+    this->underruns.store(this->underruns.load() + 1);
+  }
+}
+
+void MusicPlayer::resetCallbackStats() {
+  // before the callback is set, nothing writes these
+  this->callbackTicks.store(0);
+  this->maxCallbackTicks.store(0);
+  this->callbacks.store(0);
+  this->underruns.store(0);
+  this->lastPostMix = 0;
+}
+#endif
@@ -0,0 +1,226 @@
+#include "soft-mixer.hpp"
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define SOFT_MIXER_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SOFT_MIXER_NEON
+#endif
+
+static std::unique_ptr<SoftMixer> device;
+
+static bool isDeviceSupported() {
+  int frequency, channels;
+  Uint16 format;
+  return Mix_QuerySpec(&frequency, &format, &channels) &&
+         format == AUDIO_S16SYS && channels == 2;
+}
+
+// balance rather than equal power, so a centered voice is as loud as it is
+// on an SDL_mixer channel
+static void panGains(float volume, float pan, float &left, float &right) {
+  pan = std::clamp(pan, -1.0f, 1.0f);
+  volume = std::clamp(volume, 0.0f, 1.0f);
+  left = volume * std::min(1.0f, 1.0f - pan);
+  right = volume * std::min(1.0f, 1.0f + pan);
+}
+
+std::unique_ptr<PcmClip> PcmClip::FromChunk(const Mix_Chunk *chunk) {
+  if (chunk == nullptr || !isDeviceSupported()) {
+    return nullptr;
+  }
+  auto clip = std::make_unique<PcmClip>();
+  const auto *pcm = reinterpret_cast<const int16_t *>(chunk->abuf);
+  clip->frames = chunk->alen / (2 * sizeof(int16_t));
+  clip->samples.resize(clip->frames * 2);
+  for (size_t i = 0; i < clip->samples.size(); i++) {
+    clip->samples[i] = pcm[i] / 32768.0f;
+  }
+  return clip;
+}
+
+void MixStereo(float *out, const float *in, int frames, float left,
+               float right) {
+  const int samples = frames * 2;
+  int i = 0;
+  // two frames per vector
+#if defined(SOFT_MIXER_SSE)
+  const __m128 gain = _mm_setr_ps(left, right, left, right);
+  for (; i + 4 <= samples; i += 4) {
+    const __m128 mixed = _mm_add_ps(_mm_loadu_ps(out + i),
+                                    _mm_mul_ps(_mm_loadu_ps(in + i), gain));
+    _mm_storeu_ps(out + i, mixed);
+  }
+#elif defined(SOFT_MIXER_NEON)
+  const float gains[4] = {left, right, left, right};
+  const float32x4_t gain = vld1q_f32(gains);
+  for (; i + 4 <= samples; i += 4) {
+    vst1q_f32(out + i, vmlaq_f32(vld1q_f32(out + i), vld1q_f32(in + i), gain));
+  }
+#endif
+  for (; i < samples; i += 2) {
+    out[i] += in[i] * left;
+    out[i + 1] += in[i + 1] * right;
+  }
+}
+
+SoftMixer::SoftMixer(int bufferFrames)
+    : bufferFrames(std::max(bufferFrames, 1)) {
+  this->scratch.resize(this->bufferFrames * 2);
+}
+
+bool SoftMixer::Open(int bufferFrames) {
+  if (!isDeviceSupported()) {
+    SDL_LogError(SDL_LOG_CATEGORY_AUDIO,
+                 "The software mixer needs a 16 bit stereo device\n");
+    return false;
+  }
+  device = std::make_unique<SoftMixer>(bufferFrames);
+  Mix_SetPostMix(postMix, device.get());
+  return true;
+}
+
+void SoftMixer::Close() {
+  // takes the audio lock, the hook isn't running once this returns
+  Mix_SetPostMix(nullptr, nullptr);
+  device.reset();
+}
+
+SoftMixer *SoftMixer::Get() { return device.get(); }
+
+bool SoftMixer::push(const Command &command) {
+  const uint32_t tail = this->tail.load(std::memory_order_relaxed);
+  if (tail - this->head.load(std::memory_order_acquire) >=
+      SOFT_MIXER_QUEUE_SIZE) {
+    return false;
+  }
+  this->queue[tail % SOFT_MIXER_QUEUE_SIZE] = command;
+  this->tail.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+bool SoftMixer::Play(int voice, const PcmClip *clip, float volume,
+                     float pan) {
+  if (clip == nullptr) {
+    return false;
+  }
+  Command command = {COMMAND_PLAY, voice, clip, 0.0f, 0.0f,
+                     this->started[voice] + 1};
+  panGains(volume, pan, command.left, command.right);
+  if (!this->push(command)) {
+    return false;
+  }
+  this->started[voice] = command.generation;
+  return true;
+}
+
+void SoftMixer::Stop(int voice) {
+  if (this->push({COMMAND_STOP, voice, nullptr, 0.0f, 0.0f,
+                  this->started[voice]})) {
+    this->stopped[voice] = this->started[voice];
+  }
+}
+
+void SoftMixer::SetVolume(int voice, float volume, float pan) {
+  Command command = {COMMAND_VOLUME, voice, nullptr, 0.0f, 0.0f,
+                     this->started[voice]};
+  panGains(volume, pan, command.left, command.right);
+  this->push(command);
+}
+
+bool SoftMixer::IsPlaying(int voice) const {
+  return this->started[voice] != this->stopped[voice] &&
+         this->started[voice] !=
+             this->finished[voice].load(std::memory_order_acquire);
+}
+
+void SoftMixer::Release(const PcmClip *clip) {
+  // unhooked, the audio thread doesn't touch the voices until it is hooked
+  // again. costs the voices one callback
+  const bool hooked = this == device.get();
+  if (hooked) {
+    Mix_SetPostMix(nullptr, nullptr);
+  }
+  this->applyCommands();
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    if (this->voices[i].clip == clip) {
+      this->finish(i);
+    }
+  }
+  if (hooked) {
+    Mix_SetPostMix(postMix, this);
+  }
+}
+
+void SoftMixer::finish(int voice) {
+  this->voices[voice].clip = nullptr;
+  this->finished[voice].store(this->voices[voice].generation,
+                              std::memory_order_release);
+}
+
+void SoftMixer::applyCommands() {
+  uint32_t head = this->head.load(std::memory_order_relaxed);
+  const uint32_t tail = this->tail.load(std::memory_order_acquire);
+  for (; head != tail; head++) {
+    const Command &command = this->queue[head % SOFT_MIXER_QUEUE_SIZE];
+    Voice &voice = this->voices[command.voice];
+    switch (command.type) {
+    case COMMAND_PLAY:
+      voice = {command.clip, 0, command.left, command.right,
+               command.generation};
+      break;
+    case COMMAND_STOP:
+      if (voice.clip != nullptr && voice.generation == command.generation) {
+        this->finish(command.voice);
+      }
+      break;
+    case COMMAND_VOLUME:
+      if (voice.generation == command.generation) {
+        voice.left = command.left;
+        voice.right = command.right;
+      }
+      break;
+    }
+  }
+  this->head.store(head, std::memory_order_release);
+}
+
+void SoftMixer::Mix(float *out, int frames) {
+  this->applyCommands();
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    Voice &voice = this->voices[i];
+    if (voice.clip == nullptr) {
+      continue;
+    }
+    const int count = std::min(frames, voice.clip->frames - voice.position);
+    MixStereo(out, voice.clip->samples.data() + voice.position * 2, count,
+              voice.left, voice.right);
+    voice.position += count;
+    if (voice.position >= voice.clip->frames) {
+      this->finish(i);
+    }
+  }
+}
+
+void SoftMixer::postMix(void *udata, Uint8 *stream, int len) {
+  auto *mixer = static_cast<SoftMixer *>(udata);
+  auto *pcm = reinterpret_cast<int16_t *>(stream);
+  int frames = len / (2 * sizeof(int16_t));
+  while (frames > 0) {
+    const int count = std::min(frames, mixer->bufferFrames);
+    float *mix = mixer->scratch.data();
+    // on top of what SDL_mixer mixed, the music
+    for (int i = 0; i < count * 2; i++) {
+      mix[i] = pcm[i] / 32768.0f;
+    }
+    mixer->Mix(mix, count);
+    for (int i = 0; i < count * 2; i++) {
+      pcm[i] = static_cast<int16_t>(
+          std::clamp(mix[i] * 32768.0f, -32768.0f, 32767.0f));
+    }
+    pcm += count * 2;
+    frames -= count;
+  }
+}
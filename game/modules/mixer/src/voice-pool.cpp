@@ -0,0 +1,157 @@
+#include "voice-pool.hpp"
+#include <algorithm>
+#include <cmath>
+
+static std::unique_ptr<VoicePool> instance = std::make_unique<VoicePool>();
+
+static int mixVolume(float volume) {
+  return static_cast<int>(std::clamp(volume, 0.0f, 1.0f) * MIX_MAX_VOLUME);
+}
+
+// the voices live on the SoftMixer when it is open
+
+static bool isPlaying(int channel) {
+  if (auto *soft = SoftMixer::Get()) {
+    return soft->IsPlaying(channel);
+  }
+  return Mix_Playing(channel);
+}
+
+static void halt(int channel) {
+  if (auto *soft = SoftMixer::Get()) {
+    soft->Stop(channel);
+  } else {
+    Mix_HaltChannel(channel);
+  }
+}
+
+static void setVolume(int channel, float volume, float pan) {
+  if (auto *soft = SoftMixer::Get()) {
+    soft->SetVolume(channel, volume, pan);
+  } else {
+    Mix_Volume(channel, mixVolume(volume));
+  }
+}
+
+int VoicePool::findChannel(SoundPriority priority) {
+  int victim = -1;
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    if (!isPlaying(i)) {
+      return i;
+    }
+    const Voice &voice = this->voices[i];
+    if (voice.priority > priority) {
+      continue;
+    }
+    if (victim == -1) {
+      victim = i;
+      continue;
+    }
+    // the lowest priority first, then the policy
+    const Voice &best = this->voices[victim];
+    if (voice.priority != best.priority) {
+      if (voice.priority < best.priority) {
+        victim = i;
+      }
+    } else if (this->policy == STEAL_OLDEST
+                   ? voice.started < best.started
+                   : voice.volume < best.volume) {
+      victim = i;
+    }
+  }
+  if (victim != -1) {
+    halt(victim);
+    this->stats.stolen++;
+  }
+  return victim;
+}
+
+int VoicePool::Play(Mix_Chunk *chunk, const PcmClip *pcm,
+                    const SoundSettings &settings, float pan) {
+  const uint32_t now = SDL_GetTicks();
+
+  // identical clips in a burst only play once, or as often as allowed
+  ClipState &clip = instance->clips[chunk];
+  if (clip.startsInWindow == 0 || now - clip.windowStart >= settings.windowMs) {
+    clip.windowStart = now;
+    clip.startsInWindow = 0;
+  }
+  int instances = 0;
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    instances += instance->voices[i].chunk == chunk && isPlaying(i);
+  }
+  if (clip.startsInWindow >= settings.maxPerWindow ||
+      instances >= settings.maxInstances) {
+    instance->stats.limited++;
+    return -1;
+  }
+
+  const int channel = instance->findChannel(settings.priority);
+  if (channel == -1) {
+    instance->stats.dropped++;
+    return -1;
+  }
+  const float volume = settings.volume * instance->masterVolume;
+  if (auto *soft = SoftMixer::Get()) {
+    if (!soft->Play(channel, pcm, volume, pan)) {
+      SDL_LogError(SDL_LOG_CATEGORY_AUDIO,
+                   "Failed to play sound effect: %s\n",
+                   pcm ? "the command queue is full" : "no pcm");
+      return -1;
+    }
+  } else {
+    Mix_Volume(channel, mixVolume(volume));
+    if (Mix_PlayChannel(channel, chunk, 0) == -1) {
+      SDL_LogError(SDL_LOG_CATEGORY_AUDIO,
+                   "Failed to play sound effect: %s\n", Mix_GetError());
+      return -1;
+    }
+  }
+  instance->voices[channel] = {chunk, settings.priority, settings.volume, pan,
+                               now};
+  clip.startsInWindow++;
+  instance->stats.played++;
+  return channel;
+}
+
+int VoicePool::PlayAt(Mix_Chunk *chunk, const PcmClip *pcm,
+                      const SoundSettings &settings, float x, float y) {
+  const float distance =
+      std::hypot(x - instance->listenerX, y - instance->listenerY);
+  if (distance >= VOICE_CULL_DISTANCE) {
+    instance->stats.culled++;
+    return -1;
+  }
+  // linear falloff, quiet sounds are the first stolen with STEAL_QUIETEST
+  SoundSettings attenuated = settings;
+  attenuated.volume *= 1.0f - distance / VOICE_CULL_DISTANCE;
+  const float pan = (x - instance->listenerX) / VOICE_PAN_DISTANCE;
+  return Play(chunk, pcm, attenuated, pan);
+}
+
+void VoicePool::SetListener(float x, float y) {
+  instance->listenerX = x;
+  instance->listenerY = y;
+}
+
+void VoicePool::SetStealPolicy(VoiceStealPolicy policy) {
+  instance->policy = policy;
+}
+
+void VoicePool::SetMasterVolume(float volume) {
+  instance->masterVolume = volume;
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    const Voice &voice = instance->voices[i];
+    setVolume(i, voice.volume * volume, voice.pan);
+  }
+}
+
+VoiceStats VoicePool::GetStats() { return instance->stats; }
+
+int VoicePool::GetActiveVoices() {
+  int active = 0;
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    active += isPlaying(i);
+  }
+  return active;
+}
@@ -0,0 +1,45 @@
+#include "mixer.hpp"
+
+// Plays the same track through the MusicPlayer's streams and through
+// Mix_PlayMusic on SDL's dummy audio driver, and reports the music callback
+// times of both from the MusicPlayer's counters. Both have to get callbacks,
+// and the streams can't fall behind once primed.
+
+#define BENCH_FREQUENCY DEFAULT_MIXER_FREQUENCY
+#define BENCH_SECONDS 4
+
+int main(int argc, char *argv[]) {
+  // ctest sets it too, this is for running it by hand
+  SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+  if (SDL_Init(SDL_INIT_AUDIO) != 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "no audio: %s", SDL_GetError());
+    return 1;
+  }
+  int failures = 0;
+  for (const MusicBackend backend :
+       {MusicBackend::Streams, MusicBackend::SdlMixer}) {
+    const char *name =
+        backend == MusicBackend::Streams ? "streams" : "Mix_PlayMusic";
+    Mixer mixer({BENCH_FREQUENCY, DEFAULT_MIXER_BUFFER_FRAMES, false,
+                 backend});
+    MusicCallbackStats stats;
+    {
+      Music music(BENCH_MUSIC_PATH);
+      music.play_on_loop();
+      SDL_Delay(BENCH_SECONDS * 1000);
+      stats = MusicPlayer::GetCallbackStats();
+    }
+    if (stats.callbacks == 0 || stats.underruns > 0) {
+      SDL_LogError(SDL_LOG_CATEGORY_AUDIO,
+                   "%s: %u callbacks, %u underruns", name, stats.callbacks,
+                   stats.underruns);
+      failures++;
+    }
+    SDL_Log("%s: music callback worst %.3f ms, mean %.3f ms over %u "
+            "callbacks of %d frames, %u underruns",
+            name, stats.maxMs, stats.meanMs, stats.callbacks,
+            DEFAULT_MIXER_BUFFER_FRAMES, stats.underruns);
+  }
+  SDL_Quit();
+  return failures == 0 ? 0 : 1;
+}
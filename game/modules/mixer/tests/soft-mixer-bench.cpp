@@ -0,0 +1,91 @@
+#include "mixer.hpp"
+#include "soft-mixer.hpp"
+#include <random>
+
+// Mixes N voices with the SoftMixer into plain buffers, no audio device,
+// and reports what a callback costs against the time it has. Then times
+// MixStereo against the scalar loop it vectorizes.
+
+#define BENCH_FREQUENCY DEFAULT_MIXER_FREQUENCY
+#define BENCH_AUDIO_SECONDS 120
+#define BENCH_CLIP_SECONDS 2
+// of MixStereo, mixing one clip over and over
+#define BENCH_MIX_PASSES 2000
+
+static double seconds(Uint64 start) {
+  return static_cast<double>(SDL_GetPerformanceCounter() - start) /
+         static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// MixStereo without the vectors, unless the compiler adds its own
+static void mixStereoScalar(float *out, const float *in, int frames,
+                            float left, float right) {
+  for (int i = 0; i < frames * 2; i += 2) {
+    out[i] += in[i] * left;
+    out[i + 1] += in[i + 1] * right;
+  }
+}
+
+static void benchVoices(const PcmClip &clip, int voices, int bufferFrames) {
+  SoftMixer mixer(bufferFrames);
+  std::vector<float> out(bufferFrames * 2);
+  const int buffers = BENCH_AUDIO_SECONDS * BENCH_FREQUENCY / bufferFrames;
+  const Uint64 start = SDL_GetPerformanceCounter();
+  for (int b = 0; b < buffers; b++) {
+    // the game keeps every voice busy
+    for (int v = 0; v < voices; v++) {
+      if (!mixer.IsPlaying(v)) {
+        mixer.Play(v, &clip, 0.5f, v / static_cast<float>(voices) - 0.5f);
+      }
+    }
+    std::fill(out.begin(), out.end(), 0.0f);
+    mixer.Mix(out.data(), bufferFrames);
+  }
+  const double elapsed = seconds(start);
+  const double budget = static_cast<double>(bufferFrames) / BENCH_FREQUENCY;
+  SDL_Log("%d voices, %4d frame buffers: %.2f us per callback, %.3f%% of its "
+          "%.1f ms, %.1f ns per voice frame",
+          voices, bufferFrames, elapsed * 1e6 / buffers,
+          100.0 * elapsed / buffers / budget, budget * 1e3,
+          elapsed * 1e9 / (static_cast<double>(buffers) * bufferFrames *
+                           voices));
+}
+
+static void benchMixStereo(const PcmClip &clip) {
+  std::vector<float> out(clip.samples.size(), 0.0f);
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int pass = 0; pass < BENCH_MIX_PASSES; pass++) {
+    MixStereo(out.data(), clip.samples.data(), clip.frames, 0.5f, 0.25f);
+  }
+  const double simd = seconds(start);
+  start = SDL_GetPerformanceCounter();
+  for (int pass = 0; pass < BENCH_MIX_PASSES; pass++) {
+    mixStereoScalar(out.data(), clip.samples.data(), clip.frames, 0.5f,
+                    0.25f);
+  }
+  const double scalar = seconds(start);
+  const double frames =
+      static_cast<double>(clip.frames) * BENCH_MIX_PASSES / 1e6;
+  SDL_Log("MixStereo: %.0f M frames/s, the scalar loop %.0f M frames/s, "
+          "%.2fx (checksum %.1f)",
+          frames / simd, frames / scalar, scalar / simd, out[out.size() / 2]);
+}
+
+int main(int argc, char *argv[]) {
+  std::minstd_rand random(46);
+  std::uniform_real_distribution<float> sample(-0.5f, 0.5f);
+  PcmClip clip;
+  clip.frames = BENCH_CLIP_SECONDS * BENCH_FREQUENCY;
+  clip.samples.resize(clip.frames * 2);
+  for (auto &s : clip.samples) {
+    s = sample(random);
+  }
+
+  for (const int bufferFrames : {128, 256, DEFAULT_MIXER_BUFFER_FRAMES}) {
+    for (int voices = 1; voices <= MAX_SOUND_CHANNELS; voices *= 2) {
+      benchVoices(clip, voices, bufferFrames);
+    }
+  }
+  benchMixStereo(clip);
+  return 0;
+}
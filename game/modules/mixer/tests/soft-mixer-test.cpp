@@ -0,0 +1,174 @@
+#include "soft-mixer.hpp"
+#include <cmath>
+#include <random>
+
+// The SoftMixer against a plain scalar mix of the same voices, no audio
+// device. MixStereo's SIMD path has to match the scalar loop for every
+// length and alignment, and the voices have to start, stop, change volume
+// and run out exactly where the reference says across the mix buffers.
+
+// the vectors may fuse the multiply and add where the scalar loop doesn't
+#define MIX_TOLERANCE 1e-6f
+#define TEST_BUFFER_FRAMES 256
+
+static int failures = 0;
+
+// MixStereo without the vectors
+static void mixStereoScalar(float *out, const float *in, int frames,
+                            float left, float right) {
+  for (int i = 0; i < frames * 2; i += 2) {
+    out[i] += in[i] * left;
+    out[i + 1] += in[i + 1] * right;
+  }
+}
+
+// the largest difference between a and b over count samples
+static float difference(const float *a, const float *b, int count) {
+  float largest = 0.0f;
+  for (int i = 0; i < count; i++) {
+    largest = std::max(largest, std::abs(a[i] - b[i]));
+  }
+  return largest;
+}
+
+static void testMixStereo(std::minstd_rand &random) {
+  std::uniform_real_distribution<float> sample(-1.0f, 1.0f);
+  std::vector<float> in(512), simd(512), scalar(512);
+  // every tail length, and starts that aren't 16 byte aligned
+  for (int frames = 0; frames <= 37; frames++) {
+    for (int offset = 0; offset < 4; offset++) {
+      for (auto &s : in) {
+        s = sample(random);
+      }
+      for (size_t i = 0; i < simd.size(); i++) {
+        simd[i] = scalar[i] = sample(random);
+      }
+      const float left = sample(random);
+      const float right = sample(random);
+      MixStereo(simd.data() + offset, in.data() + 3 - offset, frames, left,
+                right);
+      mixStereoScalar(scalar.data() + offset, in.data() + 3 - offset, frames,
+                      left, right);
+      if (difference(simd.data(), scalar.data(), simd.size()) >
+          MIX_TOLERANCE) {
+        SDL_LogError(SDL_LOG_CATEGORY_AUDIO,
+                     "MixStereo of %d frames at offset %d is off the scalar "
+                     "loop",
+                     frames, offset);
+        failures++;
+      }
+    }
+  }
+}
+
+static std::unique_ptr<PcmClip> noise(std::minstd_rand &random, int frames) {
+  std::uniform_real_distribution<float> sample(-0.5f, 0.5f);
+  auto clip = std::make_unique<PcmClip>();
+  clip->frames = frames;
+  clip->samples.resize(frames * 2);
+  for (auto &s : clip->samples) {
+    s = sample(random);
+  }
+  return clip;
+}
+
+// a voice of the reference mix
+struct Reference {
+  const PcmClip *clip = nullptr;
+  int position = 0;
+  float left = 0.0f;
+  float right = 0.0f;
+};
+
+// the gains SoftMixer uses, balance panning
+static void gains(float volume, float pan, float &left, float &right) {
+  left = volume * std::min(1.0f, 1.0f - pan);
+  right = volume * std::min(1.0f, 1.0f + pan);
+}
+
+static void testVoices(std::minstd_rand &random) {
+  std::vector<std::unique_ptr<PcmClip>> clips;
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    // shorter than a buffer, and across a few of them
+    clips.push_back(noise(random, i == 0 ? 100 : 700 * i + 13));
+  }
+
+  SoftMixer mixer(TEST_BUFFER_FRAMES);
+  Reference reference[MAX_SOUND_CHANNELS];
+  std::uniform_int_distribution<int> voiceOf(0, MAX_SOUND_CHANNELS - 1);
+  std::uniform_int_distribution<int> framesOf(1, TEST_BUFFER_FRAMES * 2);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::vector<float> mixed, expected;
+  for (int block = 0; block < 400; block++) {
+    // some commands between two callbacks, the reference applies them the
+    // same way the audio thread does
+    const int commands = random() % 4;
+    for (int c = 0; c < commands; c++) {
+      const int voice = voiceOf(random);
+      const float volume = unit(random);
+      const float pan = unit(random) * 2.0f - 1.0f;
+      Reference &r = reference[voice];
+      switch (random() % 3) {
+      case 0:
+        r.clip = clips[voiceOf(random)].get();
+        r.position = 0;
+        gains(volume, pan, r.left, r.right);
+        mixer.Play(voice, r.clip, volume, pan);
+        break;
+      case 1:
+        mixer.Stop(voice);
+        r.clip = nullptr;
+        break;
+      case 2:
+        mixer.SetVolume(voice, volume, pan);
+        gains(volume, pan, r.left, r.right);
+        break;
+      }
+    }
+
+    // more frames than the buffer are split by the post mix hook, Mix gets
+    // any count
+    const int frames = framesOf(random);
+    mixed.assign(frames * 2, 0.0f);
+    expected.assign(frames * 2, 0.0f);
+    mixer.Mix(mixed.data(), frames);
+    for (int v = 0; v < MAX_SOUND_CHANNELS; v++) {
+      Reference &r = reference[v];
+      if (r.clip == nullptr) {
+        continue;
+      }
+      const int count = std::min(frames, r.clip->frames - r.position);
+      mixStereoScalar(expected.data(), r.clip->samples.data() + r.position * 2,
+                      count, r.left, r.right);
+      r.position += count;
+      if (r.position >= r.clip->frames) {
+        r.clip = nullptr;
+      }
+    }
+    if (difference(mixed.data(), expected.data(), frames * 2) >
+        MIX_TOLERANCE) {
+      SDL_LogError(SDL_LOG_CATEGORY_AUDIO,
+                   "block %d of %d frames is off the reference", block,
+                   frames);
+      failures++;
+      return;
+    }
+    for (int v = 0; v < MAX_SOUND_CHANNELS; v++) {
+      if (mixer.IsPlaying(v) != (reference[v].clip != nullptr)) {
+        SDL_LogError(SDL_LOG_CATEGORY_AUDIO,
+                     "voice %d is%s playing after block %d", v,
+                     mixer.IsPlaying(v) ? "" : "n't", block);
+        failures++;
+        return;
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  std::minstd_rand random(46);
+  testMixStereo(random);
+  testVoices(random);
+  SDL_Log("soft mixer: %d failures", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include "mixer.hpp"
+#include <vector>
+
+// The VoicePool's priorities, stealing, limits and culling, on SDL's dummy
+// audio driver so no device is needed. Runs once with the voices on
+// SDL_mixer's channels and once on the SoftMixer.
+
+// long enough to still be playing when a case is done with them
+#define CLIP_SECONDS 30
+#define TEST_FREQUENCY 44100
+
+static int failures = 0;
+
+static void expect(bool passed, const char *backend, const char *what) {
+  if (!passed) {
+    SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "%s: %s", backend, what);
+    failures++;
+  }
+}
+
+// a silent clip, with the decoded copy the SoftMixer plays
+struct Clip {
+  std::vector<Uint8> pcm;
+  Mix_Chunk *chunk;
+  std::unique_ptr<PcmClip> decoded;
+
+  Clip() : pcm(CLIP_SECONDS * TEST_FREQUENCY * 2 * sizeof(int16_t), 0) {
+    this->chunk = Mix_QuickLoad_RAW(this->pcm.data(), this->pcm.size());
+    this->decoded = PcmClip::FromChunk(this->chunk);
+  }
+  ~Clip() {
+    if (this->decoded != nullptr && SoftMixer::Get() != nullptr) {
+      SoftMixer::Get()->Release(this->decoded.get());
+    }
+    Mix_FreeChunk(this->chunk);
+  }
+
+  int Play(const SoundSettings &settings) {
+    return VoicePool::Play(this->chunk, this->decoded.get(), settings);
+  }
+};
+
+static void stopAll() {
+  if (auto *soft = SoftMixer::Get()) {
+    for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+      soft->Stop(i);
+    }
+  } else {
+    Mix_HaltChannel(-1);
+  }
+}
+
+// of the stats since before
+static VoiceStats since(const VoiceStats &before) {
+  const VoiceStats now = VoicePool::GetStats();
+  return {now.played - before.played, now.stolen - before.stolen,
+          now.culled - before.culled, now.limited - before.limited,
+          now.dropped - before.dropped};
+}
+
+// no limits, only the priorities decide
+static SoundSettings unlimited(SoundPriority priority, float volume = 1.0f) {
+  SoundSettings settings;
+  settings.priority = priority;
+  settings.volume = volume;
+  settings.maxInstances = MAX_SOUND_CHANNELS;
+  settings.maxPerWindow = MAX_SOUND_CHANNELS * 2;
+  return settings;
+}
+
+// clips[0] to clips[MAX_SOUND_CHANNELS] are played in turn, the clips are
+// told apart by their chunk so they live as long as the backend
+static void testPriorities(const char *backend, Clip *clips) {
+  const VoiceStats before = VoicePool::GetStats();
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    clips[i].Play(unlimited(SOUND_PRIORITY_HIGH));
+  }
+  expect(VoicePool::GetActiveVoices() == MAX_SOUND_CHANNELS, backend,
+         "the voices didn't fill up");
+  // every voice is more important
+  expect(clips[MAX_SOUND_CHANNELS].Play(unlimited(SOUND_PRIORITY_NORMAL)) ==
+             -1,
+         backend, "a normal sound stole a high priority voice");
+  expect(since(before).dropped == 1, backend, "the drop wasn't counted");
+
+  // one low voice among them is the one stolen
+  stopAll();
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    clips[i].Play(unlimited(i == 5 ? SOUND_PRIORITY_LOW
+                                   : SOUND_PRIORITY_NORMAL));
+  }
+  expect(clips[MAX_SOUND_CHANNELS].Play(unlimited(SOUND_PRIORITY_NORMAL)) ==
+             5,
+         backend, "the low priority voice wasn't the one stolen");
+  // equal priorities can be stolen, a lower one can't steal
+  expect(clips[0].Play(unlimited(SOUND_PRIORITY_NORMAL)) != -1, backend,
+         "an equal priority voice wasn't stolen");
+  expect(clips[0].Play(unlimited(SOUND_PRIORITY_LOW)) == -1, backend,
+         "a low sound stole a normal priority voice");
+  expect(since(before).stolen == 2, backend, "the steals weren't counted");
+  stopAll();
+}
+
+static void testStealPolicies(const char *backend, Clip *clips) {
+  VoicePool::SetStealPolicy(STEAL_OLDEST);
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    // the start times are in milliseconds
+    SDL_Delay(2);
+    clips[i].Play(unlimited(SOUND_PRIORITY_NORMAL));
+  }
+  expect(clips[MAX_SOUND_CHANNELS].Play(unlimited(SOUND_PRIORITY_NORMAL)) ==
+             0,
+         backend, "the oldest voice wasn't the one stolen");
+  stopAll();
+
+  VoicePool::SetStealPolicy(STEAL_QUIETEST);
+  for (int i = 0; i < MAX_SOUND_CHANNELS; i++) {
+    const float volume = i == 6 ? 0.1f : 0.5f + i * 0.05f;
+    clips[i].Play(unlimited(SOUND_PRIORITY_NORMAL, volume));
+  }
+  expect(clips[MAX_SOUND_CHANNELS].Play(unlimited(SOUND_PRIORITY_NORMAL)) ==
+             6,
+         backend, "the quietest voice wasn't the one stolen");
+  VoicePool::SetStealPolicy(STEAL_OLDEST);
+  stopAll();
+}
+
+static void testInstanceLimit(const char *backend, Clip &clip) {
+  SoundSettings settings = unlimited(SOUND_PRIORITY_NORMAL);
+  settings.maxInstances = 2;
+  const VoiceStats before = VoicePool::GetStats();
+  clip.Play(settings);
+  clip.Play(settings);
+  expect(clip.Play(settings) == -1, backend,
+         "a third instance played with a limit of 2");
+  expect(VoicePool::GetActiveVoices() == 2, backend,
+         "the instances stole each other");
+  expect(since(before).limited == 1, backend, "the limit wasn't counted");
+  stopAll();
+  expect(clip.Play(settings) != -1, backend,
+         "stopped instances still counted against the limit");
+  stopAll();
+}
+
+static void testRateLimit(const char *backend, Clip &clip) {
+  SoundSettings settings = unlimited(SOUND_PRIORITY_NORMAL);
+  settings.maxPerWindow = 2;
+  settings.windowMs = 100;
+  // past the window of a clip of the other backend at the same address
+  SDL_Delay(settings.windowMs);
+  const VoiceStats before = VoicePool::GetStats();
+  // a burst, only the first two of the window play
+  int played = 0;
+  for (int i = 0; i < 5; i++) {
+    played += clip.Play(settings) != -1;
+  }
+  expect(played == 2, backend, "the burst wasn't rate limited");
+  expect(since(before).limited == 3, backend, "the limit wasn't counted");
+  SDL_Delay(settings.windowMs + 20);
+  expect(clip.Play(settings) != -1, backend,
+         "the clip was still limited after its window");
+  stopAll();
+}
+
+static void testCulling(const char *backend, Clip &clip) {
+  const SoundSettings settings = unlimited(SOUND_PRIORITY_NORMAL);
+  const VoiceStats before = VoicePool::GetStats();
+  VoicePool::SetListener(1000.0f, 500.0f);
+  expect(VoicePool::PlayAt(clip.chunk, clip.decoded.get(), settings,
+                           1000.0f + VOICE_CULL_DISTANCE, 500.0f) == -1,
+         backend, "a sound out of range played");
+  expect(VoicePool::PlayAt(clip.chunk, clip.decoded.get(), settings, 1000.0f,
+                           500.0f - VOICE_CULL_DISTANCE * 2) == -1,
+         backend, "a sound out of range played");
+  expect(VoicePool::PlayAt(clip.chunk, clip.decoded.get(), settings,
+                           1100.0f, 600.0f) != -1,
+         backend, "a sound in range didn't play");
+  expect(since(before).culled == 2, backend, "the culling wasn't counted");
+  VoicePool::SetListener(0.0f, 0.0f);
+  stopAll();
+}
+
+int main(int argc, char *argv[]) {
+  // ctest sets it too, this is for running it by hand
+  SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+  if (SDL_Init(SDL_INIT_AUDIO) != 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "no audio: %s", SDL_GetError());
+    return 1;
+  }
+  for (const bool soft : {false, true}) {
+    const char *backend = soft ? "SoftMixer" : "SDL_mixer";
+    Mixer mixer({TEST_FREQUENCY, DEFAULT_MIXER_BUFFER_FRAMES, soft});
+    if (soft && SoftMixer::Get() == nullptr) {
+      expect(false, backend, "didn't open");
+      continue;
+    }
+    Clip clips[MAX_SOUND_CHANNELS + 3];
+    testPriorities(backend, clips);
+    testStealPolicies(backend, clips);
+    testInstanceLimit(backend, clips[MAX_SOUND_CHANNELS + 1]);
+    testRateLimit(backend, clips[MAX_SOUND_CHANNELS + 2]);
+    testCulling(backend, clips[MAX_SOUND_CHANNELS + 1]);
+  }
+  SDL_Quit();
+
+  SDL_Log("voice pool: %d failures", failures);
+  return failures == 0 ? 0 : 1;
+}
@@ -1,7 +1,36 @@
 #pragma once
 
+#include <cstdint>
+
 #define TEXT_BUFFER_SIZE 256
+#define INPUT_PATH_SIZE 256
+
+enum InputMode {
+  INPUT_LIVE,   // from SDL
+  INPUT_RECORD, // from SDL, saved to input_path on close
+  INPUT_REPLAY, // from the recording at input_path, as fast as possible
+};
+
+// performance counter timestamps along a frame, for the input to present
+// latency. 0 where the frame didn't get to
+struct FrameTiming {
+  uint64_t input;     // the oldest input event the frame reflects
+  uint64_t sampled;   // the game read the keyboard state
+  uint64_t simulated; // the world progressed
+  uint64_t submitted; // the sprite batch was flushed
+  uint64_t presented; // the swap returned
+};
 
 struct SharedData {
   char text_input_buffer[TEXT_BUFFER_SIZE];
-};
\ No newline at end of file
+  // set by the host from the command line
+  int input_mode;
+  char input_path[INPUT_PATH_SIZE];
+  // the ticks run through rollback netcode, with the player's input arriving
+  // this many ticks late as if from a peer. 0 doesn't
+  int rollback_ticks;
+  // set by the game when it is done, at the end of a replay
+  bool quit;
+  // written by the host and the game as the frame goes
+  FrameTiming timing;
+};
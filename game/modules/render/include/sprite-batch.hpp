@@ -22,6 +22,8 @@ public:
   ~SpriteBatch();
 
   void UpdateCamera(glm::vec2 focalPoint, SDL_Rect tilemapBounds);
+  // what the camera sees in world space (x, y, w, h), for culling
+  glm::vec4 GetViewRect() const;
 
   void Draw(Texture *texture, glm::vec2 position,
             glm::vec2 scale = glm::vec2(1, 1), float rotation = 0.0f,
@@ -35,6 +37,12 @@ public:
             glm::vec4 srcRect = glm::vec4(0, 0, 0, 0),
             glm::vec2 flipPadding = glm::vec2(0, 0));
 
+  // draw with precomputed normalized uvs (u0, v0, u1, v1), size in pixels
+  void DrawUV(Texture *texture, glm::vec2 position, glm::vec2 size,
+              glm::vec4 uvRect, glm::vec2 scale = glm::vec2(1, 1),
+              float rotation = 0.0f, glm::vec4 color = glm::vec4(1, 1, 1, 1),
+              glm::vec2 flipPadding = glm::vec2(0, 0));
+
   void DrawRect(glm::vec4 destRect, glm::vec4 color = glm::vec4(1, 1, 1, 1));
   void Flush();
 
@@ -43,6 +51,10 @@ public:
   void SetTextureAndDimensions(GLuint texture, const int w, const int h);
 
 private:
+  void pushQuad(glm::vec2 position, glm::vec2 size, glm::vec4 uvRect,
+                glm::vec2 scale, float rotation, glm::vec4 color,
+                glm::vec2 flipPadding);
+
   std::vector<Vertex> vertices;
   GLuint vbo;
 
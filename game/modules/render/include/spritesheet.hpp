@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <glm/glm.hpp>
 #include <memory>
 #include <string>
@@ -8,21 +9,34 @@
 
 #include "texture.hpp"
 
+// Binary sprite sheet format, cooked from the json .atlas files by
+// scripts/atlas_cooker.py
+#define SHEET_MAGIC 0x53534C47 // "GLSS"
+#define SHEET_VERSION 1
+
+// index into SpriteSheet's animation table, resolve names once with
+// SpriteSheet::GetAnimationHandle and keep the handle
+typedef uint32_t AnimationHandle;
+
+// handle 0 is always the fallback "default" animation
+#define DEFAULT_ANIMATION 0
+
+struct SpriteFrame {
+  glm::vec4 uvRect; // normalized u0, v0, u1, v1
+  glm::vec2 size;   // in pixels
+  float duration;   // in seconds
+};
+
 struct SpriteAnimation {
-  std::vector<int> frames;
-  float frameTime;
-  glm::vec2 dimensions;
+  uint32_t firstFrame; // into the sheet's frame table
+  uint32_t frameCount;
+  glm::vec2 dimensions; // of the first frame, used as flip padding
   bool loop;
-  SpriteAnimation(std::vector<int> frames, float frameTime,
-                  glm::vec2 dimensions, bool loop)
-      : frames(frames), frameTime(frameTime), dimensions(dimensions),
-        loop(loop) {}
-  SpriteAnimation() : frames({0}), frameTime(0.0f), dimensions(glm::vec2(0)) {}
 };
 
 class SpriteSheet {
 public:
-  SpriteSheet(const char *atlasPath);
+  SpriteSheet(const char *sheetPath);
   ~SpriteSheet();
 
   Texture *GetTexture();
@@ -31,21 +45,26 @@ public:
 
   const size_t GetSpriteCount();
 
-  SpriteAnimation *GetAnimation(const char *name);
+  // returns DEFAULT_ANIMATION if there is no animation with the name
+  AnimationHandle GetAnimationHandle(const char *name);
 
-  glm::vec4 GetAnimationRect(const SpriteAnimation *animation, size_t index);
+  const SpriteAnimation &GetAnimation(AnimationHandle handle) const {
+    return this->animations[handle];
+  }
 
-private:
-  struct SpriteAtlas {
-    std::string texturePath;
-    std::unordered_map<std::string, SpriteAnimation> animations;
-    std::vector<glm::vec4> atlas;
-  };
+  const SpriteFrame &GetFrame(const SpriteAnimation &animation,
+                              uint32_t index) const {
+    return this->frames[animation.firstFrame + index];
+  }
 
-  void loadAtlas(const char *atlasPath);
+private:
+  bool loadSheet(const char *sheetPath);
+  void addAnimation(const std::string &name, const std::vector<int> &rects,
+                    const std::vector<float> &durations, bool loop);
 
   std::shared_ptr<Texture> texture;
-  std::vector<int> atlas;
-  size_t numRects;
-  std::unordered_map<std::string, SpriteAnimation> animations;
+  std::vector<glm::ivec4> atlas;
+  std::vector<SpriteAnimation> animations;
+  std::vector<SpriteFrame> frames;
+  std::unordered_map<std::string, AnimationHandle> animationHandles;
 };
@@ -4,7 +4,8 @@
 
 class Window {
 public:
-  Window(const char *title, int width, int height);
+  // flags are added to SDL_WINDOW_OPENGL
+  Window(const char *title, int width, int height, Uint32 flags = 0);
   ~Window();
 
   SDL_Window *GetSDLWindow() const;
@@ -106,6 +106,11 @@ void SpriteBatch::UpdateCamera(glm::vec2 focalPoint, SDL_Rect tilemapBounds) {
                                  -focalPoint.y + this->windowSize.y / 2, 0.0f));
 }
 
+glm::vec4 SpriteBatch::GetViewRect() const {
+  return glm::vec4(this->cameraPosition - this->windowSize / 2.0f,
+                   this->windowSize);
+}
+
 void SpriteBatch::Draw(Texture *texture, glm::vec2 position, glm::vec2 scale,
                        float rotation, glm::vec4 color, glm::vec4 srcRect,
                        glm::vec2 flipPadding) {
@@ -131,17 +136,40 @@ void SpriteBatch::Draw(Texture *texture, glm::vec2 position, glm::vec2 scale,
 void SpriteBatch::Draw(GLuint texture, glm::vec2 position, glm::vec2 scale,
                        float rotation, glm::vec4 color, glm::vec4 srcRect,
                        glm::vec2 flipPadding) {
-  glm::vec2 center(position.x + (srcRect.z * scale.x) * 0.5f,
-                   position.y + (srcRect.w * scale.y) * 0.5f);
-
-  glm::vec2 scaledTopLeft(-srcRect.z * scale.x * 0.5f,
-                          -srcRect.w * scale.y * 0.5f);
-  glm::vec2 scaledTopRight(srcRect.z * scale.x * 0.5f,
-                           -srcRect.w * scale.y * 0.5f);
-  glm::vec2 scaledBottomLeft(-srcRect.z * scale.x * 0.5f,
-                             srcRect.w * scale.y * 0.5f);
-  glm::vec2 scaledBottomRight(srcRect.z * scale.x * 0.5f,
-                              srcRect.w * scale.y * 0.5f);
+  const float textureWidth = this->textureRect.z;
+  const float textureHeight = this->textureRect.w;
+
+  const glm::vec4 uvRect(srcRect.x / textureWidth, srcRect.y / textureHeight,
+                         (srcRect.x + srcRect.z) / textureWidth,
+                         (srcRect.y + srcRect.w) / textureHeight);
+
+  this->pushQuad(position, glm::vec2(srcRect.z, srcRect.w), uvRect, scale,
+                 rotation, color, flipPadding);
+}
+
+void SpriteBatch::DrawUV(Texture *texture, glm::vec2 position, glm::vec2 size,
+                         glm::vec4 uvRect, glm::vec2 scale, float rotation,
+                         glm::vec4 color, glm::vec2 flipPadding) {
+  if (this->texture != texture->GetGLTexture()) {
+    this->Flush();
+    this->texture = texture->GetGLTexture();
+  }
+  if (flipPadding == glm::vec2(0, 0)) {
+    flipPadding = size;
+  }
+  this->pushQuad(position, size, uvRect, scale, rotation, color, flipPadding);
+}
+
+void SpriteBatch::pushQuad(glm::vec2 position, glm::vec2 size,
+                           glm::vec4 uvRect, glm::vec2 scale, float rotation,
+                           glm::vec4 color, glm::vec2 flipPadding) {
+  glm::vec2 center(position.x + (size.x * scale.x) * 0.5f,
+                   position.y + (size.y * scale.y) * 0.5f);
+
+  glm::vec2 scaledTopLeft(-size.x * scale.x * 0.5f, -size.y * scale.y * 0.5f);
+  glm::vec2 scaledTopRight(size.x * scale.x * 0.5f, -size.y * scale.y * 0.5f);
+  glm::vec2 scaledBottomLeft(-size.x * scale.x * 0.5f, size.y * scale.y * 0.5f);
+  glm::vec2 scaledBottomRight(size.x * scale.x * 0.5f, size.y * scale.y * 0.5f);
 
   // Rotate the vertices
   const glm::mat2 rotationMatrix(glm::cos(rotation), -glm::sin(rotation),
@@ -151,17 +179,10 @@ void SpriteBatch::Draw(GLuint texture, glm::vec2 position, glm::vec2 scale,
   scaledBottomLeft = rotationMatrix * scaledBottomLeft + center;
   scaledBottomRight = rotationMatrix * scaledBottomRight + center;
 
-  const float textureWidth = this->textureRect.z;
-  const float textureHeight = this->textureRect.w;
-
-  const glm::vec2 uvTopLeft(srcRect.x / textureWidth,
-                            srcRect.y / textureHeight);
-  const glm::vec2 uvTopRight((srcRect.x + srcRect.z) / textureWidth,
-                             srcRect.y / textureHeight);
-  const glm::vec2 uvBottomLeft(srcRect.x / textureWidth,
-                               (srcRect.y + srcRect.w) / textureHeight);
-  const glm::vec2 uvBottomRight((srcRect.x + srcRect.z) / textureWidth,
-                                (srcRect.y + srcRect.w) / textureHeight);
+  const glm::vec2 uvTopLeft(uvRect.x, uvRect.y);
+  const glm::vec2 uvTopRight(uvRect.z, uvRect.y);
+  const glm::vec2 uvBottomLeft(uvRect.x, uvRect.w);
+  const glm::vec2 uvBottomRight(uvRect.z, uvRect.w);
 
   // dumb but works
   if (scale.y < 0) {
@@ -1,9 +1,63 @@
 #include "spritesheet.hpp"
+#include <cstring>
 #include <fstream>
-#include <nlohmann/json.hpp>
 #include <utils.hpp>
 
-SpriteSheet::SpriteSheet(const char *atlasPath) { this->loadAtlas(atlasPath); }
+namespace {
+struct SheetHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t rectCount;
+  uint32_t rectsOffset; // rectCount x, y, w, h int32_t
+  uint32_t animationCount;
+  uint32_t animationsOffset; // animationCount SheetAnimation
+  uint32_t frameCount;
+  uint32_t framesOffset; // frameCount SheetFrame
+  uint32_t stringsOffset;
+  uint32_t stringsSize;
+  uint32_t texturePath; // string offset, relative to the sheet
+};
+
+struct SheetAnimation {
+  uint32_t nameOffset;
+  uint32_t nameLength;
+  uint32_t firstFrame;
+  uint32_t frameCount;
+  uint32_t loop;
+};
+
+struct SheetFrame {
+  uint32_t rect;
+  float duration;
+};
+} // namespace
+
+// first + count items fit in size, without overflowing
+static bool inRange(uint32_t first, uint32_t count, uint32_t size) {
+  return count <= size && first <= size - count;
+}
+
+// count items of T starting at offset fit in bytes, aligned for T
+template <class T>
+static bool fits(const std::vector<char> &bytes, uint32_t offset,
+                 uint32_t count) {
+  return offset % alignof(T) == 0 && offset <= bytes.size() &&
+         count <= (bytes.size() - offset) / sizeof(T);
+}
+
+SpriteSheet::SpriteSheet(const char *sheetPath) {
+  if (!this->loadSheet(sheetPath)) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load sheet: %s",
+                 sheetPath);
+  }
+  // keep the handles valid even if the sheet failed to load
+  if (this->atlas.empty()) {
+    this->atlas.push_back(glm::ivec4(0, 0, 0, 0));
+  }
+  if (this->animations.empty()) {
+    this->addAnimation("default", {0}, {0.0f}, false);
+  }
+}
 
 SpriteSheet::~SpriteSheet() {}
 
@@ -11,78 +65,157 @@ Texture *SpriteSheet::GetTexture() { return this->texture.get(); }
 
 const glm::vec4 SpriteSheet::GetAtlasRect(size_t index) {
   // validate the index
-  if (index < 0 || index >= this->numRects) {
+  if (index >= this->atlas.size()) {
     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
                  "SpriteSheet::GetSpriteRect: index out of range");
     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "index: %zu", index);
-    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "numRects: %zu", this->numRects);
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "numRects: %zu",
+                 this->atlas.size());
     SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
                  "Returning spriteRects[0] instead");
 
-    return glm::vec4(this->atlas[0], this->atlas[1], this->atlas[2],
-                     this->atlas[3]);
+    return this->atlas[0];
   }
-  return glm::vec4(this->atlas[index * 4], this->atlas[index * 4 + 1],
-                   this->atlas[index * 4 + 2], this->atlas[index * 4 + 3]);
+  return this->atlas[index];
 }
 
-const size_t SpriteSheet::GetSpriteCount() { return this->numRects; }
+const size_t SpriteSheet::GetSpriteCount() { return this->atlas.size(); }
 
-SpriteAnimation *SpriteSheet::GetAnimation(const char *name) {
-  if (this->animations.find(name) != this->animations.end()) {
-    return &this->animations[name];
+AnimationHandle SpriteSheet::GetAnimationHandle(const char *name) {
+  const auto handle = this->animationHandles.find(name);
+  if (handle != this->animationHandles.end()) {
+    return handle->second;
   }
   SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
-               "SpriteSheet::GetAnimation: animation not found");
+               "SpriteSheet::GetAnimationHandle: animation not found");
   SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "animation name: %s", name);
-  SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Returning empty animation");
-  return &this->animations["default"];
+  SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Returning default animation");
+  return DEFAULT_ANIMATION;
 }
 
-glm::vec4 SpriteSheet::GetAnimationRect(const SpriteAnimation *animation,
-                                        size_t index) {
-  return this->GetAtlasRect(animation->frames[index]);
+void SpriteSheet::addAnimation(const std::string &name,
+                               const std::vector<int> &rects,
+                               const std::vector<float> &durations,
+                               bool loop) {
+  const glm::vec4 textureRect =
+      this->texture ? this->texture->GetTextureRect() : glm::ivec4(0, 0, 1, 1);
+
+  SpriteAnimation animation;
+  animation.firstFrame = this->frames.size();
+  animation.frameCount = rects.size();
+  animation.loop = loop;
+
+  // bake the normalized uvs so drawing a frame is just a table lookup
+  for (size_t i = 0; i < rects.size(); i++) {
+    const glm::vec4 rect = this->GetAtlasRect(rects[i]);
+    SpriteFrame frame;
+    frame.uvRect =
+        glm::vec4(rect.x / textureRect.z, rect.y / textureRect.w,
+                  (rect.x + rect.z) / textureRect.z,
+                  (rect.y + rect.w) / textureRect.w);
+    frame.size = glm::vec2(rect.z, rect.w);
+    frame.duration = durations[i];
+    this->frames.push_back(frame);
+  }
+
+  // get the wh (dimensions) of the first frame
+  animation.dimensions = this->frames[animation.firstFrame].size;
+
+  this->animationHandles[name] = this->animations.size();
+  this->animations.push_back(animation);
 }
 
-void SpriteSheet::loadAtlas(const char *atlasPath) {
-  std::vector<SDL_Rect> rects;
-  std::ifstream atlasFile(atlasPath);
-  nlohmann::json atlasJson;
-  atlasFile >> atlasJson;
+bool SpriteSheet::loadSheet(const char *sheetPath) {
+  // the sheets are small, read the whole file in one go
+  std::ifstream sheetFile(sheetPath, std::ios::binary | std::ios::ate);
+  if (!sheetFile) {
+    return false;
+  }
+  const std::streamoff size = sheetFile.tellg();
+  if (size < static_cast<std::streamoff>(sizeof(SheetHeader)) ||
+      size > UINT32_MAX) {
+    return false;
+  }
+  std::vector<char> bytes(size);
+  sheetFile.seekg(0);
+  if (!sheetFile.read(bytes.data(), bytes.size())) {
+    return false;
+  }
+
+  const auto *h = reinterpret_cast<const SheetHeader *>(bytes.data());
+  if (h->magic != SHEET_MAGIC || h->version != SHEET_VERSION) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "SpriteSheet::loadSheet: not a version %d sheet",
+                 SHEET_VERSION);
+    return false;
+  }
+  // validate every section and the offsets into them once, so the lookups
+  // below don't need to bounds check
+  if (!fits<glm::ivec4>(bytes, h->rectsOffset, h->rectCount) ||
+      !fits<SheetAnimation>(bytes, h->animationsOffset, h->animationCount) ||
+      !fits<SheetFrame>(bytes, h->framesOffset, h->frameCount) ||
+      !fits<char>(bytes, h->stringsOffset, h->stringsSize) ||
+      h->texturePath >= h->stringsSize || h->rectCount == 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "SpriteSheet::loadSheet: sheet file is truncated");
+    return false;
+  }
+  const char *strings = bytes.data() + h->stringsOffset;
+  // the texture path is read as a c string
+  if (memchr(strings + h->texturePath, '\0',
+             h->stringsSize - h->texturePath) == nullptr) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "SpriteSheet::loadSheet: texture path isn't terminated");
+    return false;
+  }
 
-  // get the path (without file) from the atlas path
-  const std::string atlasPathStr = atlasPath;
-  const std::string atlasDir =
-      atlasPathStr.substr(0, atlasPathStr.find_last_of("/"));
+  // get the path (without file) from the sheet path
+  const std::string sheetPathStr = sheetPath;
+  const std::string sheetDir =
+      sheetPathStr.substr(0, sheetPathStr.find_last_of("/"));
 
   // load the texture
-  const std::string texturePath = atlasJson["texture"];
-  const std::string textureFullPath = (atlasDir + "/" + texturePath).c_str();
+  const std::string textureFullPath =
+      sheetDir + "/" + std::string(strings + h->texturePath);
   this->texture = std::make_shared<Texture>(textureFullPath.c_str());
   SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Texture loaded");
 
-  // load the atlas into memory as a single vector of ints
-  std::vector<int> temp = atlasJson["atlas"];
-  this->atlas = temp;
-  this->numRects = temp.size() / 4;
-
-  // load the animations
-  nlohmann::json animations = atlasJson["animations"];
-  for (auto &animation : animations.items()) {
-    const std::string name = animation.key();
-    const std::vector<int> frames = animation.value()["frames"];
-    const float frameTime = animation.value()["frameTime"];
-    const bool loop = animation.value()["loop"];
-
-    // get the wh (dimensions) of the first frame
+  // load the atlas rects
+  const auto *rects =
+      reinterpret_cast<const glm::ivec4 *>(bytes.data() + h->rectsOffset);
+  this->atlas.assign(rects, rects + h->rectCount);
 
-    const glm::vec4 rect = this->GetAtlasRect(frames[0]);
-    const glm::vec2 dimensions = glm::vec2(rect.z, rect.w);
+  // the default animation is always handle 0
+  this->addAnimation("default", {0}, {0.0f}, false);
 
-    this->animations[name] =
-        SpriteAnimation(frames, frameTime, dimensions, loop);
+  // load the animations
+  const auto *animations = reinterpret_cast<const SheetAnimation *>(
+      bytes.data() + h->animationsOffset);
+  const auto *frames =
+      reinterpret_cast<const SheetFrame *>(bytes.data() + h->framesOffset);
+  for (uint32_t i = 0; i < h->animationCount; i++) {
+    const auto &animation = animations[i];
+    bool valid = animation.frameCount > 0 &&
+                 inRange(animation.firstFrame, animation.frameCount,
+                         h->frameCount) &&
+                 inRange(animation.nameOffset, animation.nameLength,
+                         h->stringsSize);
+    std::vector<int> animationRects;
+    std::vector<float> durations;
+    for (uint32_t f = 0; valid && f < animation.frameCount; f++) {
+      const auto &frame = frames[animation.firstFrame + f];
+      valid = frame.rect < h->rectCount;
+      animationRects.push_back(frame.rect);
+      durations.push_back(frame.duration);
+    }
+    if (!valid) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "SpriteSheet::loadSheet: skipping bad animation %u", i);
+      continue;
+    }
+    this->addAnimation(
+        std::string(strings + animation.nameOffset, animation.nameLength),
+        animationRects, durations, animation.loop != 0);
   }
-  const glm::vec4 rect = this->GetAtlasRect(0);
-  const glm::vec2 dimensions = glm::vec2(rect.z, rect.w);
-  this->animations["default"] = SpriteAnimation({0}, 0.0f, dimensions, false);
+  return true;
 }
@@ -1,6 +1,6 @@
 #include "window.hpp"
 
-Window::Window(const char *title, int width, int height) {
+Window::Window(const char *title, int width, int height, Uint32 flags) {
   // Initialize SDL
   if (SDL_Init(SDL_INIT_VIDEO) < 0) {
     printf("Failed to init SDL!\n");
@@ -10,7 +10,7 @@ Window::Window(const char *title, int width, int height) {
   // Create SDL window
   window =
       SDL_CreateWindow(title, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-                       width, height, SDL_WINDOW_OPENGL);
+                       width, height, SDL_WINDOW_OPENGL | flags);
   SDL_Log("SDL window created");
 }
 
@@ -0,0 +1,78 @@
+#include "bit-stream.hpp"
+#include <algorithm>
+
+// bits of each size class of the variable length values
+static const int varBits[4] = {4, 8, 16, 32};
+
+static int varClass(uint32_t value) {
+  if (value < (1u << 4)) {
+    return 0;
+  }
+  if (value < (1u << 8)) {
+    return 1;
+  }
+  if (value < (1u << 16)) {
+    return 2;
+  }
+  return 3;
+}
+
+void BitWriter::Write(uint32_t value, int bits) {
+  for (int i = 0; i < bits;) {
+    const size_t offset = this->bits % 8;
+    if (offset == 0) {
+      this->data.push_back(0);
+    }
+    // as many bits as are left in the last byte
+    const int count = std::min<int>(8 - offset, bits - i);
+    const uint32_t chunk = (value >> i) & ((1u << count) - 1);
+    this->data.back() |= static_cast<uint8_t>(chunk << offset);
+    this->bits += count;
+    i += count;
+  }
+}
+
+void BitWriter::WriteVarUnsigned(uint32_t value) {
+  const int size = varClass(value);
+  this->Write(size, 2);
+  this->Write(value, varBits[size]);
+}
+
+void BitWriter::WriteVarSigned(int32_t value) {
+  const uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^
+                          static_cast<uint32_t>(value >> 31);
+  this->WriteVarUnsigned(zigzag);
+}
+
+void BitWriter::Clear() {
+  this->data.clear();
+  this->bits = 0;
+}
+
+uint32_t BitReader::Read(int bits) {
+  if (this->bits + bits > this->size * 8) {
+    this->overflowed = true;
+    this->bits = this->size * 8;
+    return 0;
+  }
+  uint32_t value = 0;
+  for (int i = 0; i < bits;) {
+    const size_t offset = this->bits % 8;
+    const int count = std::min<int>(8 - offset, bits - i);
+    const uint32_t chunk =
+        (this->data[this->bits / 8] >> offset) & ((1u << count) - 1);
+    value |= chunk << i;
+    this->bits += count;
+    i += count;
+  }
+  return value;
+}
+
+uint32_t BitReader::ReadVarUnsigned() {
+  return this->Read(varBits[this->Read(2)]);
+}
+
+int32_t BitReader::ReadVarSigned() {
+  const uint32_t zigzag = this->ReadVarUnsigned();
+  return static_cast<int32_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+}
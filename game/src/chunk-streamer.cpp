@@ -0,0 +1,213 @@
+#include "chunk-streamer.hpp"
+
+#include <bit>
+#include <cstring>
+
+ChunkStreamer::~ChunkStreamer() { this->Close(); }
+
+bool ChunkStreamer::Open(const char *path, const LevelHeader &header,
+                         uint8_t solidClass) {
+  this->Close();
+  this->file = SDL_RWFromFile(path, "rb");
+  if (this->file == nullptr) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "ChunkStreamer::Open: failed to open %s", path);
+    return false;
+  }
+  this->header = header;
+  this->solidClass = solidClass;
+  this->quit = false;
+#ifndef EMSCRIPTEN
+  this->worker = std::thread(&ChunkStreamer::run, this);
+#endif
+  return true;
+}
+
+void ChunkStreamer::Close() {
+#ifndef EMSCRIPTEN
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->quit = true;
+  }
+  this->wake.notify_all();
+  if (this->worker.joinable()) {
+    this->worker.join();
+  }
+#endif
+  this->requests.clear();
+  this->loaded.clear();
+  this->inFlight = 0;
+  if (this->file != nullptr) {
+    SDL_RWclose(this->file);
+    this->file = nullptr;
+  }
+}
+
+void ChunkStreamer::Request(uint32_t chunk) {
+#ifdef EMSCRIPTEN
+  std::unique_ptr<TilemapChunk> ready;
+  if (!this->spare.empty()) {
+    ready = std::move(this->spare.back());
+    this->spare.pop_back();
+  }
+  this->load(chunk, ready);
+  this->loaded.push_back(std::move(ready));
+#else
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->requests.push_back(chunk);
+    this->inFlight++;
+  }
+  this->wake.notify_one();
+#endif
+}
+
+void ChunkStreamer::Poll(std::vector<std::unique_ptr<TilemapChunk>> &out) {
+#ifndef EMSCRIPTEN
+  std::lock_guard<std::mutex> lock(this->mutex);
+#endif
+  for (auto &chunk : this->loaded) {
+    out.push_back(std::move(chunk));
+  }
+  this->loaded.clear();
+}
+
+void ChunkStreamer::Wait() {
+#ifndef EMSCRIPTEN
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->idle.wait(lock, [this] { return this->inFlight == 0; });
+#endif
+}
+
+void ChunkStreamer::Recycle(std::unique_ptr<TilemapChunk> chunk) {
+#ifndef EMSCRIPTEN
+  std::lock_guard<std::mutex> lock(this->mutex);
+#endif
+  this->spare.push_back(std::move(chunk));
+}
+
+#ifndef EMSCRIPTEN
+void ChunkStreamer::run() {
+  std::unique_lock<std::mutex> lock(this->mutex);
+  while (true) {
+    this->wake.wait(lock, [this] {
+      return this->quit || !this->requests.empty();
+    });
+    if (this->quit) {
+      return;
+    }
+    const uint32_t index = this->requests.front();
+    this->requests.pop_front();
+    std::unique_ptr<TilemapChunk> chunk;
+    if (!this->spare.empty()) {
+      chunk = std::move(this->spare.back());
+      this->spare.pop_back();
+    }
+
+    // the main thread only waits on the lock for the queues, not the read
+    lock.unlock();
+    this->load(index, chunk);
+    lock.lock();
+
+    this->loaded.push_back(std::move(chunk));
+    if (--this->inFlight == 0) {
+      this->idle.notify_all();
+    }
+  }
+}
+#endif
+
+void ChunkStreamer::load(uint32_t index,
+                         std::unique_ptr<TilemapChunk> &chunk) {
+  if (chunk == nullptr) {
+    chunk = std::make_unique<TilemapChunk>();
+  }
+  chunk->index = index;
+  chunk->gids.clear();
+  chunk->solidRects.clear();
+  memset(chunk->classes, 0, sizeof(chunk->classes));
+  memset(chunk->solidRows, 0, sizeof(chunk->solidRows));
+  chunk->firstSpawn = 0;
+  chunk->spawnCount = 0;
+
+  // read here instead of through the level's mapping, so the chunk table of
+  // a big world isn't paged in as the camera crosses it
+  LevelChunk entry;
+  const Sint64 entryOffset = this->header.chunksOffset +
+                             static_cast<Sint64>(index) * sizeof(LevelChunk);
+  if (SDL_RWseek(this->file, entryOffset, RW_SEEK_SET) != entryOffset ||
+      SDL_RWread(this->file, &entry, sizeof(entry), 1) != 1) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "ChunkStreamer: failed to read chunk %u", index);
+    return;
+  }
+  if (entry.spawnCount <= this->header.spawnCount &&
+      entry.firstSpawn <= this->header.spawnCount - entry.spawnCount) {
+    chunk->firstSpawn = entry.firstSpawn;
+    chunk->spawnCount = entry.spawnCount;
+  } else {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "ChunkStreamer: chunk %u has invalid spawns", index);
+  }
+  if (entry.dataIndex == LEVEL_EMPTY_CHUNK) {
+    return;
+  }
+
+  const size_t tiles = LEVEL_CHUNK_TILES * LEVEL_CHUNK_TILES;
+  const size_t gidBytes = this->header.layerCount * tiles * sizeof(uint32_t);
+  const size_t size = LEVEL_CHUNK_BYTES(this->header.layerCount);
+  const Sint64 offset = this->header.chunkDataOffset +
+                        static_cast<Sint64>(entry.dataIndex) * size;
+  this->readBuffer.resize(size);
+  if (SDL_RWseek(this->file, offset, RW_SEEK_SET) != offset ||
+      SDL_RWread(this->file, this->readBuffer.data(), 1, size) != size) {
+    // left empty so it isn't requested over and over
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "ChunkStreamer: failed to read chunk %u", index);
+    return;
+  }
+
+  chunk->gids.resize(this->header.layerCount * tiles);
+  memcpy(chunk->gids.data(), this->readBuffer.data(), gidBytes);
+  memcpy(chunk->classes, this->readBuffer.data() + gidBytes, tiles);
+
+  for (int y = 0; y < LEVEL_CHUNK_TILES && this->solidClass != 0; y++) {
+    for (int x = 0; x < LEVEL_CHUNK_TILES; x++) {
+      if (chunk->classes[x + y * LEVEL_CHUNK_TILES] == this->solidClass) {
+        chunk->solidRows[y] |= 1u << x;
+      }
+    }
+  }
+  this->mergeSolidTiles(*chunk);
+}
+
+void ChunkStreamer::mergeSolidTiles(TilemapChunk &chunk) const {
+  const int originX =
+      (chunk.index % this->header.chunkColumns) * LEVEL_CHUNK_TILES;
+  const int originY =
+      (chunk.index / this->header.chunkColumns) * LEVEL_CHUNK_TILES;
+  const int tileW = this->header.tileWidth;
+  const int tileH = this->header.tileHeight;
+
+  // tiles already covered by a rect are cleared from the copy
+  uint32_t open[LEVEL_CHUNK_TILES];
+  memcpy(open, chunk.solidRows, sizeof(open));
+
+  for (int y = 0; y < LEVEL_CHUNK_TILES; y++) {
+    while (open[y] != 0) {
+      // grow right as far as possible, then down while the whole span is open
+      const int x = std::countr_zero(open[y]);
+      const int w = std::countr_one(open[y] >> x);
+      const uint32_t span = (w == 32 ? ~0u : (1u << w) - 1) << x;
+      int rows = 1;
+      while (y + rows < LEVEL_CHUNK_TILES && (open[y + rows] & span) == span) {
+        rows++;
+      }
+      for (int j = y; j < y + rows; j++) {
+        open[j] &= ~span;
+      }
+      chunk.solidRects.push_back({(originX + x) * tileW, (originY + y) * tileH,
+                                  w * tileW, rows * tileH});
+    }
+  }
+}
@@ -6,8 +6,11 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <input.hpp>
+#include <plugins/camera.hpp>
 #include <plugins/graphics.hpp>
 #include <plugins/map.hpp>
+#include <plugins/pool.hpp>
+#include <plugins/timer.hpp>
 
 #include <utils.hpp>
 
@@ -54,77 +57,229 @@ int Game::init(SharedData *shared_data) {
 
   // map the text_input_buffer
   InputManager::SetTextInputBuffer(&shared_data->text_input_buffer[0]);
+  this->sharedData = shared_data;
+
+  this->seed = static_cast<uint32_t>(SDL_GetPerformanceCounter());
+  if (shared_data->input_mode == INPUT_REPLAY) {
+    if (!this->player.Load(shared_data->input_path)) {
+      shared_data->quit = true;
+      return 1;
+    }
+    this->seed = this->player.GetSeed();
+    SDL_Log("Replaying %u frames from %s", this->player.GetFrameCount(),
+            shared_data->input_path);
+  } else if (shared_data->input_mode == INPUT_RECORD) {
+    this->recorder.Begin(this->seed);
+  }
+  // with background streaming the spawns could come in a frame apart
+  Tilemap::SetDeterministicStreaming(shared_data->input_mode != INPUT_LIVE);
+
   // Get current window size
   int w, h;
   SDL_GetWindowSize(SDL_GL_GetCurrentWindow(), &w, &h);
   this->spriteBatcher = std::make_unique<SpriteBatch>(glm::vec2(w, h));
-  this->mixer = std::make_unique<Mixer>();
+  this->mixer = std::make_unique<Mixer>(this->audio);
 
 #ifndef EMSCRIPTEN
   this->mixer->ToggleMute();
 #endif
 
-  const auto tilemap = AssetManager<Tilemap>::get(RES_TILEMAP_DEMO);
-  world.set<Renderer>({.renderer = this->spriteBatcher.get()});
-  LoadLevel(this->world, tilemap);
+  this->world = this->getLevel(RES_TILEMAP_DEMO);
+  // so the first switch is warm too
+  this->levels.Prefetch(RES_TILEMAP_DEMO2, this->spriteBatcher.get(),
+                        this->timestep);
+  this->lastFrame = SDL_GetPerformanceCounter();
 
   return 0;
 }
 
+flecs::world *Game::getLevel(const std::string &path) {
+  auto *level = this->levels.Get(path, this->spriteBatcher.get(),
+                                 this->timestep);
+  if (!level->has<Random>()) {
+    level->set<Random>({std::minstd_rand(this->seed)});
+  }
+  return level;
+}
+
 int Game::update() {
+  if (this->sharedData->quit) {
+    return 0; // the host exits after this frame
+  }
+
+  const Uint64 now = SDL_GetPerformanceCounter();
+  float frameDelta =
+      static_cast<float>(now - this->lastFrame) / SDL_GetPerformanceFrequency();
+  this->lastFrame = now;
+
   int num_keys;
   const Uint8 *key_state = SDL_GetKeyboardState(&num_keys);
-  InputManager::Update(key_state, num_keys);
 
-  if (InputManager::GetKey(SDL_SCANCODE_RETURN).IsJustPressed()) {
-    InputManager::ToggleTextInput();
-  };
+  if (this->player.IsPlaying()) {
+    // the wall clock time of the last replayed frame, the simulation gets the
+    // recorded one
+    if (this->player.GetFramesPlayed() > 0) {
+      this->replayStats.frameTimes.push_back(frameDelta * 1000.0f);
+    }
+    InputFrame frame;
+    if (!this->player.Next(frame)) {
+      this->settleRollback();
+      this->replayStats.Report(this->sharedData->input_path,
+                               HashWorldState(*this->world));
+      this->sharedData->quit = true;
+      return 0;
+    }
+    frameDelta = frame.frameDelta;
+    key_state = frame.keyState;
+    num_keys = SDL_NUM_SCANCODES;
+    SDL_strlcpy(this->sharedData->text_input_buffer, frame.text,
+                TEXT_BUFFER_SIZE);
+  } else {
+    this->recorder.Record(frameDelta, key_state, num_keys,
+                          this->sharedData->text_input_buffer);
+  }
+
+  // only sample new input once a tick has seen the last sample, otherwise a
+  // press on a frame without a tick would be lost
+  if (this->inputConsumed) {
+    InputManager::Update(key_state, num_keys);
+    this->sharedData->timing.sampled = SDL_GetPerformanceCounter();
 
-  // mute audio
-  if (!InputManager::IsTextInputActive()) {
-    if (InputManager::GetKey(SDL_SCANCODE_1).IsJustPressed()) {
-      this->drawColliders = !this->drawColliders;
+    if (InputManager::GetKey(SDL_SCANCODE_RETURN).IsJustPressed()) {
+      InputManager::ToggleTextInput();
     };
-    if (InputManager::GetKey(SDL_SCANCODE_M).IsJustPressed()) {
-      this->mixer->ToggleMute();
+
+    // mute audio
+    if (!InputManager::IsTextInputActive()) {
+      if (InputManager::GetKey(SDL_SCANCODE_1).IsJustPressed()) {
+        this->drawColliders = !this->drawColliders;
+      };
+      if (InputManager::GetKey(SDL_SCANCODE_M).IsJustPressed()) {
+        this->mixer->ToggleMute();
+      }
     }
-  }
 
-  if (InputManager::GetKey(SDL_SCANCODE_F1).IsJustPressed()) {
-    this->level1 = !this->level1;
-    LoadLevel(this->world, this->level1
-                               ? AssetManager<Tilemap>::get(RES_TILEMAP_DEMO)
-                               : AssetManager<Tilemap>::get(RES_TILEMAP_DEMO2));
-    return 0;
-  }
+    if (InputManager::GetKey(SDL_SCANCODE_F1).IsJustPressed()) {
+      this->settleRollback();
+      this->level1 = !this->level1;
+      this->world =
+          this->getLevel(this->level1 ? RES_TILEMAP_DEMO : RES_TILEMAP_DEMO2);
+      return 0;
+    }
 
 #ifdef SHARED_GAME
-  if (InputManager::GetKey(SDL_SCANCODE_F5).IsJustPressed()) {
-    std::string path = "../../";
-    std::string demoPath = path + RES_TILEMAP_DEMO;
-    std::string demo2Path = path + RES_TILEMAP_DEMO2;
-    // hot reload assets
-    LoadLevel(this->world, this->level1
-                               ? AssetManager<Tilemap>::get(demoPath.c_str())
-                               : AssetManager<Tilemap>::get(demo2Path.c_str()));
-    return 0;
-  }
+    if (InputManager::GetKey(SDL_SCANCODE_F5).IsJustPressed()) {
+      std::string path = "../../";
+      // hot reload assets, from the source tree but cached under the same
+      // path as before so switching levels keeps the reloaded one
+      const std::string levelPath =
+          this->level1 ? RES_TILEMAP_DEMO : RES_TILEMAP_DEMO2;
+      this->settleRollback();
+      this->levels.Reload(levelPath, path + levelPath,
+                          this->spriteBatcher.get(), this->timestep);
+      this->world = this->getLevel(levelPath);
+      return 0;
+    }
 #endif
+  }
+
+  // the settings can be changed at runtime
+  this->world->get_mut<FixedTimestep>()->settings = this->timestep;
+
+  // catch up ticks resample the input so a press is only seen by one tick
+  const auto resample = [key_state, num_keys]() {
+    InputManager::Update(key_state, num_keys);
+  };
+  if (this->sharedData->rollback_ticks > 0 && !this->rollback) {
+    this->startRollback();
+  }
+  const int ticks =
+      this->rollback
+          ? StepWorld(*this->world, frameDelta, resample,
+                      [this](float) { this->stepRollback(); })
+          : StepWorld(*this->world, frameDelta, resample);
+  this->inputConsumed = ticks > 0;
+  this->sharedData->timing.simulated = SDL_GetPerformanceCounter();
 
-  this->world.progress();
+  // positional sounds are culled around the camera
+  const auto listener = this->world->get<Camera>()->position;
+  VoicePool::SetListener(listener.x, listener.y);
 
   if (this->drawColliders) {
-    DrawColliders(this->world, this->spriteBatcher.get());
+    DrawColliders(*this->world, this->spriteBatcher.get());
   }
   // draw all sprites in the batch
   this->spriteBatcher->Flush();
+  this->sharedData->timing.submitted = SDL_GetPerformanceCounter();
 
   return 0;
 }
 
+void Game::startRollback() {
+  this->rollbackWorld = std::make_unique<RollbackWorld>(*this->world);
+  // the singletons the ticks change
+  this->rollbackWorld->Track<Random>();
+  this->rollbackWorld->Track<Timers>();
+  this->rollbackWorld->Track<EntityPool>();
+  // the swept movers hit the static bodies of the tick before
+  this->rollbackWorld->Track<Broadphase>();
+  this->rollbackWorld->Track<SpawnState>();
+  // the chunks the camera streamed, the ticks spawn what came with them
+  this->rollbackWorld->TrackBetweenTicks<StreamedChunks>();
+
+  this->lateTicks =
+      glm::clamp(this->sharedData->rollback_ticks, 1, ROLLBACK_HISTORY - 2);
+  // no frame budget, the benchmark measures the cost instead of avoiding it
+  const RollbackSettings settings = {2, 1, this->lateTicks + 1, 0.0f,
+                                     DEFAULT_ROLLBACK_CHECKSUM_INTERVAL};
+  this->rollback =
+      std::make_unique<RollbackSession>(*this->rollbackWorld, settings);
+  this->lateInputs.clear();
+  SDL_Log("Rollback with the input %d ticks late", this->lateTicks);
+}
+
+void Game::stepRollback() {
+  const RollbackInput input = InputManager::GetSnapshot().actionsDown;
+  const uint32_t tick = this->rollback->GetTick();
+  Tilemap &map = *this->world->get<Map>()->value;
+  this->streamEpochs[tick % ROLLBACK_HISTORY] = map.GetStreamEpoch();
+  const uint32_t oldest =
+      tick >= ROLLBACK_HISTORY - 1 ? tick - (ROLLBACK_HISTORY - 1) : 0;
+  map.PinEpoch(this->streamEpochs[oldest % ROLLBACK_HISTORY]);
+  this->rollback->AddLocalInput(input);
+  this->lateInputs.push_back({tick, input});
+  while (this->lateInputs.front().first + this->lateTicks <= tick) {
+    this->rollback->AddRemoteInput(0, this->lateInputs.front().first,
+                                   this->lateInputs.front().second);
+    this->lateInputs.pop_front();
+  }
+  if (!this->rollback->AdvanceTick()) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Rollback stalled at tick %u",
+                 tick);
+  }
+}
+
+void Game::settleRollback() {
+  if (!this->rollback) {
+    return;
+  }
+  for (const auto &[tick, input] : this->lateInputs) {
+    this->rollback->AddRemoteInput(0, tick, input);
+  }
+  this->lateInputs.clear();
+  this->rollback->Rollback();
+  this->world->get<Map>()->value->PinEpoch(TILEMAP_NO_PIN);
+  this->rollback->GetStats().Report();
+  this->rollback.reset();
+  this->rollbackWorld.reset();
+}
+
 int Game::unload() { return 0; }
 
 int Game::close() {
+  if (this->recorder.IsRecording()) {
+    this->recorder.Save(this->sharedData->input_path);
+  }
   // clean up gl stuff
   return 0;
 }
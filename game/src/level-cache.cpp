@@ -0,0 +1,92 @@
+#include "level-cache.hpp"
+
+#include <SDL.h>
+#include <algorithm>
+#include <asset-manager.hpp>
+#include <plugins/graphics.hpp>
+#include <plugins/map.hpp>
+#include <tilemap.hpp>
+
+LevelCache::LevelCache(size_t capacity)
+    : capacity(std::max(capacity, size_t(1))), useCount(0), active(nullptr) {}
+
+flecs::world *LevelCache::Get(const std::string &path, SpriteBatch *renderer,
+                              TimestepSettings settings) {
+  const Uint64 start = SDL_GetPerformanceCounter();
+  Level *level = this->find(path);
+  const bool resident = level != nullptr;
+  if (!resident) {
+    level = &this->load(path, path, renderer, settings);
+  }
+  level->lastUsed = ++this->useCount;
+  // only the level being played keeps worker threads, StepWorld starts them
+  // again when a level is played after a switch
+  if (this->active != nullptr && this->active != level->world.get()) {
+    this->active->set_threads(1);
+  }
+  this->active = level->world.get();
+
+  const double ms = static_cast<double>(SDL_GetPerformanceCounter() - start) *
+                    1000.0 / SDL_GetPerformanceFrequency();
+  SDL_Log("Switched to %s in %.3fms (%s)", path.c_str(), ms,
+          resident ? "warm" : "cold");
+  return level->world.get();
+}
+
+void LevelCache::Prefetch(const std::string &path, SpriteBatch *renderer,
+                          TimestepSettings settings) {
+  if (this->find(path) == nullptr) {
+    this->load(path, path, renderer, settings);
+  }
+}
+
+void LevelCache::Reload(const std::string &path, const std::string &source,
+                        SpriteBatch *renderer, TimestepSettings settings) {
+  // dropping the resident level first frees the old map
+  std::erase_if(this->levels, [this, &path](const Level &level) {
+    if (level.path != path) {
+      return false;
+    }
+    this->forget(level);
+    return true;
+  });
+  this->load(path, source, renderer, settings).lastUsed = ++this->useCount;
+}
+
+void LevelCache::forget(const Level &level) {
+  // a destroyed world joins its own worker threads
+  if (this->active == level.world.get()) {
+    this->active = nullptr;
+  }
+}
+
+LevelCache::Level *LevelCache::find(const std::string &path) {
+  for (auto &level : this->levels) {
+    if (level.path == path) {
+      return &level;
+    }
+  }
+  return nullptr;
+}
+
+LevelCache::Level &LevelCache::load(const std::string &path,
+                                    const std::string &source,
+                                    SpriteBatch *renderer,
+                                    TimestepSettings settings) {
+  if (this->levels.size() >= this->capacity) {
+    const auto oldest = std::min_element(
+        this->levels.begin(), this->levels.end(),
+        [](const Level &a, const Level &b) { return a.lastUsed < b.lastUsed; });
+    SDL_Log("Evicting level %s", oldest->path.c_str());
+    this->forget(*oldest);
+    this->levels.erase(oldest);
+  }
+
+  auto world = std::make_unique<flecs::world>();
+  world->set<Renderer>({.renderer = renderer});
+  world->set<FixedTimestep>({.settings = settings});
+  LoadLevel(*world, AssetManager<Tilemap>::get(source));
+
+  this->levels.push_back({path, std::move(world), 0});
+  return this->levels.back();
+}
@@ -0,0 +1,121 @@
+#ifndef EMSCRIPTEN
+#include "local-signaling.hpp"
+#include <SDL2/SDL_log.h>
+#include <algorithm>
+#include <nlohmann/json.hpp>
+
+using nlohmann::json;
+
+LocalSignalingServer::LocalSignalingServer(uint16_t port) {
+  rtc::WebSocketServer::Configuration config;
+  config.port = port;
+  config.enableTls = false;
+  config.bindAddress = "127.0.0.1";
+  this->server = std::make_unique<rtc::WebSocketServer>(config);
+
+  this->server->onClient([this](std::shared_ptr<rtc::WebSocket> ws) {
+    std::string id;
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      id = "peer" + std::to_string(this->nextClient++);
+      this->clients[id] = {ws, ""};
+    }
+    ws->onMessage([this, id](auto data) {
+      if (std::holds_alternative<std::string>(data)) {
+        this->onMessage(id, std::get<std::string>(data));
+      }
+    });
+    ws->onClosed([this, id]() { this->onClosed(id); });
+  });
+  SDL_Log("Local signaling on %s\n", this->getUrl().c_str());
+}
+
+LocalSignalingServer::~LocalSignalingServer() {
+  this->server->stop();
+  std::lock_guard<std::mutex> lock(this->mutex);
+  // no callbacks into this once it is gone
+  for (auto &[id, client] : this->clients) {
+    client.ws->resetCallbacks();
+    client.ws->close();
+  }
+  this->clients.clear();
+}
+
+uint16_t LocalSignalingServer::getPort() const { return this->server->port(); }
+
+std::string LocalSignalingServer::getUrl() const {
+  return "ws://127.0.0.1:" + std::to_string(this->getPort());
+}
+
+bool LocalSignalingServer::hasRoom(const std::string &code) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->rooms.find(code) != this->rooms.end();
+}
+
+void LocalSignalingServer::send(const std::string &id,
+                                const std::string &message) {
+  if (auto it = this->clients.find(id); it != this->clients.end()) {
+    it->second.ws->send(message);
+  }
+}
+
+void LocalSignalingServer::onMessage(const std::string &id,
+                                     const std::string &text) {
+  json message = json::parse(text, nullptr, false);
+  if (message.is_discarded() || !message.contains("type")) {
+    return;
+  }
+  const std::string type = message["type"].get<std::string>();
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto it = this->clients.find(id);
+  if (it == this->clients.end()) {
+    return;
+  }
+  Client &client = it->second;
+  if (type == "host") {
+    const std::string code = std::to_string(1000 + this->nextRoom++);
+    this->rooms[code].push_back(id);
+    client.room = code;
+    this->send(id, json({{"type", "roomCode"}, {"roomCode", code}}).dump());
+  } else if (type == "join") {
+    const std::string code = message.value("roomCode", "");
+    auto room = this->rooms.find(code);
+    if (room == this->rooms.end()) {
+      this->send(id, json({{"type", "exception"},
+                           {"message", "no room " + code}})
+                         .dump());
+      return;
+    }
+    // the newcomer offers to everyone already there
+    for (const std::string &peer : room->second) {
+      this->send(id, json({{"type", "requestOffer"}, {"id", peer}}).dump());
+    }
+    room->second.push_back(id);
+    client.room = code;
+  } else if (message.contains("id")) {
+    // offer, answer or candidate, from id to the peer it names
+    const std::string to = message["id"].get<std::string>();
+    message["id"] = id;
+    this->send(to, message.dump());
+  }
+}
+
+void LocalSignalingServer::onClosed(const std::string &id) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto it = this->clients.find(id);
+  if (it == this->clients.end()) {
+    return;
+  }
+  if (auto room = this->rooms.find(it->second.room);
+      room != this->rooms.end()) {
+    auto &members = room->second;
+    members.erase(std::remove(members.begin(), members.end(), id),
+                  members.end());
+    if (members.empty()) {
+      this->rooms.erase(room);
+    }
+  }
+  this->clients.erase(it);
+}
+#endif
@@ -0,0 +1,230 @@
+#include "net-transport.hpp"
+#include <SDL2/SDL.h>
+#include <algorithm>
+
+double NetWallClock() {
+  return static_cast<double>(SDL_GetPerformanceCounter()) /
+         static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+bool LinkConditioner::Schedule(double now, size_t bytes, double &arrival) {
+  this->stats.sent++;
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  if (unit(this->random) < this->conditions.loss) {
+    this->stats.dropped++;
+    return false;
+  }
+
+  // one message on the wire at a time, the rest wait their turn
+  double departure = now;
+  if (this->conditions.bandwidthKbps > 0.0f) {
+    const double start = std::max(now, this->linkFree);
+    if (this->conditions.queueMs > 0.0f &&
+        start - now > this->conditions.queueMs / 1000.0) {
+      this->stats.dropped++;
+      return false;
+    }
+    departure =
+        start + bytes * 8.0 / (this->conditions.bandwidthKbps * 1000.0);
+    this->linkFree = departure;
+  }
+
+  const float jitter =
+      (unit(this->random) * 2.0f - 1.0f) * this->conditions.jitterMs;
+  const float delayMs = std::max(this->conditions.latencyMs + jitter, 0.0f);
+  arrival = departure + delayMs / 1000.0;
+  this->stats.bytes += bytes;
+  return true;
+}
+
+static bool arrivesLater(const NetInbox::Delivery &a,
+                         const NetInbox::Delivery &b) {
+  return a.arrival != b.arrival ? a.arrival > b.arrival : a.order > b.order;
+}
+
+void NetInbox::Push(Delivery delivery) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  delivery.order = this->pushed++;
+  this->heap.push_back(std::move(delivery));
+  std::push_heap(this->heap.begin(), this->heap.end(), arrivesLater);
+}
+
+void NetInbox::PopDue(double now, std::vector<Delivery> &out) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  while (!this->heap.empty() && this->heap.front().arrival <= now) {
+    std::pop_heap(this->heap.begin(), this->heap.end(), arrivesLater);
+    out.push_back(std::move(this->heap.back()));
+    this->heap.pop_back();
+  }
+}
+
+// runs the callbacks of the deliveries, the callbacks may be unset
+static void deliver(std::vector<NetInbox::Delivery> &due,
+                    const std::function<void(std::string)> &onConnection,
+                    const std::function<void(std::string, std::string)>
+                        &onMessage,
+                    const std::function<void(
+                        std::string, const std::vector<uint8_t> &)> &onBinary) {
+  for (auto &delivery : due) {
+    switch (delivery.kind) {
+    case NetInbox::CONNECTION:
+      if (onConnection) {
+        onConnection(delivery.peer);
+      }
+      break;
+    case NetInbox::MESSAGE:
+      if (onMessage) {
+        onMessage(delivery.peer, delivery.message);
+      }
+      break;
+    case NetInbox::BINARY:
+      if (onBinary) {
+        onBinary(delivery.peer, delivery.data);
+      }
+      break;
+    }
+  }
+  due.clear();
+}
+
+ConditionedTransport::ConditionedTransport(std::unique_ptr<NetTransport> inner,
+                                           const LinkConditions &conditions,
+                                           uint32_t seed, NetClock clock)
+    : clock(clock), conditioner(conditions, seed), inner(std::move(inner)) {
+  this->inner->setCallbacks(
+      [this](std::string peer) {
+        this->receive(NetInbox::CONNECTION, peer, {}, {});
+      },
+      [this](std::string peer, std::string message) {
+        this->receive(NetInbox::MESSAGE, peer, message, {});
+      },
+      [this](std::string peer, const std::vector<uint8_t> &data) {
+        this->receive(NetInbox::BINARY, peer, {}, data);
+      });
+}
+
+void ConditionedTransport::receive(NetInbox::Kind kind, std::string peer,
+                                   std::string message,
+                                   std::vector<uint8_t> data) {
+  const double now = this->clock();
+  double arrival = now;
+  // connections aren't lost or delayed, only what goes over them
+  if (kind != NetInbox::CONNECTION) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->conditioner.Schedule(now, message.size() + data.size(),
+                                    arrival)) {
+      return;
+    }
+  }
+  this->inbox.Push({arrival, 0, kind, peer, message, std::move(data)});
+}
+
+void ConditionedTransport::poll() {
+  this->inner->poll();
+  this->inbox.PopDue(this->clock(), this->due);
+  deliver(this->due, this->onConnection, this->onMessage, this->onBinary);
+}
+
+LinkStats ConditionedTransport::GetStats() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->conditioner.GetStats();
+}
+
+LoopbackNetwork::LoopbackNetwork(const LinkConditions &conditions,
+                                 uint32_t seed, NetClock clock)
+    : conditions(conditions), seed(seed), clock(clock) {}
+
+void LoopbackNetwork::SetConditions(const LinkConditions &conditions) {
+  this->conditions = conditions;
+  for (auto &[name, link] : this->links) {
+    link.SetConditions(conditions);
+  }
+}
+
+std::unique_ptr<LoopbackTransport>
+LoopbackNetwork::CreatePeer(const std::string &id) {
+  return std::make_unique<LoopbackTransport>(this, id);
+}
+
+LinkStats LoopbackNetwork::GetStats() const {
+  LinkStats total = {};
+  for (const auto &[name, link] : this->links) {
+    total.sent += link.GetStats().sent;
+    total.dropped += link.GetStats().dropped;
+    total.bytes += link.GetStats().bytes;
+  }
+  return total;
+}
+
+void LoopbackNetwork::join(LoopbackTransport *peer) {
+  if (std::find(this->peers.begin(), this->peers.end(), peer) !=
+      this->peers.end()) {
+    return;
+  }
+  this->peers.push_back(peer);
+  // both ends hear about the connection after the link latency
+  for (LoopbackTransport *other : this->peers) {
+    if (other != peer) {
+      this->send(peer, other->id, NetInbox::CONNECTION, {}, {});
+      this->send(other, peer->id, NetInbox::CONNECTION, {}, {});
+    }
+  }
+}
+
+void LoopbackNetwork::leave(LoopbackTransport *peer) {
+  this->peers.erase(std::remove(this->peers.begin(), this->peers.end(), peer),
+                    this->peers.end());
+}
+
+void LoopbackNetwork::send(LoopbackTransport *from, const std::string &to,
+                           NetInbox::Kind kind, std::string message,
+                           std::vector<uint8_t> data) {
+  const auto peer =
+      std::find_if(this->peers.begin(), this->peers.end(),
+                   [&to](LoopbackTransport *p) { return p->id == to; });
+  if (peer == this->peers.end()) {
+    return;
+  }
+
+  auto link = this->links.find(from->id + ">" + to);
+  if (link == this->links.end()) {
+    // every link gets its own random stream, so adding a peer doesn't change
+    // what the others lose
+    const uint32_t linkSeed =
+        this->seed ^ static_cast<uint32_t>(std::hash<std::string>()(
+                         from->id + ">" + to));
+    link = this->links
+               .emplace(from->id + ">" + to,
+                        LinkConditioner(this->conditions, linkSeed))
+               .first;
+  }
+
+  const double now = this->clock();
+  double arrival = now;
+  if (kind == NetInbox::CONNECTION) {
+    // never lost, only late
+    arrival = now + this->conditions.latencyMs / 1000.0;
+  } else if (!link->second.Schedule(now, message.size() + data.size(),
+                                    arrival)) {
+    return;
+  }
+  (*peer)->inbox.Push({arrival, 0, kind, from->id, message, std::move(data)});
+}
+
+LoopbackTransport::~LoopbackTransport() { this->network->leave(this); }
+
+void LoopbackTransport::connect() { this->network->join(this); }
+
+void LoopbackTransport::sendTo(std::string id, std::string message) {
+  this->network->send(this, id, NetInbox::MESSAGE, message, {});
+}
+
+void LoopbackTransport::sendBinaryTo(std::string id,
+                                     const std::vector<uint8_t> &data) {
+  this->network->send(this, id, NetInbox::BINARY, {}, data);
+}
+
+void LoopbackTransport::poll() {
+  this->inbox.PopDue(this->network->clock(), this->due);
+  deliver(this->due, this->onConnection, this->onMessage, this->onBinary);
+}
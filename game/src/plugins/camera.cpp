@@ -3,16 +3,16 @@
 #include "plugins/player.hpp"
 
 void CameraPlugin::addSystems(flecs::world &world) {
-  const auto playerQuery =
-      world.query<Transform2D, Player>(); // note this has to be declared
-  // outside for emscripten
-
-  world.system<Camera>().iter([playerQuery](flecs::iter it, Camera *c) {
-    playerQuery.each([&c](Transform2D &t, Player &p) {
-      const auto playerRect = p.defaultRect;
+  world.system<Camera>().kind<RenderPhase>().iter([](flecs::iter it,
+                                                     Camera *c) {
+    const auto target = c[0].target;
+    if (target && target.is_alive()) {
+      const auto *t = target.get<Transform2D>();
+      const auto *p = target.get<Player>();
+      const auto playerRect = p->defaultRect;
       glm::vec2 offset = glm::vec2(playerRect.z, playerRect.w) / 2.0f;
-      c[0].position = t.position + offset;
-    });
+      c[0].position = t->render_position + offset;
+    }
 
     Tilemap *m = it.world().get<Map>()->value.get();
     SpriteBatch *r = it.world().get<Renderer>()->renderer;
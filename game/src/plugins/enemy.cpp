@@ -1,37 +1,39 @@
 #include "plugins/enemy.hpp"
 
-void enemyUpdate(Enemy &e, Velocity &v, Path &p, Transform2D &t) {
-  // move towards target point if we are within distance 0.1f,
-  // update the target point
-  const auto targetPoint = p.points[p.targetPointIndex];
-  const auto distance = fabs(glm::distance(t.position, targetPoint));
+void enemyUpdate(const PathTable &paths, int count, Velocity *v, Path *p,
+                 Transform2D *t, Sprite *s) {
   const float speed = 100.0f;
+  for (int i = 0; i < count; i++) {
+    // move towards target point if we are within distance 0.1f,
+    // update the target point
+    const auto &route = paths.routes[p[i].route];
+    const auto targetPoint =
+        paths.points[route.firstPoint + p[i].targetPointIndex];
+    const auto distance = fabs(glm::distance(t[i].position, targetPoint));
 
-  if (distance < 1.0f) {
-    p.targetPointIndex++;
-    if (p.targetPointIndex >= p.points.size()) {
-      p.targetPointIndex = 0;
-      return;
+    if (distance < 1.0f) {
+      p[i].targetPointIndex++;
+      if (p[i].targetPointIndex >= route.pointCount) {
+        p[i].targetPointIndex = 0;
+        continue;
+      }
     }
-  }
 
-  const auto direction = glm::normalize(targetPoint - t.position);
-  if (direction.x < 0) {
-    t.scale.x = -1 * fabs(t.scale.x);
-  } else {
-    t.scale.x = fabs(t.scale.x);
+    const auto direction = glm::normalize(targetPoint - t[i].position);
+    s[i].flipX = direction.x < 0;
+    v[i].value = direction * speed;
   }
-  v.value = direction * speed;
 }
 
 void EnemyPlugin::addSystems(flecs::world &world) {
-  // enemy movement
-  world.system<Enemy, Velocity, Path, Transform2D>().iter(
-      ([](flecs::iter it, Enemy *e, Velocity *v, Path *p, Transform2D *t) {
-        const auto dt = it.delta_time();
-
-        for (int i : it) {
-          enemyUpdate(e[i], v[i], p[i], t[i]);
-        }
-      }));
+  // enemy movement, a batch per table over the component arrays
+  world.system<Velocity, Path, Transform2D, Sprite>()
+      .kind<SimulationPhase>()
+      .multi_threaded()
+      .term<Enemy>()
+      .iter([](flecs::iter it, Velocity *v, Path *p, Transform2D *t,
+               Sprite *s) {
+        const PathTable &paths = *it.world().get<PathTable>();
+        enemyUpdate(paths, it.count(), v, p, t, s);
+      });
 }
@@ -1,18 +1,25 @@
 #include "plugins/graphics.hpp"
 
+// the sprite's facing applied on top of the global scale
+static glm::vec2 facingScale(const Transform2D &t, bool flipX) {
+  return t.global_scale * glm::vec2(flipX ? -1.0f : 1.0f, 1.0f);
+}
+
 void renderSprite(SpriteBatch *renderer, Transform2D &t, Sprite &s) {
-  renderer->Draw(s.texture.get(), t.global_position, t.scale, t.rotation);
+  renderer->Draw(s.texture.get(), t.render_position, facingScale(t, s.flipX),
+                 t.global_rotation);
 }
 
-void renderAnimatedSprite(SpriteBatch *renderer, float delta, Transform2D &t,
-                          AnimatedSprite &s) {
+void advanceAnimation(AnimatedSprite &s, float delta) {
+  const SpriteAnimation &animation = s.GetAnimation();
+  const float frameTime =
+      s.spriteSheet->GetFrame(animation, s.currentFrame).duration;
   s.currentTime += delta;
-  if (!s.isAnimationFinished &&
-      s.currentTime >= s.currentAnimation->frameTime) {
-    s.currentTime -= s.currentAnimation->frameTime;
+  if (!s.isAnimationFinished && s.currentTime >= frameTime) {
+    s.currentTime -= frameTime;
     s.currentFrame++;
-    if (s.currentFrame >= s.currentAnimation->frames.size()) {
-      if (!s.currentAnimation->loop) {
+    if (s.currentFrame >= static_cast<int>(animation.frameCount)) {
+      if (!animation.loop) {
         s.isAnimationFinished = true;
         s.currentFrame--;
         return;
@@ -20,26 +27,35 @@ void renderAnimatedSprite(SpriteBatch *renderer, float delta, Transform2D &t,
       s.currentFrame = 0;
     }
   }
-  renderer->Draw(
-      s.spriteSheet->GetTexture(), t.global_position, t.scale, t.rotation,
-      glm::vec4(1, 1, 1, 1),
-      s.spriteSheet->GetAnimationRect(s.currentAnimation, s.currentFrame),
-      s.currentAnimation->dimensions);
 }
 
-void renderUIFilledRect(SpriteBatch *renderer, Transform2D &t,
-                        UIFilledRect &u) {
-  renderer->DrawRect(glm::vec4(t.global_position.x - u.outline_thickness,
-                               t.global_position.y - u.outline_thickness,
+void renderAnimatedSprite(SpriteBatch *renderer, const Transform2D &t,
+                          const AnimatedSprite &s) {
+  const SpriteAnimation &animation = s.GetAnimation();
+  const SpriteFrame &frame = s.spriteSheet->GetFrame(animation, s.currentFrame);
+  renderer->DrawUV(s.spriteSheet->GetTexture(), t.render_position, frame.size,
+                   frame.uvRect, facingScale(t, s.flipX), t.global_rotation,
+                   glm::vec4(1, 1, 1, 1), animation.dimensions);
+}
+
+static void drawFilledRect(SpriteBatch *renderer, glm::vec2 position,
+                           const UIFilledRect &u) {
+  renderer->DrawRect(glm::vec4(position.x - u.outline_thickness,
+                               position.y - u.outline_thickness,
                                u.dimensions.x + u.outline_thickness * 2,
                                u.dimensions.y + u.outline_thickness * 2),
                      u.bg_color);
-  renderer->DrawRect(glm::vec4(t.global_position.x, t.global_position.y,
+  renderer->DrawRect(glm::vec4(position.x, position.y,
                                u.percent * u.dimensions.x, u.dimensions.y),
                      u.fill_color);
 }
 
-void renderAdjustingTextBox(SpriteBatch *renderer, Transform2D &t,
+void renderUIFilledRect(SpriteBatch *renderer, Transform2D &t,
+                        UIFilledRect &u) {
+  drawFilledRect(renderer, t.render_position, u);
+}
+
+void renderAdjustingTextBox(SpriteBatch *renderer, const Transform2D &t,
                             UIFilledRect &u, AdjustingTextBox &b) {
   // the max width is 128
   const auto max_width = 128.0f;
@@ -47,36 +63,55 @@ void renderAdjustingTextBox(SpriteBatch *renderer, Transform2D &t,
   const int fontSize = b.font->GetFontSize();
   const int rowSpacing = fontSize * 0.75f;
 
-  // set the position of the rendered text
-  const auto tPos = glm::vec2(t.global_position.x + rowSpacing / 2,
-                              t.global_position.y + rowSpacing / 2);
+  // raised by the height of the text when drawn, the transform is left to
+  // the simulation
+  const auto position = t.render_position - glm::vec2(0, u.dimensions.y);
+  drawFilledRect(renderer, position, u);
+  renderer->Flush();
 
-  b.font->RenderText(renderer, b.text, tPos, t.scale, glm::vec4(0, 0, 0, 1),
-                     &u.dimensions, max_width);
+  // set the position of the rendered text
+  const auto tPos = glm::vec2(position.x + rowSpacing / 2,
+                              position.y + rowSpacing / 2);
 
-  // change the transform offset to be -36 - the height of the text
-  t.position.y = -36 - u.dimensions.y;
+  b.font->RenderText(renderer, b.text, tPos, t.global_scale,
+                     glm::vec4(0, 0, 0, 1), &u.dimensions, max_width);
 }
 
 void GraphicsPlugin::addSystems(flecs::world &ecs) {
   SpriteBatch *r = ecs.get<Renderer>()->renderer;
 
-  ecs.system<Transform2D, AnimatedSprite>().iter(
-      [r](flecs::iter it, Transform2D *t, AnimatedSprite *s) {
+  // the animations play with the ticks, the gameplay waits on them finishing
+  ecs.system<AnimatedSprite>()
+      .kind<SimulationPhase>()
+      .multi_threaded()
+      .iter([](flecs::iter it, AnimatedSprite *s) {
         for (int i : it) {
-          renderAnimatedSprite(r, it.delta_time(), t[i], s[i]);
+          advanceAnimation(s[i], it.delta_time());
         }
       });
 
-  ecs.system<Transform2D, Sprite>().each(
+  ecs.system<const Transform2D, const AnimatedSprite>()
+      .kind<RenderPhase>()
+      .each([r](const Transform2D &t, const AnimatedSprite &s) {
+        renderAnimatedSprite(r, t, s);
+      });
+
+  ecs.system<Transform2D, Sprite>().kind<RenderPhase>().each(
       [r](Transform2D &t, Sprite &s) { renderSprite(r, t, s); });
 
-  ecs.system<Transform2D, UIFilledRect>().each(
-      [r](Transform2D &t, UIFilledRect &u) { renderUIFilledRect(r, t, u); });
+  // the text boxes draw their own, they move with their text
+  ecs.system<Transform2D, UIFilledRect>()
+      .kind<RenderPhase>()
+      .term<AdjustingTextBox>()
+      .not_()
+      .each([r](Transform2D &t, UIFilledRect &u) {
+        renderUIFilledRect(r, t, u);
+      });
 
-  ecs.system<Transform2D, UIFilledRect, AdjustingTextBox>().iter(
-      [r](flecs::iter it, Transform2D *t, UIFilledRect *u,
-          AdjustingTextBox *b) {
+  ecs.system<const Transform2D, UIFilledRect, AdjustingTextBox>()
+      .kind<RenderPhase>()
+      .iter([r](flecs::iter it, const Transform2D *t, UIFilledRect *u,
+                AdjustingTextBox *b) {
         r->Flush();
         for (int i : it) {
           renderAdjustingTextBox(r, t[i], u[i], b[i]);
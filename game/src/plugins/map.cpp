@@ -1,6 +1,8 @@
 #include "plugins/map.hpp"
 
+#include <algorithm>
 #include <memory>
+#include <unordered_map>
 
 #include "resource-paths.hpp"
 #include <asset-manager.hpp>
@@ -13,12 +15,16 @@
 #include <plugins/map.hpp>
 #include <plugins/physics.hpp>
 #include <plugins/player.hpp>
+#include <plugins/pool.hpp>
+#include <plugins/timer.hpp>
+#include <plugins/timestep.hpp>
 #include <plugins/transform.hpp>
 #include <prefabs.hpp>
 
-void collideWithMap(Tilemap *map, flecs::entity e, Transform2D &t,
-                    CollisionVolume &c, Groundable &g) {
+void collideWithMap(const Tilemap *map, Transform2D &t, CollisionVolume &c,
+                    Groundable &g) {
   g.isGrounded = false;
+  g.isTouchingMap = false;
   const auto tilemapBounds = map->GetBounds();
   // clamp x position to tilemap bounds
   t.position.x =
@@ -32,8 +38,7 @@ void collideWithMap(Tilemap *map, flecs::entity e, Transform2D &t,
                    static_cast<int>(c.vertices.z - c.vertices.x),
                    static_cast<int>(c.vertices.w - c.vertices.y)};
   SDL_Rect found = {0, 0, 0, 0};
-  bool isOverlapping = false;
-  map->IsCollidingWith(&rect, found, e,
+  map->IsCollidingWith(&rect, found, g.isTouchingMap,
                        g.isGrounded); // check for collision
 
   if ((found.x != 0 || found.y != 0 || found.w != 0 || found.h != 0)) {
@@ -41,58 +46,119 @@ void collideWithMap(Tilemap *map, flecs::entity e, Transform2D &t,
   }
 }
 
+static PathHandle findRoute(Tilemap &map, PathTable &paths,
+                            const LevelSpawn &spawn) {
+  // follow the path object property if there is one, otherwise stand still
+  // on a route of its own
+  const auto pathObject = map.GetSpawnByHandle(spawn.path);
+  const bool hasPath = pathObject && pathObject->pointCount > 0;
+  const uint32_t object = hasPath ? spawn.path : spawn.uid;
+
+  // routes shared by several spawns are only added once
+  const auto found = paths.byObject.find(object);
+  if (found != paths.byObject.end()) {
+    return found->second;
+  }
+  const auto pos = glm::vec2(spawn.x, spawn.y);
+  const PathHandle route =
+      hasPath ? paths.AddRoute(map.GetPoints(*pathObject))
+              : paths.AddRoute(std::span<const glm::vec2>(&pos, 1));
+  paths.byObject[object] = route;
+  return route;
+}
+
+// spawns what came in with the loaded chunks, destroys what left with the
+// unloaded ones. the spawns that are out or died aren't spawned again
+static void spawnStreamed(flecs::world &ecs, Tilemap &map, PathTable &paths,
+                          SpawnState &spawns, const StreamedChunks &streamed) {
+  const auto &unloaded = streamed.unloaded;
+  if (!unloaded.empty()) {
+    // deferred, nothing is destroyed while the filter is iterated
+    ecs.defer([&ecs, &spawns, &unloaded] {
+      ecs.filter<const StreamedFrom>().each(
+          [&spawns, &unloaded](flecs::entity e, const StreamedFrom &s) {
+            if (std::find(unloaded.begin(), unloaded.end(), s.chunk) !=
+                unloaded.end()) {
+              spawns.consumed[s.spawn] = false; // still alive, comes back
+              e.destruct();
+            }
+          });
+    });
+  }
+
+  const LevelSpawn *first = map.GetSpawns().data();
+  for (const uint32_t chunk : streamed.loaded) {
+    for (const auto &spawn : map.GetChunkSpawns(chunk)) {
+      const uint32_t index = &spawn - first;
+      if (spawns.consumed[index]) {
+        continue;
+      }
+      const auto pos = glm::vec2(spawn.x, spawn.y);
+      const auto className = map.GetString(spawn.className);
+      if (className == "ANYA") {
+        SpawnAnya(ecs, pos, findRoute(map, paths, spawn))
+            .set<StreamedFrom>({chunk, index});
+        spawns.consumed[index] = true;
+      }
+    }
+  }
+}
+
+void streamMap(Tilemap &map, StreamedChunks &streamed, glm::vec2 center) {
+  std::vector<uint32_t> loaded, unloaded;
+  map.Stream(center, loaded, unloaded);
+  for (const uint32_t chunk : unloaded) {
+    // one that came in since the last tick never spawned anything
+    const auto found =
+        std::find(streamed.loaded.begin(), streamed.loaded.end(), chunk);
+    if (found != streamed.loaded.end()) {
+      streamed.loaded.erase(found);
+    } else {
+      streamed.unloaded.push_back(chunk);
+    }
+  }
+  streamed.loaded.insert(streamed.loaded.end(), loaded.begin(), loaded.end());
+  streamed.epoch = map.GetStreamEpoch();
+}
+
 void LoadLevel(flecs::world &ecs, std::shared_ptr<Tilemap> map) {
   LockAllAssets();
 
-  auto sb = ecs.get<Renderer>()->renderer;
-  ecs.reset();
-  ecs.reset();
   ecs.set_time_scale(0.0f);
   ecs.set<Camera>({.position = glm::vec2(0, 0)});
   ecs.set<Gravity>({.value = 980.0f});
-  ecs.set<Renderer>({.renderer = sb});
+  ecs.set<Broadphase>({});
+  ecs.set<PathTable>({});
+  ecs.set<EntityPool>({});
+  ecs.set<Timers>({});
   ecs.set<Map>({map});
+  ecs.set<SpawnState>({std::vector<bool>(map->GetSpawns().size())});
+  ecs.set<StreamedChunks>({});
 
   // Plugins
+  TimestepPlugin().addSystems(ecs);
+  PoolPlugin().addSystems(ecs);
+  TimerPlugin().addSystems(ecs);
   PlayerPlugin().addSystems(ecs);
   EnemyPlugin().addSystems(ecs);
   PhysicsPlugin().addSystems(ecs);
   MapPlugin().addSystems(ecs);
-  CameraPlugin().addSystems(ecs);
   Transform2DPlugin().addSystems(ecs);
+  CollisionPlugin().addSystems(ecs);
+  CameraPlugin().addSystems(ecs);
   GraphicsPlugin().addSystems(ecs);
 
-  const auto objects = map->GetObjects();
-
-  const auto mapHeight = map->GetBounds().h;
-  for (const auto &object : objects) {
-    const auto pos = glm::vec2(object.getPosition().x, object.getPosition().y);
-    if (object.getClass() == "PLAYER") {
-      SDL_Log("Spawning player at %f, %f", pos.x, pos.y);
-      SpawnPlayer(ecs, pos);
-    } else if (object.getClass() == "ANYA") {
-      SDL_Log("Spawning Anya at %f, %f", pos.x, pos.y);
-      // get properties that are objects
-      const auto properties = object.getProperties();
-      Path path = Path({pos}, 1);
-      for (const auto &property : properties) {
-        if (property.getName() == "path") {
-          const auto pathHandle = property.getObjectValue();
-          const auto pathObject = map->GetObjectByHandle(pathHandle);
-          const auto pathPoints = pathObject.getPoints();
-          const auto pathPos =
-              glm::vec2(pathObject.getPosition().x, pathObject.getPosition().y);
-          std::vector<glm::vec2> points;
-          for (const auto &pp : pathPoints) {
-            const glm::vec2 point = {pp.x + pathPos.x, pp.y + pathPos.y};
-            points.push_back(point);
-          }
-          path = Path(points, 1);
-        }
-      }
-      SpawnAnya(ecs, pos, path);
+  // the player is spawned up front, everything else comes in with its chunk
+  glm::vec2 playerPosition(0, 0);
+  for (const auto &spawn : map->GetSpawns()) {
+    if (map->GetString(spawn.className) == "PLAYER") {
+      playerPosition = glm::vec2(spawn.x, spawn.y);
+      SDL_Log("Spawning player at %f, %f", spawn.x, spawn.y);
+      SpawnPlayer(ecs, playerPosition);
     }
   }
+  ecs.get_mut<Camera>()->position = playerPosition;
+  streamMap(*map, *ecs.get_mut<StreamedChunks>(), playerPosition);
 
   UnlockAllAssets();
 
@@ -110,16 +176,16 @@ void DrawColliders(flecs::world &ecs, SpriteBatch *sb) {
           const auto world = it.world();
           // the rect is the vertices with the position offset
           const auto rect =
-              c.vertices + glm::vec4(t.global_position.x, t.global_position.y,
+              c.vertices + glm::vec4(t.render_position.x, t.render_position.y,
                                      -c.vertices.x, -c.vertices.y);
-          const bool isGrounded =
-              e.has<Groundable>() && e.get<Groundable>()->isGrounded;
+          const Groundable *g = e.get<Groundable>();
+          const bool isGrounded = g && g->isGrounded;
+          const bool isTouchingMap = g && g->isTouchingMap;
 
           auto color = isGrounded
                            ? glm::vec4(1, 0, 0, 0.5f)
-                           : (it.world().get<Map>()->value->HasCollision(e)
-                                  ? glm::vec4(0, 1, 0, 0.5f)
-                                  : glm::vec4(0, 0, 1, 0.5f));
+                           : (isTouchingMap ? glm::vec4(0, 1, 0, 0.5f)
+                                            : glm::vec4(0, 0, 1, 0.5f));
           if (e.has<Hurtbox>()) {
             if (e.get<Hurtbox>()->active) {
               color = glm::vec4(1, 1, 0, 0.5f);
@@ -135,13 +201,55 @@ void DrawColliders(flecs::world &ecs, SpriteBatch *sb) {
 }
 
 void MapPlugin::addSystems(flecs::world &ecs) {
+  // streaming, around where the camera was last frame. runs on the main
+  // thread between ticks so the collision queries never see it
+  ecs.system<Map, StreamedChunks>()
+      .kind<RenderPhase>()
+      .term_at(2)
+      .singleton()
+      .iter([](flecs::iter it, Map *m, StreamedChunks *streamed) {
+        streamMap(*m[0].value, streamed[0],
+                  it.world().get<Camera>()->position);
+      });
+
+  // the chunks a tick collides against, set again when a rollback loads the
+  // ones of a tick to re-simulate and when it catches up
+  ecs.observer<StreamedChunks, Map>()
+      .event(flecs::OnSet)
+      .term_at(2)
+      .singleton()
+      .filter()
+      .each([](StreamedChunks &streamed, Map &m) {
+        m.value->SetVisibleEpoch(streamed.epoch);
+      });
+
+  // the spawns of what was streamed, in the tick so a rollback brings them
+  // back with the state it loads
+  ecs.system<Map, PathTable, SpawnState, StreamedChunks>()
+      .kind<SimulationPhase>()
+      .term_at(2)
+      .singleton()
+      .term_at(3)
+      .singleton()
+      .term_at(4)
+      .singleton()
+      .iter([](flecs::iter it, Map *m, PathTable *paths, SpawnState *spawns,
+               StreamedChunks *streamed) {
+        auto world = it.world();
+        spawnStreamed(world, *m[0].value, paths[0], spawns[0], streamed[0]);
+        streamed[0].loaded.clear();
+        streamed[0].unloaded.clear();
+      });
+
   // collision for entities with tilemap
-  ecs.system<Transform2D, CollisionVolume, Groundable>().iter(
-      [](flecs::iter it, Transform2D *t, CollisionVolume *c, Groundable *g) {
-        Tilemap *map = it.world().get<Map>()->value.get();
-        for (int i = 0; i < it.count(); i++) {
-          flecs::entity e = it.entity(i);
-          collideWithMap(map, e, t[i], c[i], g[i]);
+  ecs.system<Transform2D, CollisionVolume, Groundable>()
+      .kind<SimulationPhase>()
+      .multi_threaded()
+      .iter([](flecs::iter it, Transform2D *t, CollisionVolume *c,
+               Groundable *g) {
+        const Tilemap *map = it.world().get<Map>()->value.get();
+        for (int i : it) {
+          collideWithMap(map, t[i], c[i], g[i]);
         }
       });
 }
\ No newline at end of file
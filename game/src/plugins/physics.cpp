@@ -1,5 +1,61 @@
 #include "plugins/physics.hpp"
 
+#include <plugins/map.hpp>
+#include <plugins/pool.hpp>
+#include <plugins/timer.hpp>
+
+// below this the narrowphase isn't worth spreading over threads
+#define NARROWPHASE_PARALLEL_MIN_COLLIDERS 4096
+
+// a swept body slides along at most this many surfaces per tick
+#define SWEEP_MAX_ITERATIONS 3
+
+void Broadphase::QueryAABB(glm::vec4 aabb, std::vector<flecs::entity> &out) {
+  this->results.clear();
+  this->grid.QueryAABB(aabb, this->results);
+  for (const auto item : this->results) {
+    out.push_back(this->entities[item]);
+  }
+}
+
+void Broadphase::QueryRadius(glm::vec2 center, float radius,
+                             std::vector<flecs::entity> &out) {
+  this->results.clear();
+  this->grid.QueryRadius(center, radius, this->results);
+  for (const auto item : this->results) {
+    out.push_back(this->entities[item]);
+  }
+}
+
+float Broadphase::Sweep(glm::vec4 aabb, glm::vec2 delta,
+                        glm::vec2 &normal) const {
+  const glm::vec4 moved = aabb + glm::vec4(delta, delta);
+  const glm::vec4 query(glm::min(aabb.x, moved.x), glm::min(aabb.y, moved.y),
+                        glm::max(aabb.z, moved.z), glm::max(aabb.w, moved.w));
+
+  float toi = 2.0f;
+  this->grid.ForEachInAABB(query, [&](uint32_t item) {
+    if (!(this->flags[item] & COLLIDER_STATIC_BODY)) {
+      return;
+    }
+    glm::vec2 hitNormal;
+    const float hit =
+        SpatialGrid::sweep(aabb, delta, this->grid.GetAABB(item), hitNormal);
+    if (hit < toi) {
+      toi = hit;
+      normal = hitNormal;
+    }
+  });
+  return toi;
+}
+
+glm::vec4 collision_aabb(const Transform2D &t, const CollisionVolume &c) {
+  return glm::vec4(t.global_position.x + c.vertices.x,
+                   t.global_position.y + c.vertices.y,
+                   t.global_position.x + c.vertices.z,
+                   t.global_position.y + c.vertices.w);
+}
+
 void push_rect_transform(const SDL_Rect &rect, const SDL_Rect &pushedBy,
                          Transform2D &t1, CollisionVolume &c1) {
   const auto rect1Center = glm::vec2(rect.x + rect.w / 2, rect.y + rect.h / 2);
@@ -52,75 +108,271 @@ void applyVelocity(flecs::iter it, Velocity *v, Transform2D *t) {
   const auto dt = it.delta_time();
   for (int i : it) {
     t[i].position += v[i].value * dt;
-    t[i].global_position = t[i].position;
   }
 }
 
-void runEntityCollisions(flecs::entity e1, Transform2D &t1, CollisionVolume &c1,
-                         flecs::entity e2, Transform2D &t2,
-                         CollisionVolume &c2) {
-  if (e1.id() == e2.id()) {
-    return;
-  }
-  const SDL_Rect rect1 = {
-      static_cast<int>(t1.global_position.x + c1.vertices.x),
-      static_cast<int>(t1.global_position.y + c1.vertices.y),
-      static_cast<int>(c1.vertices.z - c1.vertices.x),
-      static_cast<int>(c1.vertices.w - c1.vertices.y)};
-  const SDL_Rect rect2 = {
-      static_cast<int>(t2.global_position.x + c2.vertices.x),
-      static_cast<int>(t2.global_position.y + c2.vertices.y),
-      static_cast<int>(c2.vertices.z - c2.vertices.x),
-      static_cast<int>(c2.vertices.w - c2.vertices.y)};
-
-  if (SDL_HasIntersection(&rect1, &rect2)) {
-    // apply damage
-    if (e1.has<Hurtbox>() && e2.has<Health>() && e1.get<Hurtbox>()->active) {
-      e2.get_mut<Health>()->value -= e1.get<Hurtbox>()->damage;
-      if (e2.get<Health>()->value <= 0) {
-        e2.destruct();
-      }
+void sweepBody(const Tilemap &map, const Broadphase &b,
+               const CollisionVolume &c, glm::vec2 &position,
+               glm::vec2 &velocity, float dt) {
+  glm::vec2 delta = velocity * dt;
+  for (int step = 0; step < SWEEP_MAX_ITERATIONS; step++) {
+    if (delta.x == 0.0f && delta.y == 0.0f) {
+      break;
+    }
+    const glm::vec4 aabb = c.vertices + glm::vec4(position, position);
+    glm::vec2 normal(0, 0);
+    glm::vec2 staticNormal(0, 0);
+    float toi = map.Sweep(aabb, delta, normal);
+    const float staticToi = b.Sweep(aabb, delta, staticNormal);
+    if (staticToi < toi) {
+      toi = staticToi;
+      normal = staticNormal;
+    }
+    if (toi > 1.0f) {
+      position += delta;
+      break;
     }
-    // push entities apart
-    if (e1.has<PhysicsBody>() && e2.has<StaticBody>()) {
-      push_rect_transform(rect1, rect2, t1, c1);
+
+    // stop at the surface, then slide the rest of the way along it
+    position += delta * toi;
+    delta *= 1.0f - toi;
+    if (normal.x != 0.0f) {
+      velocity.x = 0.0f;
+      delta.x = 0.0f;
+    } else {
+      velocity.y = 0.0f;
+      delta.y = 0.0f;
     }
   }
 }
 
-void dieOfOldAge(flecs::iter it, LiveFor *l) {
+void applySweptVelocity(flecs::iter it, Velocity *v, Transform2D *t,
+                        CollisionVolume *c) {
   const auto dt = it.delta_time();
+  const Tilemap *map = it.world().get<Map>()->value.get();
+  const Broadphase *broadphase = it.world().get<Broadphase>();
   for (int i : it) {
-    l[i].seconds -= dt;
-    if (l[i].seconds <= 0) {
-      it.entity(i).destruct();
+    sweepBody(*map, *broadphase, c[i], t[i].position, v[i].value, dt);
+  }
+}
+
+void runBroadphase(
+    Broadphase &b,
+    const flecs::query<Transform2D, CollisionVolume> &colliders) {
+  b.grid.Clear();
+  b.entities.clear();
+  b.rects.clear();
+  b.flags.clear();
+  b.damage.clear();
+
+  // the optional terms are checked once per table, not once per entity
+  colliders.each([&b](flecs::iter &it, size_t i, Transform2D &t,
+                      CollisionVolume &c) {
+    uint8_t flags = 0;
+    float damage = 0.0f;
+    if (it.is_set(3)) {
+      const auto hurtbox = it.field<const Hurtbox>(3);
+      const auto &h = hurtbox[it.is_self(3) ? i : 0];
+      if (h.active) {
+        flags |= COLLIDER_HURTBOX;
+        damage = h.damage;
+      }
+    }
+    flags |= it.is_set(4) ? COLLIDER_HEALTH : 0;
+    flags |= it.is_set(5) ? COLLIDER_PHYSICS_BODY : 0;
+    flags |= it.is_set(6) ? COLLIDER_STATIC_BODY : 0;
+
+    b.grid.Insert(collision_aabb(t, c));
+    b.entities.push_back(it.entity(i));
+    b.rects.push_back({static_cast<int>(t.global_position.x + c.vertices.x),
+                       static_cast<int>(t.global_position.y + c.vertices.y),
+                       static_cast<int>(c.vertices.z - c.vertices.x),
+                       static_cast<int>(c.vertices.w - c.vertices.y)});
+    b.flags.push_back(flags);
+    b.damage.push_back(damage);
+  });
+  b.grid.Build();
+}
+
+static int narrowphaseRanges(const Broadphase &b) {
+  // a fixed split so the events don't depend on the thread count
+  if (b.grid.Size() < NARROWPHASE_PARALLEL_MIN_COLLIDERS) {
+    return 1;
+  }
+  return glm::max(glm::min(NARROWPHASE_RANGES, b.grid.CellCount()), 1);
+}
+
+void runNarrowphase(Broadphase &b, int range) {
+  // every range owns a contiguous run of cells and its own event buffer
+  auto &events = b.workerEvents[range];
+  events.clear();
+  const int ranges = narrowphaseRanges(b);
+  if (range >= ranges) {
+    return;
+  }
+  const int cells = b.grid.CellCount();
+  b.grid.ForEachPair(cells * range / ranges, cells * (range + 1) / ranges,
+                     [&b, &events](uint32_t i, uint32_t j) {
+                       if (SDL_HasIntersection(&b.rects[i], &b.rects[j])) {
+                         events.push_back({i, j});
+                       }
+                     });
+}
+
+void mergeNarrowphase(Broadphase &b) {
+  // joining in range order keeps the events in cell order
+  b.events.clear();
+  for (const auto &events : b.workerEvents) {
+    b.events.insert(b.events.end(), events.begin(), events.end());
+  }
+}
+
+void applyCollisionDamage(flecs::iter it, Broadphase &b) {
+  b.damageTaken.assign(b.entities.size(), 0.0f);
+  for (const auto &event : b.events) {
+    if ((b.flags[event.a] & COLLIDER_HURTBOX) &&
+        (b.flags[event.b] & COLLIDER_HEALTH)) {
+      b.damageTaken[event.b] += b.damage[event.a];
+    }
+    if ((b.flags[event.b] & COLLIDER_HURTBOX) &&
+        (b.flags[event.a] & COLLIDER_HEALTH)) {
+      b.damageTaken[event.a] += b.damage[event.b];
+    }
+  }
+
+  for (uint32_t i = 0; i < b.damageTaken.size(); i++) {
+    if (b.damageTaken[i] <= 0.0f) {
+      continue;
+    }
+    const auto e = b.entities[i].mut(it);
+    auto *health = e.get_mut<Health>();
+    health->value -= b.damageTaken[i];
+    if (health->value <= 0) {
+      b.despawns.push_back(e);
+    }
+  }
+}
+
+void applyCollisionPushOut(flecs::iter it, Broadphase &b) {
+  const auto pushOut = [&it, &b](uint32_t body, uint32_t pushedBy) {
+    if ((b.flags[body] & COLLIDER_PHYSICS_BODY) &&
+        (b.flags[pushedBy] & COLLIDER_STATIC_BODY)) {
+      const auto e = b.entities[body].mut(it);
+      push_rect_transform(b.rects[body], b.rects[pushedBy],
+                          *e.get_mut<Transform2D>(),
+                          *e.get_mut<CollisionVolume>());
+    }
+  };
+  for (const auto &event : b.events) {
+    pushOut(event.a, event.b);
+    pushOut(event.b, event.a);
+  }
+}
+
+void applyCollisionDespawns(flecs::iter it, Broadphase &b) {
+  // systems are deferred, the entities are destroyed at the next merge
+  for (auto &e : b.despawns) {
+    despawnEntity(it, e);
+  }
+  b.despawns.clear();
+}
+
+void expireLifetimes(flecs::iter &it, std::span<const TimerEntry> due) {
+  const auto world = it.world();
+  for (const auto &entry : due) {
+    const auto e = world.entity(entry.target);
+    if (!e.is_alive()) {
+      continue;
+    }
+    // pooled instances get a new deadline every time they are reused
+    const auto *l = e.get<LiveFor>();
+    if (l && l->timer == entry.handle) {
+      despawnEntity(it, e);
     }
   }
 }
 
 void PhysicsPlugin::addSystems(flecs::world &ecs) {
   // gravity system
-  ecs.system<Velocity, Groundable>().iter(
-      [](flecs::iter it, Velocity *v, Groundable *g) {
+  ecs.system<Velocity, Groundable>()
+      .kind<SimulationPhase>()
+      .multi_threaded()
+      .iter([](flecs::iter it, Velocity *v, Groundable *g) {
         applyGravity(it, v, g);
       });
 
   // velocity system
-  ecs.system<Velocity, Transform2D>().iter(
-      [](flecs::iter it, Velocity *v, Transform2D *t) {
+  ecs.system<Velocity, Transform2D>()
+      .kind<SimulationPhase>()
+      .multi_threaded()
+      .term<ContinuousCollision>()
+      .not_()
+      .iter([](flecs::iter it, Velocity *v, Transform2D *t) {
         applyVelocity(it, v, t);
       });
 
-  const auto collisionQuery = ecs.query<Transform2D, CollisionVolume>();
-  ecs.system<Transform2D, CollisionVolume>().each(
-      [collisionQuery](flecs::entity e1, Transform2D &t1, CollisionVolume &c1) {
-        collisionQuery.each([&e1, &t1, &c1](flecs::entity e2, Transform2D &t2,
-                                            CollisionVolume &c2) {
-          runEntityCollisions(e1, t1, c1, e2, t2, c2);
-        });
+  // continuous collision for fast movers
+  ecs.system<Velocity, Transform2D, CollisionVolume>()
+      .kind<SimulationPhase>()
+      .multi_threaded()
+      .term<ContinuousCollision>()
+      .iter([](flecs::iter it, Velocity *v, Transform2D *t,
+               CollisionVolume *c) { applySweptVelocity(it, v, t, c); });
+
+  // lifetimes, scheduled once when set instead of counted down every tick
+  const uint32_t expireEvent =
+      ecs.get_mut<Timers>()->AddEvent(expireLifetimes);
+  ecs.observer<LiveFor, Timers>()
+      .event(flecs::OnSet)
+      .term_at(2)
+      .singleton()
+      .filter()
+      .each([expireEvent](flecs::entity e, LiveFor &l, Timers &timers) {
+        l.timer = timers.Schedule(l.seconds, e, expireEvent);
+      });
+}
+
+void CollisionPlugin::addSystems(flecs::world &ecs) {
+  // entity vs entity collisions, broadphase over a uniform grid then a
+  // narrowphase that only records contacts
+  const auto collisionQuery =
+      ecs.query_builder<Transform2D, CollisionVolume>()
+          .term<Hurtbox>()
+          .optional()
+          .term<Health>()
+          .optional()
+          .term<PhysicsBody>()
+          .optional()
+          .term<StaticBody>()
+          .optional()
+          .build();
+  ecs.system<Broadphase>().kind<SimulationPhase>().iter(
+      [collisionQuery](flecs::iter it, Broadphase *b) {
+        runBroadphase(b[0], collisionQuery);
+        b[0].workerEvents.resize(NARROWPHASE_RANGES);
+      });
+  // the ranges are entities so the flecs workers split them between them
+  for (int range = 0; range < NARROWPHASE_RANGES; range++) {
+    ecs.entity().set<NarrowphaseRange>({range});
+  }
+  ecs.system<const NarrowphaseRange, Broadphase>()
+      .kind<SimulationPhase>()
+      .multi_threaded()
+      .term_at(2)
+      .singleton()
+      .iter([](flecs::iter it, const NarrowphaseRange *r, Broadphase *b) {
+        for (int i : it) {
+          runNarrowphase(b[0], r[i].index);
+        }
       });
+  ecs.system<Broadphase>().kind<SimulationPhase>().iter(
+      [](flecs::iter it, Broadphase *b) { mergeNarrowphase(b[0]); });
 
-  // die of old age system
-  ecs.system<LiveFor>().iter(
-      [](flecs::iter it, LiveFor *l) { dieOfOldAge(it, l); });
+  // collision responses, each handler runs over the whole event buffer
+  ecs.system<Broadphase>().kind<SimulationPhase>().iter(
+      [](flecs::iter it, Broadphase *b) { applyCollisionDamage(it, b[0]); });
+  ecs.system<Broadphase>().kind<SimulationPhase>().iter(
+      [](flecs::iter it, Broadphase *b) { applyCollisionPushOut(it, b[0]); });
+  ecs.system<Broadphase>().kind<SimulationPhase>().iter(
+      [](flecs::iter it, Broadphase *b) { applyCollisionDespawns(it, b[0]); });
 }
@@ -1,22 +1,32 @@
 #include "plugins/player.hpp"
+#include "prefabs.hpp"
+#include "rollback-world.hpp"
+
+void playerUpdate(flecs::iter it, Player *p, PlayerRig *r, Velocity *v,
+                  CollisionVolume *c, AnimatedSprite *s, Transform2D *t,
+                  Groundable *g, EntityPool *pool) {
+  const auto ballPrefab = it.world().get<PrefabRegistry>()->ball;
 
-void playerUpdate(flecs::iter it, Player *p, Velocity *v, CollisionVolume *c,
-                  AnimatedSprite *s, Transform2D *t, Groundable *g) {
   const float speed = 200.0f;
-  const auto move = InputManager::GetVectorMovement();
-  const auto jump = InputManager::GetTriggerJump();
-  const auto attack = InputManager::GetKey(SDL_SCANCODE_LCTRL).IsJustPressed();
-  const auto fire = InputManager::GetKey(SDL_SCANCODE_Z).IsJustPressed();
+  // with rollback netcode every player has the input of the tick
+  const auto *ticked = it.world().get<RollbackInputs>();
 
   for (int i : it) {
-    if (!s[i].isAnimationFinished && !s[i].currentAnimation->loop) {
-      return; // the attack animation drives velocity for now
+    const auto &input = ticked != nullptr
+                            ? ticked->players[p[i].inputSlot]
+                            : InputManager::GetSnapshot();
+    const auto move = input.movement;
+    const auto jump = input.IsJustPressed(ACTION_JUMP);
+    const auto attack = input.IsJustPressed(ACTION_ATTACK);
+    const auto fire = input.IsJustPressed(ACTION_FIRE);
+
+    if (!s[i].isAnimationFinished && !s[i].GetAnimation().loop) {
+      continue; // the attack animation drives velocity for now
     }
 
-    p->isAttacking = false;
+    p[i].isAttacking = false;
 
-    const auto h = it.entity(0).lookup("hurtbox");
-    auto *hurtbox = h.get_mut<Hurtbox>();
+    auto *hurtbox = r[i].hurtbox.get_mut<Hurtbox>();
     hurtbox->active = false;
 
     const auto last_velocity = v[i].value;
@@ -26,27 +36,25 @@ void playerUpdate(flecs::iter it, Player *p, Velocity *v, CollisionVolume *c,
       g[i].isGrounded = false;
     }
 
-    const auto dir = it.entity(0).lookup("directionArrow");
-    auto *dir_t = dir.get_mut<Transform2D>();
+    auto *dir_t = r[i].arrow.get_mut<Transform2D>();
     if (move.x != 0.0f || move.y != 0.0f) {
       dir_t->rotation = atan2(-move.y, move.x);
     }
 
     if (move.x != 0.0f) {
-      if (move.x > 0.0f) {
-        t[i].scale.x = -1 * fabs(t[i].scale.x);
-      } else {
-        t[i].scale.x = fabs(t[i].scale.x);
-      }
+      // the art faces left
+      s[i].flipX = move.x > 0.0f;
     }
 
     if (g[i].isGrounded && attack) {
-      p->isAttacking = true;
-      s[i].SetAnimation(s->spriteSheet->GetAnimation("Attack"));
-      // play sfx
-      p->soundEffect->play();
+      p[i].isAttacking = true;
+      s[i].SetAnimation(p[i].animations.attack);
+      // play sfx, once even if the tick runs again
+      if (ticked == nullptr || !ticked->resimulating) {
+        p[i].soundEffect->playAt(t[i].position.x, t[i].position.y);
+      }
       const float attack_x_vel = 215.0f;
-      if (t[i].scale.x > 0) {
+      if (!s[i].flipX) {
         v[i].value.x = -1 * attack_x_vel;
       } else {
         v[i].value.x = attack_x_vel;
@@ -54,18 +62,16 @@ void playerUpdate(flecs::iter it, Player *p, Velocity *v, CollisionVolume *c,
       v[i].value.y = -315.0f;
       g[i].isGrounded = false;
       hurtbox->active = true;
-      return;
+      continue;
     }
     if (fire) {
       const auto world = it.world();
-      const auto b = world.lookup("Ball");
       const auto base_up_velocity = glm::vec2(0, -200.0f);
       const auto ball_velocity =
           glm::vec2(cos(dir_t->rotation), -sin(dir_t->rotation)) * 800.0f +
           base_up_velocity;
       const auto ball =
-          world.entity()
-              .is_a(b)
+          pool->Acquire(world, ballPrefab)
               .set<Transform2D>(Transform2D().WithPosition(t[i].position))
               .set<Velocity>({ball_velocity})
               .set<Groundable>({false})
@@ -74,19 +80,24 @@ void playerUpdate(flecs::iter it, Player *p, Velocity *v, CollisionVolume *c,
 
     // update animations
     if (!g[i].isGrounded) {
-      s[i].SetAnimation(s->spriteSheet->GetAnimation("Jump"));
+      s[i].SetAnimation(p[i].animations.jump);
     } else if (move.x != 0.0f) {
-      s[i].SetAnimation(s->spriteSheet->GetAnimation("Run"));
+      s[i].SetAnimation(p[i].animations.run);
     } else {
-      s[i].SetAnimation(s->spriteSheet->GetAnimation("Idle"));
+      s[i].SetAnimation(p[i].animations.idle);
     }
   }
 }
 
 void PlayerPlugin::addSystems(flecs::world &ecs) {
-  ecs.system<Player, Velocity, CollisionVolume, AnimatedSprite, Transform2D,
-             Groundable>()
-      .iter([](flecs::iter it, Player *p, Velocity *v, CollisionVolume *c,
-               AnimatedSprite *s, Transform2D *t,
-               Groundable *g) { playerUpdate(it, p, v, c, s, t, g); });
+  ecs.system<Player, PlayerRig, Velocity, CollisionVolume, AnimatedSprite,
+             Transform2D, Groundable, EntityPool>()
+      .kind<SimulationPhase>()
+      .term_at(8)
+      .singleton()
+      .iter([](flecs::iter it, Player *p, PlayerRig *r, Velocity *v,
+               CollisionVolume *c, AnimatedSprite *s, Transform2D *t,
+               Groundable *g, EntityPool *pool) {
+        playerUpdate(it, p, r, v, c, s, t, g, pool);
+      });
 }
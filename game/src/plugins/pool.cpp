@@ -0,0 +1,42 @@
+#include "plugins/pool.hpp"
+
+flecs::entity EntityPool::Acquire(const flecs::world &world,
+                                  flecs::entity prefab) {
+  auto &instances = this->free[prefab.id()];
+  if (instances.empty()) {
+    return world.entity().is_a(prefab).set<Pooled>({prefab});
+  }
+  auto e = instances.back().mut(world);
+  instances.pop_back();
+  e.enable();
+  return e;
+}
+
+void collectFreeInstances(EntityPool &pool,
+                          const flecs::query<const Pooled> &disabled) {
+  // releasing is only a disable, the free lists are found again here
+  for (auto &[prefab, instances] : pool.free) {
+    instances.clear();
+  }
+  disabled.each([&pool](flecs::entity e, const Pooled &p) {
+    pool.free[p.prefab.id()].push_back(e);
+  });
+}
+
+void despawnEntity(flecs::iter &it, flecs::entity e) {
+  if (e.has<Pooled>()) {
+    e.mut(it).disable();
+  } else {
+    e.mut(it).destruct();
+  }
+}
+
+void PoolPlugin::addSystems(flecs::world &ecs) {
+  // disabled entities are only matched when asked for explicitly
+  const auto disabledQuery =
+      ecs.query_builder<const Pooled>().term(flecs::Disabled).build();
+  ecs.system<EntityPool>().kind<SimulationPhase>().iter(
+      [disabledQuery](flecs::iter it, EntityPool *pool) {
+        collectFreeInstances(pool[0], disabledQuery);
+      });
+}
@@ -0,0 +1,46 @@
+#include "plugins/timer.hpp"
+
+#include <cmath>
+
+uint32_t Timers::AddEvent(TimerCallback callback) {
+  this->callbacks.push_back(callback);
+  return this->callbacks.size() - 1;
+}
+
+TimerHandle Timers::Schedule(float seconds, flecs::entity target,
+                             uint32_t event) {
+  const auto ticks = static_cast<uint64_t>(ceilf(seconds / this->tick));
+  return this->wheel.Schedule(ticks, target.id(), event);
+}
+
+void advanceTimers(flecs::iter &it, Timers &timers) {
+  if (it.delta_time() <= 0.0f) {
+    return; // paused
+  }
+  timers.tick = it.delta_time();
+
+  timers.due.clear();
+  timers.wheel.Advance(timers.due);
+  if (timers.due.empty()) {
+    return;
+  }
+
+  // one batch per event
+  timers.dueByEvent.resize(timers.callbacks.size());
+  for (auto &due : timers.dueByEvent) {
+    due.clear();
+  }
+  for (const auto &entry : timers.due) {
+    timers.dueByEvent[entry.event].push_back(entry);
+  }
+  for (uint32_t event = 0; event < timers.callbacks.size(); event++) {
+    if (!timers.dueByEvent[event].empty()) {
+      timers.callbacks[event](it, timers.dueByEvent[event]);
+    }
+  }
+}
+
+void TimerPlugin::addSystems(flecs::world &ecs) {
+  ecs.system<Timers>().kind<SimulationPhase>().iter(
+      [](flecs::iter it, Timers *t) { advanceTimers(it, t[0]); });
+}
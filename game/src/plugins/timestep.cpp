@@ -0,0 +1,33 @@
+#include "plugins/timestep.hpp"
+
+void storePreviousTransform(Transform2D &t) {
+  t.previous_global_position = t.global_position;
+}
+
+void interpolateTransform(Transform2D &t, float alpha) {
+  t.render_position =
+      glm::mix(t.previous_global_position, t.global_position, alpha);
+}
+
+void TimestepPlugin::addSystems(flecs::world &ecs) {
+  auto *timestep = ecs.get_mut<FixedTimestep>();
+  timestep->simulation = ecs.pipeline()
+                             .term(flecs::System)
+                             .term<SimulationPhase>()
+                             .build();
+  timestep->render =
+      ecs.pipeline().term(flecs::System).term<RenderPhase>().build();
+
+  // first thing every tick, the state to interpolate from
+  ecs.system<Transform2D>().kind<SimulationPhase>().multi_threaded().each(
+      [](Transform2D &t) { storePreviousTransform(t); });
+
+  // first thing every frame, before the camera and sprites read it
+  ecs.system<Transform2D>().kind<RenderPhase>().multi_threaded().iter(
+      [](flecs::iter it, Transform2D *t) {
+        const float alpha = it.world().get<FixedTimestep>()->alpha;
+        for (int i : it) {
+          interpolateTransform(t[i], alpha);
+        }
+      });
+}
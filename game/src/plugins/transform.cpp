@@ -1,16 +1,58 @@
 #include "plugins/transform.hpp"
 
+void updateRootTransform(Transform2D &t) {
+  t.changed = t.global_position != t.position || t.global_scale != t.scale ||
+              t.global_rotation != t.rotation;
+  if (t.changed) {
+    t.global_position = t.position;
+    t.global_scale = t.scale;
+    t.global_rotation = t.rotation;
+  }
+}
+
+void updateChildTransform(Transform2D &t, const Transform2D &parent) {
+  t.changed = parent.changed || t.position != t.composed_position ||
+              t.scale != t.composed_scale ||
+              t.rotation != t.composed_rotation;
+  if (!t.changed) {
+    return; // the whole subtree is skipped unless something below changed
+  }
+
+  // scale then rotate the local position into the parent's space, the same
+  // rotation the sprite batch uses
+  const float c = glm::cos(parent.global_rotation);
+  const float s = glm::sin(parent.global_rotation);
+  const glm::mat2 rotation(c, -s, s, c);
+  t.global_position =
+      parent.global_position + rotation * (parent.global_scale * t.position);
+  t.global_scale = parent.global_scale * t.scale;
+  t.global_rotation = parent.global_rotation + t.rotation;
+
+  t.composed_position = t.position;
+  t.composed_scale = t.scale;
+  t.composed_rotation = t.rotation;
+}
+
 void Transform2DPlugin::addSystems(flecs::world &world) {
-  // update global positions for children
-  world.system<Transform2D>().each([](flecs::entity e, Transform2D &t) {
-    const auto parent = e.parent();
-    if (parent) {
-      const auto parent_t = parent.get<Transform2D>();
-      t.global_position = parent_t->global_position;
-      t.global_position.x += t.position.x;
-      t.global_position.y += t.position.y;
-    } else {
-      t.global_position = t.position;
-    }
-  });
+  // roots, only touch their own transform so they can be split over threads
+  world.system<Transform2D>()
+      .kind<SimulationPhase>()
+      .multi_threaded()
+      .term(flecs::ChildOf, flecs::Wildcard)
+      .not_()
+      .each([](Transform2D &t) { updateRootTransform(t); });
+
+  // children, cascade iterates breadth first by depth so a parent is always
+  // composed before its children. on one thread to keep that order
+  world.system<Transform2D, const Transform2D>()
+      .kind<SimulationPhase>()
+      .term_at(2)
+      .parent()
+      .cascade()
+      .iter([](flecs::iter it, Transform2D *t, const Transform2D *parent) {
+        // a table holds the children of a single parent
+        for (int i : it) {
+          updateChildTransform(t[i], parent[0]);
+        }
+      });
 }
@@ -1,6 +1,7 @@
 #include "prefabs.hpp"
 
 #include "asset-manager.hpp"
+#include "plugins/camera.hpp"
 #include "plugins/enemy.hpp"
 #include "plugins/graphics.hpp"
 #include "plugins/physics.hpp"
@@ -18,13 +19,22 @@ void SpawnPlayer(flecs::world &ecs, glm::vec2 pos) {
   const auto fontS = AssetManager<Font>::getFont(RES_FONT_VERA, 14);
 
   music->play_on_loop();
+  // the player's own feedback is never cut off by the enemies
+  soundEffect->settings.priority = SOUND_PRIORITY_HIGH;
+
+  const PlayerAnimations animations = {
+      .idle = spritesheet->GetAnimationHandle("Idle"),
+      .run = spritesheet->GetAnimationHandle("Run"),
+      .jump = spritesheet->GetAnimationHandle("Jump"),
+      .attack = spritesheet->GetAnimationHandle("Attack")};
 
   const auto Tink = ecs.prefab("Tink")
                         .set<Transform2D>(Transform2D(pos, glm::vec2(1, 1), 0))
-                        .set<AnimatedSprite>(AnimatedSprite(
-                            spritesheet, spritesheet->GetAnimation("Idle")))
+                        .set<AnimatedSprite>(
+                            AnimatedSprite(spritesheet, animations.idle))
                         .set<Player>({"Player 1", false, soundEffect, music,
-                                      spritesheet->GetAtlasRect(0)})
+                                      spritesheet->GetAtlasRect(0),
+                                      animations})
                         .set<Velocity>({glm::vec2(0, 0)})
                         .set<CollisionVolume>({glm::vec4(3, 7, 39, 39)})
                         .set<Groundable>({false})
@@ -39,7 +49,7 @@ void SpawnPlayer(flecs::world &ecs, glm::vec2 pos) {
           .set<CollisionVolume>({
               glm::vec4(0, 0, 16, 16),
           })
-          .set<LiveFor>({5.0f});
+          .add<ContinuousCollision>();
 
   const auto HpBar = ecs.prefab("UIFilledRect")
                          .set<Transform2D>(Transform2D(glm::vec2(0.0f, -15.0f),
@@ -57,7 +67,7 @@ void SpawnPlayer(flecs::world &ecs, glm::vec2 pos) {
   const auto TextArea =
       ecs.prefab("textArea")
           .set<Transform2D>(
-              Transform2D(glm::vec2(-45.0f, -200.0), glm::vec2(1, 1), 0))
+              Transform2D(glm::vec2(-45.0f, -36.0f), glm::vec2(1, 1), 0))
           .set<UIFilledRect>(UIFilledRect(glm::vec2(128.0f, 128.0f), 1.0f, 1.0f,
                                           glm::vec4(1, 1, 1, 1),
                                           glm::vec4(0, 0, 0, 0.3f)))
@@ -79,18 +89,26 @@ void SpawnPlayer(flecs::world &ecs, glm::vec2 pos) {
           .set<Transform2D>(Transform2D(pos, glm::vec2(1, 1), 0))
           .set<CollisionVolume>({glm::vec4(3, 7, 30, 48)})
           .set<Hurtbox>({1.0f, false});
+
+  player.set<PlayerRig>({.hurtbox = hurtbox, .arrow = directionArrow});
+  ecs.set<PrefabRegistry>({.tink = Tink,
+                           .ball = Ball,
+                           .hpBar = HpBar,
+                           .directionArrow = DirectionArrow,
+                           .textArea = TextArea});
+  ecs.get_mut<Camera>()->target = player;
 }
 
-void SpawnAnya(flecs::world &ecs, glm::vec2 pos, Path path) {
+flecs::entity SpawnAnya(flecs::world &ecs, glm::vec2 pos, PathHandle route) {
   const auto textureAnya = AssetManager<Texture>::get(RES_TEXTURE_AMIIBO);
-  const auto Anya = ecs.entity()
-                        .set<Transform2D>(Transform2D(pos, glm::vec2(1, 1), 0))
-                        .set<Sprite>({textureAnya})
-                        .set<Velocity>({glm::vec2(0, 0)})
-                        .set<CollisionVolume>({
-                            glm::vec4(0, 32, 64, 64),
-                        })
-                        .set<Health>({1.0f})
-                        .set<Enemy>(Enemy())
-                        .set<Path>(path);
+  return ecs.entity()
+      .set<Transform2D>(Transform2D(pos, glm::vec2(1, 1), 0))
+      .set<Sprite>({textureAnya})
+      .set<Velocity>({glm::vec2(0, 0)})
+      .set<CollisionVolume>({
+          glm::vec4(0, 32, 64, 64),
+      })
+      .set<Health>({1.0f})
+      .set<Enemy>(Enemy())
+      .set<Path>(Path(route));
 }
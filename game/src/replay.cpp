@@ -0,0 +1,55 @@
+#include "replay.hpp"
+#include <SDL2/SDL_log.h>
+#include <algorithm>
+#include <components.hpp>
+#include <plugins/physics.hpp>
+
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+static void hashBytes(uint64_t &hash, const void *data, size_t size) {
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * FNV_PRIME;
+  }
+}
+
+void ReplayStats::Report(const char *path, uint64_t stateHash) const {
+  if (this->frameTimes.empty()) {
+    SDL_Log("Replayed %s, no frames, state hash %016llx", path,
+            static_cast<unsigned long long>(stateHash));
+    return;
+  }
+  auto sorted = this->frameTimes;
+  std::sort(sorted.begin(), sorted.end());
+  const auto percentile = [&sorted](float p) {
+    return sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+  };
+  double total = 0.0;
+  for (const float time : sorted) {
+    total += time;
+  }
+  SDL_Log("Replayed %s, %zu frames in %.1f ms", path, sorted.size(), total);
+  SDL_Log("Frame time ms: mean %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f",
+          total / sorted.size(), percentile(0.5f), percentile(0.9f),
+          percentile(0.99f), sorted.back());
+  SDL_Log("Final state hash %016llx",
+          static_cast<unsigned long long>(stateHash));
+}
+
+uint64_t HashWorldState(flecs::world &ecs) {
+  uint64_t hash = FNV_OFFSET_BASIS;
+  ecs.filter<const Transform2D>().each(
+      [&hash](flecs::entity e, const Transform2D &t) {
+        const flecs::entity_t id = e.id();
+        hashBytes(hash, &id, sizeof(id));
+        hashBytes(hash, &t.global_position, sizeof(t.global_position));
+        if (const auto *v = e.get<Velocity>()) {
+          hashBytes(hash, &v->value, sizeof(v->value));
+        }
+        if (const auto *h = e.get<Health>()) {
+          hashBytes(hash, &h->value, sizeof(h->value));
+        }
+      });
+  return hash;
+}
@@ -0,0 +1,348 @@
+#include "replication.hpp"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <components.hpp>
+#include <plugins/physics.hpp>
+
+// fields of an entity record that changed since the baseline
+#define NET_FIELD_COMPONENTS (1 << 0)
+#define NET_FIELD_POSITION (1 << 1)
+#define NET_FIELD_VELOCITY (1 << 2)
+#define NET_FIELD_HEALTH (1 << 3)
+#define NET_FIELD_BITS 4
+
+static int32_t quantize(float value, float precision) {
+  return static_cast<int32_t>(std::lround(value * precision));
+}
+
+static uint8_t changedFields(const NetEntityState &from,
+                             const NetEntityState &to) {
+  uint8_t fields = 0;
+  if (from.components != to.components) {
+    fields |= NET_FIELD_COMPONENTS;
+  }
+  if (from.position != to.position) {
+    fields |= NET_FIELD_POSITION;
+  }
+  if (from.velocity != to.velocity) {
+    fields |= NET_FIELD_VELOCITY;
+  }
+  if (from.health != to.health) {
+    fields |= NET_FIELD_HEALTH;
+  }
+  return fields;
+}
+
+static void writeRecord(uint32_t &lastNetId, const NetEntityState &from,
+                        const NetEntityState &to, BitWriter &out) {
+  out.WriteVarUnsigned(to.netId - lastNetId);
+  lastNetId = to.netId;
+  out.WriteBool(false); // not removed
+  const uint8_t fields = changedFields(from, to);
+  out.Write(fields, NET_FIELD_BITS);
+  if (fields & NET_FIELD_COMPONENTS) {
+    out.Write(to.components, 2);
+  }
+  if (fields & NET_FIELD_POSITION) {
+    out.WriteVarSigned(to.position.x - from.position.x);
+    out.WriteVarSigned(to.position.y - from.position.y);
+  }
+  if (fields & NET_FIELD_VELOCITY) {
+    out.WriteVarSigned(to.velocity.x - from.velocity.x);
+    out.WriteVarSigned(to.velocity.y - from.velocity.y);
+  }
+  if (fields & NET_FIELD_HEALTH) {
+    out.WriteVarSigned(to.health - from.health);
+  }
+}
+
+void CaptureNetState(flecs::world &world,
+                     std::vector<NetEntityState> &entities) {
+  entities.clear();
+  world.filter<const Replicated, const Transform2D>().each(
+      [&entities](flecs::entity e, const Replicated &r, const Transform2D &t) {
+        NetEntityState state = {};
+        state.netId = r.netId;
+        state.position =
+            glm::ivec2(quantize(t.position.x, NET_POSITION_PRECISION),
+                       quantize(t.position.y, NET_POSITION_PRECISION));
+        if (const auto *v = e.get<Velocity>()) {
+          state.components |= NET_HAS_VELOCITY;
+          state.velocity =
+              glm::ivec2(quantize(v->value.x, NET_VELOCITY_PRECISION),
+                         quantize(v->value.y, NET_VELOCITY_PRECISION));
+        }
+        if (const auto *h = e.get<Health>()) {
+          state.components |= NET_HAS_HEALTH;
+          state.health = quantize(h->value, NET_HEALTH_PRECISION);
+        }
+        entities.push_back(state);
+      });
+  std::sort(entities.begin(), entities.end(),
+            [](const NetEntityState &a, const NetEntityState &b) {
+              return a.netId < b.netId;
+            });
+}
+
+uint32_t EncodeNetDelta(const std::vector<NetEntityState> &baseline,
+                        const std::vector<NetEntityState> &current,
+                        BitWriter &out) {
+  // merge the two lists, both are in netId order
+  const NetEntityState empty = {};
+  uint32_t lastNetId = 0;
+  uint32_t records = 0;
+  size_t b = 0;
+  size_t c = 0;
+  while (b < baseline.size() || c < current.size()) {
+    if (c == current.size() ||
+        (b < baseline.size() && baseline[b].netId < current[c].netId)) {
+      // gone since the baseline
+      out.WriteVarUnsigned(baseline[b].netId - lastNetId);
+      lastNetId = baseline[b].netId;
+      out.WriteBool(true);
+      records++;
+      b++;
+    } else if (b == baseline.size() || current[c].netId < baseline[b].netId) {
+      // new, written in full
+      writeRecord(lastNetId, empty, current[c], out);
+      records++;
+      c++;
+    } else {
+      if (changedFields(baseline[b], current[c]) != 0) {
+        writeRecord(lastNetId, baseline[b], current[c], out);
+        records++;
+      }
+      b++;
+      c++;
+    }
+  }
+  // netIds only go up, a gap of 0 ends the list
+  out.WriteVarUnsigned(0);
+  return records;
+}
+
+bool DecodeNetDelta(const std::vector<NetEntityState> &baseline,
+                    BitReader &in, std::vector<NetEntityState> &current,
+                    uint32_t &records) {
+  current.clear();
+  records = 0;
+  const NetEntityState empty = {};
+  uint32_t netId = 0;
+  size_t b = 0;
+  for (uint32_t gap = in.ReadVarUnsigned(); gap != 0 && !in.HasOverflowed();
+       gap = in.ReadVarUnsigned()) {
+    netId += gap;
+    records++;
+    // unchanged since the baseline
+    while (b < baseline.size() && baseline[b].netId < netId) {
+      current.push_back(baseline[b++]);
+    }
+    const bool inBaseline = b < baseline.size() && baseline[b].netId == netId;
+    const NetEntityState &from = inBaseline ? baseline[b] : empty;
+    if (inBaseline) {
+      b++;
+    }
+    if (in.ReadBool()) {
+      continue; // removed
+    }
+    NetEntityState state = from;
+    state.netId = netId;
+    const uint32_t fields = in.Read(NET_FIELD_BITS);
+    if (fields & NET_FIELD_COMPONENTS) {
+      state.components = static_cast<uint8_t>(in.Read(2));
+    }
+    if (fields & NET_FIELD_POSITION) {
+      state.position.x += in.ReadVarSigned();
+      state.position.y += in.ReadVarSigned();
+    }
+    if (fields & NET_FIELD_VELOCITY) {
+      state.velocity.x += in.ReadVarSigned();
+      state.velocity.y += in.ReadVarSigned();
+    }
+    if (fields & NET_FIELD_HEALTH) {
+      state.health += in.ReadVarSigned();
+    }
+    current.push_back(state);
+  }
+  while (b < baseline.size()) {
+    current.push_back(baseline[b++]);
+  }
+  return !in.HasOverflowed();
+}
+
+void ReplicationStats::Report(const char *name) const {
+  if (this->packets == 0) {
+    SDL_Log("%s: no packets", name);
+    return;
+  }
+  const double packets = static_cast<double>(this->packets);
+  const double seconds = static_cast<double>(this->ticks) /
+                         static_cast<double>(SDL_GetPerformanceFrequency());
+  SDL_Log("%s: %llu packets, %.1f bytes per packet, %.2f bytes per entity, "
+          "%.1f%% of the entities written",
+          name, static_cast<unsigned long long>(this->packets),
+          this->bytes / packets,
+          this->entities > 0 ? static_cast<double>(this->bytes) / this->entities
+                             : 0.0,
+          this->entities > 0 ? 100.0 * this->changedRecords / this->entities
+                             : 0.0);
+  SDL_Log("%s: %.2f us per packet, %.1f MB/s, %.1f M entities/s", name,
+          seconds * 1e6 / packets,
+          seconds > 0.0 ? this->bytes / seconds / 1e6 : 0.0,
+          seconds > 0.0 ? this->entities / seconds / 1e6 : 0.0);
+}
+
+uint32_t ReplicationServer::Track(flecs::entity entity) {
+  const uint32_t netId = this->nextNetId++;
+  entity.set<Replicated>({netId});
+  return netId;
+}
+
+void ReplicationServer::Capture(flecs::world &world, uint32_t tick) {
+  this->sequence++;
+  NetSnapshot &snapshot = this->history[this->sequence % NET_SNAPSHOT_HISTORY];
+  snapshot.sequence = this->sequence;
+  snapshot.tick = tick;
+  CaptureNetState(world, snapshot.entities);
+}
+
+bool ReplicationServer::Encode(const std::string &peer, BitWriter &out) {
+  if (this->sequence == 0) {
+    return false;
+  }
+  const Uint64 start = SDL_GetPerformanceCounter();
+  const NetSnapshot &current =
+      this->history[this->sequence % NET_SNAPSHOT_HISTORY];
+
+  // the newest snapshot the peer is known to have, if it is still around
+  const NetSnapshot *baseline = nullptr;
+  if (const auto it = this->acked.find(peer); it != this->acked.end()) {
+    const uint32_t distance = this->sequence - it->second;
+    const NetSnapshot &acked = this->history[it->second % NET_SNAPSHOT_HISTORY];
+    if (distance < NET_SNAPSHOT_HISTORY && acked.sequence == it->second) {
+      baseline = &acked;
+    }
+  }
+
+  static const std::vector<NetEntityState> none;
+  const size_t startBytes = out.GetData().size();
+  out.Write(NET_PACKET_SNAPSHOT, 8);
+  out.Write(current.sequence, 32);
+  out.Write(current.tick, 32);
+  out.WriteBool(baseline != nullptr);
+  if (baseline != nullptr) {
+    out.Write(current.sequence - baseline->sequence,
+              NET_SNAPSHOT_HISTORY_BITS);
+  }
+  const uint32_t records = EncodeNetDelta(
+      baseline != nullptr ? baseline->entities : none, current.entities, out);
+
+  this->stats.packets++;
+  this->stats.bytes += out.GetData().size() - startBytes;
+  this->stats.entities += current.entities.size();
+  this->stats.changedRecords += records;
+  this->stats.ticks += SDL_GetPerformanceCounter() - start;
+  return true;
+}
+
+bool ReplicationServer::ReadAck(const std::string &peer, BitReader &in) {
+  const uint32_t sequence = in.Read(32);
+  if (in.HasOverflowed() || sequence == 0 || sequence > this->sequence) {
+    return false;
+  }
+  // acks can arrive out of order, keep the newest
+  uint32_t &acked = this->acked[peer];
+  acked = std::max(acked, sequence);
+  return true;
+}
+
+void ReplicationServer::RemovePeer(const std::string &peer) {
+  this->acked.erase(peer);
+}
+
+bool ReplicationClient::Decode(BitReader &in) {
+  const Uint64 start = SDL_GetPerformanceCounter();
+  NetSnapshot snapshot;
+  snapshot.sequence = in.Read(32);
+  snapshot.tick = in.Read(32);
+  const bool delta = in.ReadBool();
+  const uint32_t distance = delta ? in.Read(NET_SNAPSHOT_HISTORY_BITS) : 0;
+  if (in.HasOverflowed() || snapshot.sequence <= this->sequence) {
+    return false;
+  }
+
+  static const std::vector<NetEntityState> none;
+  const std::vector<NetEntityState> *baseline = &none;
+  if (delta) {
+    const uint32_t sequence = snapshot.sequence - distance;
+    const NetSnapshot &acked = this->history[sequence % NET_SNAPSHOT_HISTORY];
+    if (distance == 0 || acked.sequence != sequence) {
+      return false;
+    }
+    baseline = &acked.entities;
+  }
+  uint32_t records;
+  if (!DecodeNetDelta(*baseline, in, snapshot.entities, records)) {
+    return false;
+  }
+
+  this->sequence = snapshot.sequence;
+  this->stats.packets++;
+  this->stats.bytes += (in.GetBitCount() + 7) / 8;
+  this->stats.entities += snapshot.entities.size();
+  this->stats.changedRecords += records;
+  this->history[snapshot.sequence % NET_SNAPSHOT_HISTORY] =
+      std::move(snapshot);
+  this->stats.ticks += SDL_GetPerformanceCounter() - start;
+  return true;
+}
+
+void ReplicationClient::EncodeAck(BitWriter &out) const {
+  out.Write(NET_PACKET_ACK, 8);
+  out.Write(this->sequence, 32);
+}
+
+const NetSnapshot &ReplicationClient::GetLatest() const {
+  return this->history[this->sequence % NET_SNAPSHOT_HISTORY];
+}
+
+void ReplicationClient::Apply(flecs::world &world) {
+  if (this->sequence == 0 || this->sequence == this->applied) {
+    return;
+  }
+  const NetSnapshot &latest = this->GetLatest();
+
+  // whatever is left in entities afterwards is gone from the snapshot
+  std::unordered_map<uint32_t, flecs::entity> live;
+  live.reserve(latest.entities.size());
+  for (const NetEntityState &state : latest.entities) {
+    flecs::entity e;
+    if (const auto it = this->entities.find(state.netId);
+        it != this->entities.end() && it->second.is_alive()) {
+      e = it->second;
+      this->entities.erase(it);
+    } else {
+      const glm::vec2 position =
+          glm::vec2(state.position) / NET_POSITION_PRECISION;
+      e = world.entity()
+              .set<Replicated>({state.netId})
+              .set<Transform2D>(Transform2D().WithPosition(position));
+    }
+    auto *t = e.get_mut<Transform2D>();
+    t->position = glm::vec2(state.position) / NET_POSITION_PRECISION;
+    if (state.components & NET_HAS_VELOCITY) {
+      e.set<Velocity>({glm::vec2(state.velocity) / NET_VELOCITY_PRECISION});
+    }
+    if (state.components & NET_HAS_HEALTH) {
+      e.set<Health>({state.health / NET_HEALTH_PRECISION});
+    }
+    live.emplace(state.netId, e);
+  }
+  for (auto &[netId, e] : this->entities) {
+    if (e.is_alive()) {
+      e.destruct();
+    }
+  }
+  this->entities = std::move(live);
+  this->applied = this->sequence;
+}
@@ -0,0 +1,74 @@
+#include "rollback-world.hpp"
+#include <plugins/timestep.hpp>
+#include <replay.hpp>
+
+RollbackWorld::RollbackWorld(flecs::world &ecs) : ecs(ecs) {
+  this->Track<RollbackInputs>();
+}
+
+RollbackWorld::~RollbackWorld() {
+  // back to InputManager
+  this->ecs.remove<RollbackInputs>();
+}
+
+void RollbackWorld::SaveState(uint32_t tick) {
+  const int slot = tick % ROLLBACK_HISTORY;
+  if (tick < this->frontier && tick != this->loaded) {
+    // re-simulating, the tick gets what was set before it the first time
+    for (const auto &singleton : this->betweenTicks) {
+      singleton.load(slot);
+    }
+  }
+
+  if (!this->snapshots[slot]) {
+    this->snapshots[slot] = std::make_unique<flecs::snapshot>(this->ecs);
+  }
+  this->snapshots[slot]->take();
+  for (const auto &singleton : this->singletons) {
+    singleton.save(slot);
+  }
+  this->saved = tick;
+}
+
+void RollbackWorld::LoadState(uint32_t tick) {
+  const int slot = tick % ROLLBACK_HISTORY;
+  // kept for the tick after the re-simulated ones
+  for (const auto &singleton : this->betweenTicks) {
+    singleton.save(ROLLBACK_SINCE_LAST_TICK);
+  }
+  // restoring uses the snapshot up, the re-simulation saves it again
+  this->snapshots[slot]->restore();
+  for (const auto &singleton : this->singletons) {
+    singleton.load(slot);
+  }
+  this->loaded = tick;
+}
+
+void RollbackWorld::Step(const RollbackInput *inputs, bool resimulating) {
+  // the presses are against the inputs of the tick before, which are rolled
+  // back with the rest
+  const RollbackInputs *last = this->ecs.get<RollbackInputs>();
+  RollbackInputs next = {};
+  for (int p = 0; p < ROLLBACK_MAX_PLAYERS; p++) {
+    next.players[p].SetActions(inputs[p],
+                               last != nullptr ? last->players[p].actionsDown
+                                               : 0);
+  }
+  next.resimulating = resimulating;
+  this->ecs.set<RollbackInputs>(next);
+
+  const FixedTimestep *timestep = this->ecs.get<FixedTimestep>();
+  this->ecs.set_pipeline(timestep->simulation);
+  this->ecs.progress(1.0f / timestep->settings.tickRate);
+
+  if (this->saved >= this->frontier) {
+    this->frontier = this->saved + 1;
+  } else if (this->saved + 1 == this->frontier) {
+    // caught up, back to what was set since the last tick
+    for (const auto &singleton : this->betweenTicks) {
+      singleton.load(ROLLBACK_SINCE_LAST_TICK);
+    }
+  }
+}
+
+uint64_t RollbackWorld::Checksum() { return HashWorldState(this->ecs); }
@@ -0,0 +1,259 @@
+#include "rollback.hpp"
+#include <SDL2/SDL.h>
+#include <algorithm>
+
+// weight of the last step in the mean step cost
+#define ROLLBACK_STEP_SMOOTHING 0.05
+
+static double counterToMs(uint64_t counter) {
+  return counter * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void RollbackStats::Report() const {
+  SDL_Log("Rollback: %llu ticks, %llu stalls, %llu rollbacks re-simulating "
+          "%llu ticks",
+          static_cast<unsigned long long>(this->ticks),
+          static_cast<unsigned long long>(this->stalls),
+          static_cast<unsigned long long>(this->rollbacks),
+          static_cast<unsigned long long>(this->resimulatedTicks));
+  const uint64_t steps = this->ticks + this->resimulatedTicks;
+  if (steps > 0) {
+    SDL_Log("Rollback step ms: mean %.3f",
+            counterToMs(this->stepCounter) / steps);
+  }
+  if (this->rollbacks > 0) {
+    SDL_Log("Rollback re-simulation ms: mean %.3f max %.3f, %.1f ticks each",
+            counterToMs(this->resimulateCounter) / this->rollbacks,
+            counterToMs(this->maxResimulateCounter),
+            static_cast<double>(this->resimulatedTicks) / this->rollbacks);
+  }
+  SDL_Log("Rollback checksums compared: %llu",
+          static_cast<unsigned long long>(this->checksumsCompared));
+}
+
+RollbackSession::RollbackSession(RollbackSimulation &simulation,
+                                 const RollbackSettings &settings)
+    : simulation(simulation), settings(settings) {
+  this->settings.players =
+      std::clamp(this->settings.players, 1, ROLLBACK_MAX_PLAYERS);
+  this->settings.maxRollbackTicks =
+      std::clamp(this->settings.maxRollbackTicks, 1, ROLLBACK_HISTORY - 1);
+  this->settings.checksumInterval =
+      std::max(this->settings.checksumInterval, 1u);
+}
+
+RollbackSession::InputRecord &RollbackSession::record(int player,
+                                                      uint32_t tick) {
+  return this->inputs[player][tick % ROLLBACK_INPUT_HISTORY];
+}
+
+RollbackInput RollbackSession::predict(int player) const {
+  // whatever the player did last, held inputs are the common case
+  return this->lastConfirmed[player];
+}
+
+uint32_t RollbackSession::confirmedTick() const {
+  uint32_t tick = UINT32_MAX;
+  for (int p = 0; p < this->settings.players; p++) {
+    tick = std::min(tick, this->confirmed[p]);
+  }
+  return tick;
+}
+
+int RollbackSession::GetPredictedTicks() const {
+  const uint32_t confirmed = this->confirmedTick();
+  return confirmed < this->tick ? static_cast<int>(this->tick - confirmed)
+                                : 0;
+}
+
+int RollbackSession::GetPredictionLimit() const {
+  int limit = this->settings.maxRollbackTicks;
+  if (this->settings.frameBudgetMs > 0.0f && this->meanStep > 0.0) {
+    // a full rollback and the new tick have to fit the budget
+    const double steps =
+        this->settings.frameBudgetMs / counterToMs(this->meanStep) - 1.0;
+    limit = static_cast<int>(
+        std::clamp(steps, 1.0, static_cast<double>(limit)));
+  }
+  return limit;
+}
+
+bool RollbackSession::AddLocalInput(RollbackInput input) {
+  const int local = this->settings.localPlayer;
+  InputRecord &r = this->record(local, this->tick);
+  if (r.tick == this->tick && r.confirmed) {
+    return false;
+  }
+  r = {this->tick, input, true, input, false};
+  this->confirmed[local] = this->tick + 1;
+  this->lastConfirmed[local] = input;
+  return true;
+}
+
+void RollbackSession::AddRemoteInput(int player, uint32_t tick,
+                                     RollbackInput input) {
+  if (player < 0 || player >= this->settings.players ||
+      player == this->settings.localPlayer) {
+    return;
+  }
+  // already in, or too far ahead to keep
+  if (tick < this->confirmed[player] ||
+      tick - this->confirmed[player] >= ROLLBACK_INPUT_HISTORY) {
+    return;
+  }
+  InputRecord &r = this->record(player, tick);
+  if (r.tick == tick && r.confirmed) {
+    return;
+  }
+  const bool ran = r.tick == tick && r.ran;
+  if (ran && r.used != input) {
+    this->rollbackTick = std::min(this->rollbackTick, tick);
+  }
+  r = {tick, input, true, ran ? r.used : input, ran};
+
+  while (true) {
+    const InputRecord &next = this->record(player, this->confirmed[player]);
+    if (next.tick != this->confirmed[player] || !next.confirmed) {
+      break;
+    }
+    this->lastConfirmed[player] = next.input;
+    this->confirmed[player]++;
+  }
+}
+
+void RollbackSession::simulate(uint32_t tick, bool resimulating) {
+  this->simulation.SaveState(tick);
+
+  RollbackInput inputs[ROLLBACK_MAX_PLAYERS] = {};
+  for (int p = 0; p < this->settings.players; p++) {
+    InputRecord &r = this->record(p, tick);
+    if (r.tick != tick) {
+      r = {tick, 0, false, 0, false};
+    }
+    inputs[p] = r.confirmed ? r.input : this->predict(p);
+    r.used = inputs[p];
+    r.ran = true;
+  }
+
+  const uint64_t start = SDL_GetPerformanceCounter();
+  this->simulation.Step(inputs, resimulating);
+  const uint64_t cost = SDL_GetPerformanceCounter() - start;
+  this->stats.stepCounter += cost;
+  this->meanStep = this->meanStep == 0.0
+                       ? cost
+                       : this->meanStep + (cost - this->meanStep) *
+                                              ROLLBACK_STEP_SMOOTHING;
+
+  if ((tick + 1) % this->settings.checksumInterval == 0) {
+    this->pendingChecksums[tick] = this->simulation.Checksum();
+  }
+}
+
+void RollbackSession::Rollback() {
+  if (this->rollbackTick < this->tick) {
+    const uint64_t start = SDL_GetPerformanceCounter();
+    this->simulation.LoadState(this->rollbackTick);
+    for (uint32_t t = this->rollbackTick; t < this->tick; t++) {
+      this->simulate(t, true);
+    }
+    const uint64_t cost = SDL_GetPerformanceCounter() - start;
+    this->stats.rollbacks++;
+    this->stats.resimulatedTicks += this->tick - this->rollbackTick;
+    this->stats.resimulateCounter += cost;
+    this->stats.maxResimulateCounter =
+        std::max(this->stats.maxResimulateCounter, cost);
+  }
+  this->rollbackTick = UINT32_MAX;
+  this->settleChecksums();
+}
+
+bool RollbackSession::AdvanceTick() {
+  this->Rollback();
+
+  const InputRecord &local =
+      this->record(this->settings.localPlayer, this->tick);
+  if (local.tick != this->tick || !local.confirmed) {
+    return false;
+  }
+  // a rollback past the saved states couldn't be undone
+  if (this->GetPredictedTicks() >= this->GetPredictionLimit()) {
+    this->stats.stalls++;
+    return false;
+  }
+
+  this->simulate(this->tick, false);
+  this->tick++;
+  this->stats.ticks++;
+  this->settleChecksums();
+  return true;
+}
+
+void RollbackSession::settleChecksums() {
+  // a tick can still change while any input up to it is predicted
+  const uint32_t settled =
+      std::min({this->confirmedTick(), this->tick, this->rollbackTick});
+  while (!this->pendingChecksums.empty() &&
+         this->pendingChecksums.begin()->first < settled) {
+    const auto [tick, checksum] = *this->pendingChecksums.begin();
+    this->pendingChecksums.erase(this->pendingChecksums.begin());
+    this->finalChecksums[tick] = checksum;
+    for (int p = 0; p < this->settings.players; p++) {
+      const auto remote = this->remoteChecksums.find(
+          static_cast<uint64_t>(tick) * ROLLBACK_MAX_PLAYERS + p);
+      if (remote != this->remoteChecksums.end()) {
+        this->compare(tick, checksum, remote->second);
+        this->remoteChecksums.erase(remote);
+      }
+    }
+  }
+  while (this->finalChecksums.size() > ROLLBACK_CHECKSUM_HISTORY) {
+    this->finalChecksums.erase(this->finalChecksums.begin());
+  }
+}
+
+bool RollbackSession::PopChecksum(uint32_t &tick, uint64_t &checksum) {
+  const auto next = this->finalChecksums.lower_bound(this->nextPop);
+  if (next == this->finalChecksums.end()) {
+    return false;
+  }
+  tick = next->first;
+  checksum = next->second;
+  this->nextPop = tick + 1;
+  return true;
+}
+
+void RollbackSession::AddRemoteChecksum(int player, uint32_t tick,
+                                        uint64_t checksum) {
+  if (player < 0 || player >= this->settings.players) {
+    return;
+  }
+  const auto local = this->finalChecksums.find(tick);
+  if (local != this->finalChecksums.end()) {
+    this->compare(tick, local->second, checksum);
+    return;
+  }
+  if (!this->finalChecksums.empty() &&
+      tick < this->finalChecksums.begin()->first) {
+    return; // ours is gone
+  }
+  this->remoteChecksums[static_cast<uint64_t>(tick) * ROLLBACK_MAX_PLAYERS +
+                        player] = checksum;
+  while (this->remoteChecksums.size() >
+         ROLLBACK_CHECKSUM_HISTORY * ROLLBACK_MAX_PLAYERS) {
+    this->remoteChecksums.erase(this->remoteChecksums.begin());
+  }
+}
+
+void RollbackSession::compare(uint32_t tick, uint64_t local,
+                              uint64_t remote) {
+  this->stats.checksumsCompared++;
+  if (local == remote || (this->desynced && this->desyncTick <= tick)) {
+    return;
+  }
+  this->desynced = true;
+  this->desyncTick = tick;
+  SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+               "Desync at tick %u, checksum %016llx here and %016llx remote",
+               tick, static_cast<unsigned long long>(local),
+               static_cast<unsigned long long>(remote));
+}
@@ -0,0 +1,159 @@
+#include "spatial-grid.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+// caps memory when a few items are very far apart, the cells grow instead
+#define SPATIAL_GRID_MAX_CELLS (1 << 16)
+
+SpatialGrid::SpatialGrid(float cellSize)
+    : cellSize(cellSize), minCellSize(cellSize), origin(0, 0), columns(0),
+      rows(0) {
+  this->Clear();
+}
+
+void SpatialGrid::Clear() {
+  this->aabbs.clear();
+  this->cellItems.clear();
+  this->cellStart.assign(1, 0);
+  this->columns = 0;
+  this->rows = 0;
+  this->bounds = glm::vec4(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+}
+
+uint32_t SpatialGrid::Insert(glm::vec4 aabb) {
+  this->bounds = glm::vec4(glm::min(this->bounds.x, aabb.x),
+                           glm::min(this->bounds.y, aabb.y),
+                           glm::max(this->bounds.z, aabb.z),
+                           glm::max(this->bounds.w, aabb.w));
+  this->aabbs.push_back(aabb);
+  return this->aabbs.size() - 1;
+}
+
+glm::ivec2 SpatialGrid::cellOf(glm::vec2 point) const {
+  const int x = static_cast<int>((point.x - this->origin.x) / this->cellSize);
+  const int y = static_cast<int>((point.y - this->origin.y) / this->cellSize);
+  return glm::ivec2(glm::clamp(x, 0, this->columns - 1),
+                    glm::clamp(y, 0, this->rows - 1));
+}
+
+int SpatialGrid::cornerCell(float x, float y) const {
+  const glm::ivec2 cell = this->cellOf(glm::vec2(x, y));
+  return cell.x + cell.y * this->columns;
+}
+
+int SpatialGrid::pairCell(uint32_t a, uint32_t b) const {
+  const glm::vec4 &aabbA = this->aabbs[a];
+  const glm::vec4 &aabbB = this->aabbs[b];
+  return this->cornerCell(glm::max(aabbA.x, aabbB.x),
+                          glm::max(aabbA.y, aabbB.y));
+}
+
+void SpatialGrid::Build() {
+  if (this->aabbs.empty()) {
+    return;
+  }
+
+  // size the grid to the inserted items
+  const glm::vec2 size(this->bounds.z - this->bounds.x,
+                       this->bounds.w - this->bounds.y);
+  this->origin = glm::vec2(this->bounds.x, this->bounds.y);
+  this->cellSize = this->minCellSize;
+  while ((size.x / this->cellSize + 1) * (size.y / this->cellSize + 1) >
+         SPATIAL_GRID_MAX_CELLS) {
+    this->cellSize *= 2.0f;
+  }
+  this->columns = static_cast<int>(size.x / this->cellSize) + 1;
+  this->rows = static_cast<int>(size.y / this->cellSize) + 1;
+
+  // counting sort the items into their cells
+  const int cellCount = this->columns * this->rows;
+  this->cellStart.assign(cellCount + 1, 0);
+  for (const auto &aabb : this->aabbs) {
+    const glm::ivec2 min = this->cellOf(glm::vec2(aabb.x, aabb.y));
+    const glm::ivec2 max = this->cellOf(glm::vec2(aabb.z, aabb.w));
+    for (int y = min.y; y <= max.y; y++) {
+      for (int x = min.x; x <= max.x; x++) {
+        this->cellStart[x + y * this->columns + 1]++;
+      }
+    }
+  }
+  for (int cell = 0; cell < cellCount; cell++) {
+    this->cellStart[cell + 1] += this->cellStart[cell];
+  }
+
+  this->cellItems.resize(this->cellStart[cellCount]);
+  std::vector<uint32_t> cursor(this->cellStart.begin(),
+                               this->cellStart.end() - 1);
+  for (uint32_t item = 0; item < this->aabbs.size(); item++) {
+    const glm::vec4 &aabb = this->aabbs[item];
+    const glm::ivec2 min = this->cellOf(glm::vec2(aabb.x, aabb.y));
+    const glm::ivec2 max = this->cellOf(glm::vec2(aabb.z, aabb.w));
+    for (int y = min.y; y <= max.y; y++) {
+      for (int x = min.x; x <= max.x; x++) {
+        this->cellItems[cursor[x + y * this->columns]++] = item;
+      }
+    }
+  }
+}
+
+void SpatialGrid::QueryAABB(glm::vec4 aabb,
+                            std::vector<uint32_t> &out) const {
+  this->ForEachInAABB(aabb, [&out](uint32_t item) { out.push_back(item); });
+}
+
+void SpatialGrid::QueryRadius(glm::vec2 center, float radius,
+                              std::vector<uint32_t> &out) const {
+  const size_t first = out.size();
+  this->QueryAABB(glm::vec4(center.x - radius, center.y - radius,
+                            center.x + radius, center.y + radius),
+                  out);
+
+  // keep the items whose closest point is within the radius
+  const auto outside = [this, center, radius](uint32_t item) {
+    const glm::vec4 &aabb = this->aabbs[item];
+    const glm::vec2 closest(glm::clamp(center.x, aabb.x, aabb.z),
+                            glm::clamp(center.y, aabb.y, aabb.w));
+    const glm::vec2 delta = center - closest;
+    return delta.x * delta.x + delta.y * delta.y > radius * radius;
+  };
+  out.erase(std::remove_if(out.begin() + first, out.end(), outside),
+            out.end());
+}
+
+float SpatialGrid::sweep(const glm::vec4 &moving, glm::vec2 delta,
+                         const glm::vec4 &target, glm::vec2 &normal) {
+  const float miss = 2.0f;
+  float entry[2];
+  float exit[2];
+  for (int axis = 0; axis < 2; axis++) {
+    const float movingMin = moving[axis];
+    const float movingMax = moving[axis + 2];
+    const float targetMin = target[axis];
+    const float targetMax = target[axis + 2];
+    if (delta[axis] == 0.0f) {
+      // not moving on this axis, it has to overlap the whole time
+      if (movingMax <= targetMin || targetMax <= movingMin) {
+        return miss;
+      }
+      entry[axis] = -FLT_MAX;
+      exit[axis] = FLT_MAX;
+    } else if (delta[axis] > 0.0f) {
+      entry[axis] = (targetMin - movingMax) / delta[axis];
+      exit[axis] = (targetMax - movingMin) / delta[axis];
+    } else {
+      entry[axis] = (targetMax - movingMin) / delta[axis];
+      exit[axis] = (targetMin - movingMax) / delta[axis];
+    }
+  }
+
+  const float toi = glm::max(entry[0], entry[1]);
+  if (toi < 0.0f || toi > 1.0f || toi >= glm::min(exit[0], exit[1])) {
+    return miss;
+  }
+  // the last axis to start overlapping is the face that was hit
+  const int axis = entry[0] >= entry[1] ? 0 : 1;
+  normal = glm::vec2(0, 0);
+  normal[axis] = delta[axis] > 0.0f ? -1.0f : 1.0f;
+  return toi;
+}
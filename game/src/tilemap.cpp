@@ -2,246 +2,547 @@
 #include "SDL2/SDL_log.h"
 #include "asset-manager.hpp"
 #include "glad/glad.h"
+#include <bit>
+#include <string>
+
+bool Tilemap::deterministicStreaming = false;
+
+void Tilemap::SetDeterministicStreaming(bool enabled) {
+  deterministicStreaming = enabled;
+}
+
+uint32_t Tilemap::GetStreamEpoch() const { return this->epoch; }
+
+void Tilemap::SetVisibleEpoch(uint32_t epoch) { this->visibleEpoch = epoch; }
+
+void Tilemap::PinEpoch(uint32_t epoch) { this->pinnedEpoch = epoch; }
 
 Tilemap::Tilemap(const char *path) {
-  this->map.load(path);
+  const auto start = SDL_GetPerformanceCounter();
+
+  if (!this->load(path)) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load level: %s",
+                 path);
+    this->header = nullptr;
+    return;
+  }
 
-  // load the textures
-  const auto &tilesets = map.getTilesets();
-  for (const auto &ts : tilesets) {
+  // load the tileset texture, the path is relative to the level file. levels
+  // without one aren't drawn, so they load without a renderer
+  const std::string pathStr = path;
+  const std::string levelDir = pathStr.substr(0, pathStr.find_last_of("/"));
+  const std::string image = this->file.at<char>(this->header->stringsOffset) +
+                            this->header->tilesetImage;
+  if (!image.empty()) {
     this->textures.push_back(
-        AssetManager<Texture>::get(ts.getImagePath().c_str()));
+        AssetManager<Texture>::get((levelDir + "/" + image).c_str()));
   }
 
-  this->initObjects();
+  const auto elapsed = (SDL_GetPerformanceCounter() - start) * 1000.0 /
+                       SDL_GetPerformanceFrequency();
+  SDL_Log("Loaded level %s (%ux%u tiles in %ux%u chunks, %u spawns) in %.3fms",
+          path, this->header->width, this->header->height,
+          this->header->chunkColumns, this->header->chunkRows,
+          this->header->spawnCount, elapsed);
 }
 
 Tilemap::~Tilemap() {}
 
-// @TODO: use a pixel buffer and do this on the GPU instead of drawing a bunch
-// of quads
-void Tilemap::Draw(SpriteBatch *spriteBatch) {
-  // loop over the map's layers
-  for (int i = 0; i < map.getLayers().size(); i++) {
-    const auto &layer = map.getLayers()[i];
-    // skip all layers that are not tile layers
-    if (layer->getType() != tmx::Layer::Type::Tile) {
-      continue;
-    }
-    // cast to a tile layer
-    const auto tileLayer = layer->getLayerAs<tmx::TileLayer>();
+// first + count items fit in size, without overflowing
+static bool inRange(uint32_t first, uint32_t count, uint32_t size) {
+  return count <= size && first <= size - count;
+}
 
-    // loop over all the tiles in the layer (x and y)
-    for (int x = 0; x < tileLayer.getSize().x; x++) {
-      for (int y = 0; y < tileLayer.getSize().y; y++) {
-        // draw the tile
-        const auto tile = tileLayer.getTiles()[x + y * tileLayer.getSize().x];
-        if (tile.ID == 0) {
-          continue;
-        }
+bool Tilemap::load(const char *path) {
+  // only the metadata is mapped, the chunk tiles are streamed in
+  if (!this->file.open(path, sizeof(LevelHeader))) {
+    return false;
+  }
+  this->header = this->file.at<LevelHeader>(0);
+  if (this->header == nullptr || this->header->magic != LEVEL_MAGIC ||
+      this->header->version != LEVEL_VERSION) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "Tilemap::load: not a version %d level file", LEVEL_VERSION);
+    return false;
+  }
+  const uint32_t metadataSize = this->header->chunkDataOffset;
+  if (!this->file.open(path, metadataSize)) {
+    return false;
+  }
+  this->header = this->file.at<LevelHeader>(0);
+  if (this->header == nullptr) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "Tilemap::load: level file is truncated");
+    return false;
+  }
 
-        // get the texture for this tile
-        const auto &texture =
-            this->textures[0]; // @TODO: support multiple tilesets
+  // validate every section and every offset into them once so lookups don't
+  // need to bounds check. the chunk table entries are checked as the
+  // streamer reads them, walking them here would page in all of it
+  const auto &h = *this->header;
+  const size_t chunkCount = static_cast<size_t>(h.chunkColumns) * h.chunkRows;
+  if (chunkCount == 0 || h.chunkColumns * LEVEL_CHUNK_TILES < h.width ||
+      h.chunkRows * LEVEL_CHUNK_TILES < h.height ||
+      !this->file.at<LevelChunk>(h.chunksOffset, chunkCount) ||
+      !this->file.at<LevelString>(h.classesOffset, h.classCount) ||
+      !this->file.at<LevelSpawn>(h.spawnsOffset, h.spawnCount) ||
+      !this->file.at<uint32_t>(h.uidIndexOffset, h.uidCount) ||
+      !this->file.at<glm::vec2>(h.pointsOffset, h.pointCount) ||
+      !this->file.at<char>(h.stringsOffset, h.stringsSize) ||
+      h.tilesetImage >= h.stringsSize ||
+      // the tileset image is read as a c string
+      this->file.at<char>(h.stringsOffset)[h.stringsSize - 1] != '\0') {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "Tilemap::load: level file is truncated");
+    return false;
+  }
+  const auto *classes = this->file.at<LevelString>(h.classesOffset);
+  for (uint32_t i = 0; i < h.classCount; i++) {
+    if (!inRange(classes[i].offset, classes[i].length, h.stringsSize)) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "Tilemap::load: class %u has an invalid name", i);
+      return false;
+    }
+  }
+  const auto *spawns = this->file.at<LevelSpawn>(h.spawnsOffset);
+  for (uint32_t i = 0; i < h.spawnCount; i++) {
+    const auto &spawn = spawns[i];
+    if (!inRange(spawn.className.offset, spawn.className.length,
+                 h.stringsSize) ||
+        !inRange(spawn.name.offset, spawn.name.length, h.stringsSize) ||
+        !inRange(spawn.firstPoint, spawn.pointCount, h.pointCount)) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "Tilemap::load: spawn %u has invalid strings or points", i);
+      return false;
+    }
+  }
+  const auto *uidIndex = this->file.at<uint32_t>(h.uidIndexOffset);
+  for (uint32_t i = 0; i < h.uidCount; i++) {
+    if (uidIndex[i] != LEVEL_NO_OBJECT && uidIndex[i] >= h.spawnCount) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "Tilemap::load: uid %u points past the spawns", i);
+      return false;
+    }
+  }
 
-        // get the position of the tile
-        const glm::vec2 position =
-            glm::vec2(x * map.getTileSize().x, y * map.getTileSize().y);
+  this->solidClass = this->FindTileClass("SOLID");
+  return this->streamer.Open(path, h, this->solidClass);
+}
 
-        // get the xy index of the tile in the tileset
-        const int tilesetColumns =
-            texture->GetTextureRect().z / map.getTileSize().x;
-        const int tileX = (tile.ID - 1) % tilesetColumns;
-        const int tileY = (tile.ID - 1) / tilesetColumns;
+glm::ivec2 Tilemap::chunkOf(glm::vec2 point) const {
+  const glm::vec2 chunkSize(LEVEL_CHUNK_TILES * this->header->tileWidth,
+                            LEVEL_CHUNK_TILES * this->header->tileHeight);
+  const glm::ivec2 chunk(glm::floor(point / chunkSize));
+  return glm::ivec2(
+      glm::clamp(chunk.x, 0, static_cast<int>(this->header->chunkColumns) - 1),
+      glm::clamp(chunk.y, 0, static_cast<int>(this->header->chunkRows) - 1));
+}
 
-        // create the src rect for the image from the tileset
-        const glm::vec4 srcRect =
-            glm::vec4(tileX * map.getTileSize().x, tileY * map.getTileSize().y,
-                      map.getTileSize().x, map.getTileSize().y);
+int Tilemap::chunkDistance(uint32_t chunk, glm::ivec2 center) const {
+  const int x = chunk % this->header->chunkColumns;
+  const int y = chunk / this->header->chunkColumns;
+  return glm::max(glm::abs(x - center.x), glm::abs(y - center.y));
+}
 
-        // draw the tile
-        spriteBatch->Draw(texture.get(), position, glm::vec2(1, 1), 0,
-                          glm::vec4(1, 1, 1, 1), srcRect);
-      }
+const TilemapChunk *Tilemap::findChunk(int chunkX, int chunkY) const {
+  if (chunkX < 0 || chunkY < 0 ||
+      chunkX >= static_cast<int>(this->header->chunkColumns) ||
+      chunkY >= static_cast<int>(this->header->chunkRows)) {
+    return nullptr;
+  }
+  const uint32_t index = chunkX + chunkY * this->header->chunkColumns;
+  const auto found = this->resident.find(index);
+  if (found != this->resident.end() &&
+      found->second.loaded <= this->visibleEpoch) {
+    return found->second.chunk.get();
+  }
+  // empty unless a rollback re-simulates a tick from before it went out
+  for (const auto &pinned : this->pinned) {
+    if (pinned.chunk->index == index && pinned.loaded <= this->visibleEpoch &&
+        this->visibleEpoch < pinned.unloaded) {
+      return pinned.chunk.get();
     }
   }
+  return nullptr;
 }
 
-void Tilemap::DrawColliders(SpriteBatch *spriteBatch) {
-  // loop over the map's layers
-  for (int i = 0; i < map.getLayers().size(); i++) {
-    const auto &layer = map.getLayers()[i];
-    // skip all layers that are not tile layers
-    if (layer->getType() != tmx::Layer::Type::Tile) {
-      continue;
+const TilemapChunk *Tilemap::chunkOfTile(int x, int y) const {
+  if (this->header == nullptr || x < 0 || y < 0 ||
+      x >= static_cast<int>(this->header->width) ||
+      y >= static_cast<int>(this->header->height)) {
+    return nullptr;
+  }
+  return this->findChunk(x / LEVEL_CHUNK_TILES, y / LEVEL_CHUNK_TILES);
+}
+
+template <class F>
+void Tilemap::forEachSolidRect(glm::vec4 aabb, F &&fn) const {
+  const glm::ivec2 min = this->chunkOf(glm::vec2(aabb.x, aabb.y));
+  const glm::ivec2 max = this->chunkOf(glm::vec2(aabb.z, aabb.w));
+  for (int y = min.y; y <= max.y; y++) {
+    for (int x = min.x; x <= max.x; x++) {
+      const TilemapChunk *chunk = this->findChunk(x, y);
+      if (chunk == nullptr) {
+        continue;
+      }
+      // a rect never leaves its chunk, so each one is reported once
+      for (const auto &rect : chunk->solidRects) {
+        const glm::vec4 rectAABB(rect.x, rect.y, rect.x + rect.w,
+                                 rect.y + rect.h);
+        if (SpatialGrid::overlaps(aabb, rectAABB)) {
+          fn(rect);
+        }
+      }
     }
-    // cast to a tile layer
-    const auto tileLayer = layer->getLayerAs<tmx::TileLayer>();
+  }
+}
 
-    // loop over all the tiles in the layer (x and y)
-    for (int x = 0; x < tileLayer.getSize().x; x++) {
-      for (int y = 0; y < tileLayer.getSize().y; y++) {
-        // draw the tile
-        const auto tile = tileLayer.getTiles()[x + y * tileLayer.getSize().x];
-        if (tile.ID == 0) {
+void Tilemap::Stream(glm::vec2 center, std::vector<uint32_t> &loaded,
+                     std::vector<uint32_t> &unloaded) {
+  if (this->header == nullptr) {
+    return;
+  }
+  const auto &h = *this->header;
+  const glm::ivec2 centerChunk = this->chunkOf(center);
+  const int keepRadius = TILEMAP_PREFETCH_RADIUS + TILEMAP_UNLOAD_SLACK;
+  this->epoch++;
+
+  // request the missing chunks, nearest ring first
+  bool missing = false;
+  for (int r = 0; r <= TILEMAP_PREFETCH_RADIUS; r++) {
+    for (int y = centerChunk.y - r; y <= centerChunk.y + r; y++) {
+      for (int x = centerChunk.x - r; x <= centerChunk.x + r; x++) {
+        if (glm::max(glm::abs(x - centerChunk.x),
+                     glm::abs(y - centerChunk.y)) != r ||
+            x < 0 || y < 0 || x >= static_cast<int>(h.chunkColumns) ||
+            y >= static_cast<int>(h.chunkRows)) {
           continue;
         }
-
-        // get the position of the tile
-        const glm::vec2 position =
-            glm::vec2(x * map.getTileSize().x, y * map.getTileSize().y);
-
-        // get the tile type
-        const auto &tileset = map.getTilesets()[0]; // @TODO: support multiple
-                                                    // tilesets
-        const auto &tilesetTile = tileset.getTile(tile.ID);
-
-        if (tilesetTile->className == "SOLID") {
-          // draw the collider as a red rect
-          spriteBatch->DrawRect(glm::vec4(position.x, position.y,
-                                          map.getTileSize().x,
-                                          map.getTileSize().y),
-                                glm::vec4(1, 0, 0, 0.5f));
+        const uint32_t index = x + y * h.chunkColumns;
+        if (this->resident.contains(index)) {
+          continue;
+        }
+        missing |= r <= TILEMAP_STREAM_RADIUS;
+        if (this->requested.insert(index).second) {
+          this->streamer.Request(index);
         }
       }
     }
   }
-}
 
-void Tilemap::IsCollidingWith(SDL_Rect *other, SDL_Rect &found, uint64_t entity,
-                              bool &isGrounded) {
+  // the chunks right around the center can't be late, things would fall
+  // through them
+  if (missing || (deterministicStreaming && !this->requested.empty())) {
+    this->streamer.Wait();
+  }
 
-  entitiesCollidingWithMap.erase(entity);
+  this->arrived.clear();
+  this->streamer.Poll(this->arrived);
+  for (auto &chunk : this->arrived) {
+    const uint32_t index = chunk->index;
+    this->requested.erase(index);
+    if (this->chunkDistance(index, centerChunk) > keepRadius) {
+      this->streamer.Recycle(std::move(chunk)); // moved away in the meantime
+      continue;
+    }
+    this->resident[index] = {std::move(chunk), this->epoch, 0};
+    loaded.push_back(index);
+  }
 
-  // get the bounding SDL Rect for the tilemap
-  const SDL_Rect tilemapRect = {
-      0, 0, static_cast<int>(map.getTileSize().x * map.getTileCount().x),
-      static_cast<int>(map.getTileSize().y * map.getTileCount().y)};
-  // if the other rect is not colliding with the tilemap, return
-  if (!SDL_HasIntersection(other, &tilemapRect)) {
-    return;
+  // unload what the center moved away from
+  const auto unload = [&](auto it) {
+    unloaded.push_back(it->first);
+    it->second.unloaded = this->epoch;
+    this->pinned.push_back(std::move(it->second));
+    return this->resident.erase(it);
+  };
+  for (auto it = this->resident.begin(); it != this->resident.end();) {
+    if (this->chunkDistance(it->first, centerChunk) > keepRadius) {
+      it = unload(it);
+    } else {
+      it++;
+    }
+  }
+  // then the furthest ones while over the ceiling
+  while (this->resident.size() > TILEMAP_MAX_RESIDENT_CHUNKS) {
+    auto furthest = this->resident.begin();
+    for (auto it = this->resident.begin(); it != this->resident.end(); it++) {
+      if (this->chunkDistance(it->first, centerChunk) >
+          this->chunkDistance(furthest->first, centerChunk)) {
+        furthest = it;
+      }
+    }
+    unload(furthest);
   }
 
-  // get the possible tiles that could be colliding with the other rect
-  const int startX = (other->x) / map.getTileSize().x;
-  const int startY = (other->y) / map.getTileSize().y;
-  const int endX = (other->x + other->w + 1) / map.getTileSize().x;
-  const int endY = (other->y + other->h + 1) / map.getTileSize().y;
+  // the pinned epoch and the ones after it saw none of the chunks that went
+  // out by then
+  for (auto it = this->pinned.begin(); it != this->pinned.end();) {
+    if (it->unloaded <= this->pinnedEpoch) {
+      this->streamer.Recycle(std::move(it->chunk));
+      it = this->pinned.erase(it);
+    } else {
+      it++;
+    }
+  }
+  this->visibleEpoch = this->epoch;
+}
 
-  // loop over the map's layers
-  for (int i = 0; i < map.getLayers().size(); i++) {
-    const auto &layer = map.getLayers()[i];
-    // skip all layers that are not tile layers
-    if (layer->getType() != tmx::Layer::Type::Tile) {
-      continue;
+TileClass Tilemap::FindTileClass(std::string_view name) {
+  if (this->header == nullptr) {
+    return NO_TILE_CLASS;
+  }
+  const auto classes = this->file.at<LevelString>(this->header->classesOffset);
+  for (uint32_t i = 1; i < this->header->classCount; i++) {
+    if (this->GetString(classes[i]) == name) {
+      return i;
     }
-    // cast to a tile layer
-    const auto tileLayer = layer->getLayerAs<tmx::TileLayer>();
+  }
+  return NO_TILE_CLASS;
+}
 
-    SDL_Rect compositeRect = {0, 0, 0, 0};
+TileClass Tilemap::GetTileClass(int x, int y) const {
+  const TilemapChunk *chunk = this->chunkOfTile(x, y);
+  if (chunk == nullptr) {
+    return NO_TILE_CLASS;
+  }
+  return chunk->classes[x % LEVEL_CHUNK_TILES +
+                        (y % LEVEL_CHUNK_TILES) * LEVEL_CHUNK_TILES];
+}
 
-    // loop over all the possible tiles in the layer (x and y)
-    for (int x = startX; x <= endX; x++) {
-      for (int y = startY; y <= endY; y++) {
-        // draw the tile
-        const auto tile = tileLayer.getTiles()[x + y * tileLayer.getSize().x];
-        if (tile.ID == 0) {
-          continue;
-        }
+bool Tilemap::IsSolid(int x, int y) const {
+  const TilemapChunk *chunk = this->chunkOfTile(x, y);
+  if (chunk == nullptr) {
+    return false;
+  }
+  return (chunk->solidRows[y % LEVEL_CHUNK_TILES] >> (x % LEVEL_CHUNK_TILES)) &
+         1;
+}
 
-        // get the tile type
-        const auto &tileset = map.getTilesets()[0]; // @TODO: support multiple
-                                                    // tilesets
-        const auto &tilesetTile = tileset.getTile(tile.ID);
+// @TODO: use a pixel buffer and do this on the GPU instead of drawing a bunch
+// of quads
+void Tilemap::Draw(SpriteBatch *spriteBatch) {
+  if (this->header == nullptr || this->textures.empty()) {
+    return;
+  }
+  const auto &h = *this->header;
+  // get the texture for the tiles
+  const auto &texture = this->textures[0]; // @TODO: support multiple tilesets
+  const int tilesetColumns = texture->GetTextureRect().z / h.tileWidth;
+
+  // only the tiles in view, clamped to the map
+  const glm::vec4 view = spriteBatch->GetViewRect();
+  const glm::ivec2 tileSize(h.tileWidth, h.tileHeight);
+  const glm::ivec2 minTile = glm::max(
+      glm::ivec2(glm::floor(glm::vec2(view.x, view.y) / glm::vec2(tileSize))),
+      glm::ivec2(0, 0));
+  const glm::ivec2 maxTile = glm::min(
+      glm::ivec2(glm::floor(glm::vec2(view.x + view.z, view.y + view.w) /
+                            glm::vec2(tileSize))),
+      glm::ivec2(h.width - 1, h.height - 1));
+  if (minTile.x > maxTile.x || minTile.y > maxTile.y) {
+    return;
+  }
+  const glm::ivec2 minChunk = minTile / LEVEL_CHUNK_TILES;
+  const glm::ivec2 maxChunk = maxTile / LEVEL_CHUNK_TILES;
+  const int chunkTiles = LEVEL_CHUNK_TILES * LEVEL_CHUNK_TILES;
 
-        if (!tilesetTile || tilesetTile->className != "SOLID") {
+  // loop over the map's layers
+  for (uint32_t i = 0; i < h.layerCount; i++) {
+    for (int cy = minChunk.y; cy <= maxChunk.y; cy++) {
+      for (int cx = minChunk.x; cx <= maxChunk.x; cx++) {
+        const TilemapChunk *chunk = this->findChunk(cx, cy);
+        if (chunk == nullptr || chunk->gids.empty()) {
           continue;
         }
-
-        // get the position of the tile
-        const glm::vec2 position =
-            glm::vec2(x * map.getTileSize().x, y * map.getTileSize().y);
-
-        // get the bounding SDL Rect for the tile
-        const SDL_Rect tileRect = {static_cast<int>(position.x),
-                                   static_cast<int>(position.y),
-                                   static_cast<int>(map.getTileSize().x),
-                                   static_cast<int>(map.getTileSize().y)};
-
-        if (SDL_HasIntersection(other, &tileRect)) {
-          // if composite rect is 0,0,0,0
-          if (compositeRect.x == 0 && compositeRect.y == 0 &&
-              compositeRect.w == 0 && compositeRect.h == 0) {
-            // set composite rect to the tile rect
-            compositeRect = tileRect;
-          } else {
-            // otherwise, combine the tile rect with the composite rect
-            SDL_UnionRect(&compositeRect, &tileRect, &compositeRect);
+        const uint32_t *tiles = chunk->gids.data() + chunkTiles * i;
+        const glm::ivec2 origin = glm::ivec2(cx, cy) * LEVEL_CHUNK_TILES;
+        const glm::ivec2 first = glm::max(minTile, origin) - origin;
+        const glm::ivec2 last =
+            glm::min(maxTile, origin + glm::ivec2(LEVEL_CHUNK_TILES - 1)) -
+            origin;
+
+        // loop over the tiles of the chunk in view (x and y)
+        for (int y = first.y; y <= last.y; y++) {
+          for (int x = first.x; x <= last.x; x++) {
+            const uint32_t gid = tiles[x + y * LEVEL_CHUNK_TILES];
+            if (gid < h.tilesetFirstGid) {
+              continue;
+            }
+
+            // get the position of the tile
+            const glm::vec2 position =
+                glm::vec2((origin.x + x) * h.tileWidth,
+                          (origin.y + y) * h.tileHeight);
+
+            // get the xy index of the tile in the tileset
+            const int id = gid - h.tilesetFirstGid;
+            const int tileX = id % tilesetColumns;
+            const int tileY = id / tilesetColumns;
+
+            // create the src rect for the image from the tileset
+            const glm::vec4 srcRect =
+                glm::vec4(tileX * h.tileWidth, tileY * h.tileHeight,
+                          h.tileWidth, h.tileHeight);
+
+            // draw the tile
+            spriteBatch->Draw(texture.get(), position, glm::vec2(1, 1), 0,
+                              glm::vec4(1, 1, 1, 1), srcRect);
           }
         }
+      }
+    }
+  }
+}
 
-        if (!HasCollision(entity)) {
-          // check for an overlap (the other rect is inside a the tile plus some
-          // padding)
-          const SDL_Rect paddedTileRect = {tileRect.x - 1, tileRect.y - 2,
-                                           tileRect.w + 2, tileRect.h + 3};
-          if (SDL_HasIntersection(other, &paddedTileRect)) {
-            entitiesCollidingWithMap.insert(entity);
-          }
-        }
+void Tilemap::DrawColliders(SpriteBatch *spriteBatch) {
+  for (const auto &[index, resident] : this->resident) {
+    for (const auto &rect : resident.chunk->solidRects) {
+      // draw the collider as a red rect
+      spriteBatch->DrawRect(glm::vec4(rect.x, rect.y, rect.w, rect.h),
+                            glm::vec4(1, 0, 0, 0.5f));
+    }
+  }
+}
 
-        if (!isGrounded) {
-          // check for an overlap for only a padded on the top tile rect
-          const SDL_Rect aboveTileRect = {tileRect.x + 3, tileRect.y - 1,
-                                          tileRect.w - 7, 1};
+void Tilemap::IsCollidingWith(SDL_Rect *other, SDL_Rect &found,
+                              bool &isTouching, bool &isGrounded) const {
+  if (this->header == nullptr) {
+    return;
+  }
+  const auto &h = *this->header;
 
-          if (SDL_HasIntersection(other, &aboveTileRect)) {
-            entitiesCollidingWithMap.insert(entity);
-            isGrounded = true;
-          }
-        }
+  // get the bounding SDL Rect for the tilemap
+  const SDL_Rect tilemapRect = this->GetBounds();
+  // if the other rect is not colliding with the tilemap, return
+  SDL_Rect clipped;
+  if (!SDL_IntersectRect(other, &tilemapRect, &clipped)) {
+    return;
+  }
+
+  // the tiles the other rect overlaps, snapped out to the tile grid. clipping
+  // a merged rect to this gives the same composite as the per tile test did
+  const int tileW = h.tileWidth;
+  const int tileH = h.tileHeight;
+  const int startX = clipped.x / tileW;
+  const int startY = clipped.y / tileH;
+  const int endX = (clipped.x + clipped.w - 1) / tileW;
+  const int endY = (clipped.y + clipped.h - 1) / tileH;
+  const SDL_Rect snapped = {startX * tileW, startY * tileH,
+                            (endX - startX + 1) * tileW,
+                            (endY - startY + 1) * tileH};
+
+  SDL_Rect compositeRect = {0, 0, 0, 0};
+
+  // the query matches the padded rect test below exactly
+  const glm::vec4 query(other->x - 1, other->y - 1, other->x + other->w + 1,
+                        other->y + other->h + 2);
+  this->forEachSolidRect(query, [&](const SDL_Rect &solidRect) {
+    SDL_Rect overlap;
+    if (SDL_IntersectRect(&solidRect, &snapped, &overlap)) {
+      // if composite rect is 0,0,0,0
+      if (compositeRect.x == 0 && compositeRect.y == 0 &&
+          compositeRect.w == 0 && compositeRect.h == 0) {
+        // set composite rect to the overlapped tiles
+        compositeRect = overlap;
+      } else {
+        // otherwise, combine the overlapped tiles with the composite rect
+        SDL_UnionRect(&compositeRect, &overlap, &compositeRect);
       }
     }
-    if (compositeRect.x != 0 || compositeRect.y != 0 || compositeRect.w != 0 ||
-        compositeRect.h != 0) {
-      found = compositeRect;
-      entitiesCollidingWithMap.insert(entity);
-      return;
+
+    // every candidate is within the padding (the other rect is inside the
+    // solid rect plus some padding)
+    isTouching = true;
+
+    if (!isGrounded) {
+      // check for an overlap for only a padded on the top of the rect
+      const SDL_Rect aboveRect = {solidRect.x + 3, solidRect.y - 1,
+                                  solidRect.w - 7, 1};
+
+      if (SDL_HasIntersection(other, &aboveRect)) {
+        isGrounded = true;
+      }
     }
+  });
+
+  if (compositeRect.x != 0 || compositeRect.y != 0 || compositeRect.w != 0 ||
+      compositeRect.h != 0) {
+    found = compositeRect;
   }
 }
 
-std::vector<tmx::Object> Tilemap::GetObjects() { return this->objects; }
+float Tilemap::Sweep(glm::vec4 aabb, glm::vec2 delta,
+                     glm::vec2 &normal) const {
+  float toi = 2.0f;
+  if (this->header == nullptr) {
+    return toi;
+  }
 
-tmx::Object Tilemap::GetObjectByHandle(const int handle) {
-  for (const auto &object : this->objects) {
-    if (object.getUID() == handle) {
-      return object;
+  // only the rects in the swept bounds can be hit
+  const glm::vec4 moved = aabb + glm::vec4(delta, delta);
+  const glm::vec4 query(glm::min(aabb.x, moved.x), glm::min(aabb.y, moved.y),
+                        glm::max(aabb.z, moved.z), glm::max(aabb.w, moved.w));
+  this->forEachSolidRect(query, [&](const SDL_Rect &rect) {
+    const glm::vec4 target(rect.x, rect.y, rect.x + rect.w, rect.y + rect.h);
+    glm::vec2 hitNormal;
+    const float hit = SpatialGrid::sweep(aabb, delta, target, hitNormal);
+    if (hit < toi) {
+      toi = hit;
+      normal = hitNormal;
     }
+  });
+  return toi;
+}
+
+std::span<const LevelSpawn> Tilemap::GetSpawns() {
+  if (this->header == nullptr) {
+    return {};
   }
+  return {this->file.at<LevelSpawn>(this->header->spawnsOffset),
+          this->header->spawnCount};
 }
 
-SDL_Rect Tilemap::GetBounds() {
-  return {0, 0, static_cast<int>(map.getTileSize().x * map.getTileCount().x),
-          static_cast<int>(map.getTileSize().y * map.getTileCount().y)};
+std::span<const LevelSpawn> Tilemap::GetChunkSpawns(uint32_t chunk) {
+  if (this->header == nullptr) {
+    return {};
+  }
+  const TilemapChunk *resident =
+      this->findChunk(chunk % this->header->chunkColumns,
+                      chunk / this->header->chunkColumns);
+  if (resident == nullptr) {
+    return {};
+  }
+  return this->GetSpawns().subspan(resident->firstSpawn, resident->spawnCount);
 }
 
-bool Tilemap::HasCollision(uint64_t entity) {
-  return entitiesCollidingWithMap.find(entity) !=
-         entitiesCollidingWithMap.end();
+const LevelSpawn *Tilemap::GetSpawnByHandle(const uint32_t handle) {
+  if (this->header == nullptr || handle >= this->header->uidCount) {
+    return nullptr;
+  }
+  const auto index =
+      this->file.at<uint32_t>(this->header->uidIndexOffset)[handle];
+  if (index == LEVEL_NO_OBJECT) {
+    return nullptr;
+  }
+  return &this->GetSpawns()[index];
 }
 
-void Tilemap::initObjects() {
-  this->objects.clear();
-  for (const auto &layer : map.getLayers()) {
-    if (layer->getType() != tmx::Layer::Type::Object) {
-      continue;
-    }
-    // SDL_Log("Object layer: %s", layer->getName().c_str());
-    const auto objectLayer = layer->getLayerAs<tmx::ObjectGroup>();
-    for (const auto &object : objectLayer.getObjects()) {
-      SDL_Log("Object: %s", object.getName().c_str());
-      this->objects.push_back(object);
-    }
+std::span<const glm::vec2> Tilemap::GetPoints(const LevelSpawn &spawn) {
+  return {this->file.at<glm::vec2>(this->header->pointsOffset) +
+              spawn.firstPoint,
+          spawn.pointCount};
+}
+
+std::string_view Tilemap::GetString(const LevelString &string) {
+  const char *strings = this->file.at<char>(this->header->stringsOffset);
+  return {strings + string.offset, string.length};
+}
+
+SDL_Rect Tilemap::GetBounds() const {
+  if (this->header == nullptr) {
+    return {0, 0, 0, 0};
   }
+  return {0, 0, static_cast<int>(this->header->tileWidth * this->header->width),
+          static_cast<int>(this->header->tileHeight * this->header->height)};
 }
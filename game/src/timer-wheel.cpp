@@ -0,0 +1,60 @@
+#include "timer-wheel.hpp"
+
+#include <algorithm>
+
+TimerWheel::TimerWheel() : now(0), size(0), nextHandle(NO_TIMER + 1) {}
+
+TimerHandle TimerWheel::Schedule(uint64_t delayTicks, uint64_t target,
+                                 uint32_t event) {
+  // the current slot has already been processed
+  const uint64_t delay = std::max(delayTicks, uint64_t(1));
+  const TimerHandle handle = this->nextHandle++;
+  if (this->nextHandle == NO_TIMER) {
+    this->nextHandle++;
+  }
+  this->insert({this->now + delay, target, handle, event});
+  this->size++;
+  return handle;
+}
+
+void TimerWheel::insert(const TimerEntry &entry) {
+  // clamp so far off deadlines land in the last slot of the last level
+  const uint64_t delta =
+      std::min(entry.deadline - this->now, TIMER_WHEEL_RANGE - 1);
+  const uint64_t when = this->now + delta;
+  int level = 0;
+  while ((delta >> (TIMER_WHEEL_SLOT_BITS * (level + 1))) > 0) {
+    level++;
+  }
+  const uint64_t slot =
+      (when >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+  this->slots[level][slot].push_back(entry);
+}
+
+void TimerWheel::Advance(std::vector<TimerEntry> &due) {
+  this->now++;
+
+  // at the start of a level's slot its timers move down, top level first so
+  // they can cascade all the way to level 0 in one go
+  for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+    const uint64_t shift = TIMER_WHEEL_SLOT_BITS * level;
+    if ((this->now & ((uint64_t(1) << shift) - 1)) != 0) {
+      continue;
+    }
+    auto &slot =
+        this->slots[level][(this->now >> shift) & (TIMER_WHEEL_SLOTS - 1)];
+    if (slot.empty()) {
+      continue;
+    }
+    this->cascading.swap(slot);
+    for (const auto &entry : this->cascading) {
+      this->insert(entry);
+    }
+    this->cascading.clear();
+  }
+
+  auto &slot = this->slots[0][this->now & (TIMER_WHEEL_SLOTS - 1)];
+  due.insert(due.end(), slot.begin(), slot.end());
+  this->size -= slot.size();
+  slot.clear();
+}
@@ -0,0 +1,95 @@
+#include "spatial-grid.hpp"
+#include <SDL2/SDL.h>
+#include <cmath>
+#include <random>
+
+// Finds the overlapping pairs of 100 to 50k colliders with the SpatialGrid
+// the broadphase builds every tick, and with the O(n^2) loop it replaced.
+// Reports the cost of a tick for both, and checks they find the same pairs.
+
+// colliders per 1024 x 1024 px, the world grows with the count
+#define BENCH_DENSITY 200
+#define COLLIDER_MIN_SIZE 8.0f
+#define COLLIDER_MAX_SIZE 48.0f
+// the pair loop past this many colliders takes seconds, it is left out
+#define BRUTE_FORCE_MAX_COLLIDERS 20000
+#define BENCH_TICKS 20
+
+static double seconds(Uint64 start) {
+  return static_cast<double>(SDL_GetPerformanceCounter() - start) /
+         static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+static std::vector<glm::vec4> scatter(int count, std::minstd_rand &random) {
+  const float side = 1024.0f * std::sqrt(count / float(BENCH_DENSITY));
+  std::uniform_real_distribution<float> position(0.0f, side);
+  std::uniform_real_distribution<float> size(COLLIDER_MIN_SIZE,
+                                             COLLIDER_MAX_SIZE);
+  std::vector<glm::vec4> aabbs(count);
+  for (auto &aabb : aabbs) {
+    const glm::vec2 min(position(random), position(random));
+    aabb = glm::vec4(min, min + glm::vec2(size(random), size(random)));
+  }
+  return aabbs;
+}
+
+// a checksum of the pairs a tick of the grid finds, the same whichever way
+// round a pair is reported
+static uint64_t gridPairs(SpatialGrid &grid,
+                          const std::vector<glm::vec4> &aabbs) {
+  grid.Clear();
+  for (const auto &aabb : aabbs) {
+    grid.Insert(aabb);
+  }
+  grid.Build();
+  uint64_t pairs = 0;
+  grid.ForEachPair(
+      [&pairs](uint32_t a, uint32_t b) { pairs += (a + 1ull) * (b + 1); });
+  return pairs;
+}
+
+static uint64_t bruteForcePairs(const std::vector<glm::vec4> &aabbs) {
+  uint64_t pairs = 0;
+  for (uint32_t a = 0; a < aabbs.size(); a++) {
+    for (uint32_t b = a + 1; b < aabbs.size(); b++) {
+      if (SpatialGrid::overlaps(aabbs[a], aabbs[b])) {
+        pairs += (a + 1ull) * (b + 1);
+      }
+    }
+  }
+  return pairs;
+}
+
+int main(int argc, char *argv[]) {
+  std::minstd_rand random(28);
+  SpatialGrid grid;
+  int failures = 0;
+  for (const int count : {100, 1000, 5000, 10000, 20000, 50000}) {
+    const auto aabbs = scatter(count, random);
+
+    uint64_t pairs = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int tick = 0; tick < BENCH_TICKS; tick++) {
+      pairs = gridPairs(grid, aabbs);
+    }
+    const double gridTick = seconds(start) / BENCH_TICKS;
+    if (count > BRUTE_FORCE_MAX_COLLIDERS) {
+      SDL_Log("%5d colliders: grid %8.3f ms per tick", count, gridTick * 1e3);
+      continue;
+    }
+
+    start = SDL_GetPerformanceCounter();
+    const uint64_t expected = bruteForcePairs(aabbs);
+    const double bruteTick = seconds(start);
+    SDL_Log("%5d colliders: grid %8.3f ms per tick, O(n^2) %9.3f ms, %.1fx",
+            count, gridTick * 1e3, bruteTick * 1e3, bruteTick / gridTick);
+    if (pairs != expected) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "%d colliders: the grid's pairs don't match the O(n^2) "
+                   "loop's",
+                   count);
+      failures++;
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
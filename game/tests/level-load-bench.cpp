@@ -0,0 +1,96 @@
+#include "tilemap.hpp"
+#include <SDL2/SDL.h>
+#include <tmxlite/Map.hpp>
+#include <tmxlite/ObjectGroup.hpp>
+#include <tmxlite/TileLayer.hpp>
+
+// Loads the same maps from their .tmx with tmxlite, the way the runtime did
+// before levels were cooked, and from the cooked .level. Reports the time
+// of a load for both. The maps have no tileset images, a texture would need
+// a GL context.
+
+#define BENCH_LOADS 200
+
+struct BenchMap {
+  const char *tmx;
+  const char *level;
+};
+
+static double seconds(Uint64 start) {
+  return static_cast<double>(SDL_GetPerformanceCounter() - start) /
+         static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// parses the map and copies out its tiles and objects, what the TMX loader
+// used to keep. returns the tile count, 0 if it didn't load
+static size_t loadTmx(const char *path) {
+  tmx::Map map;
+  if (!map.load(path)) {
+    return 0;
+  }
+  size_t tiles = 0;
+  std::vector<tmx::TileLayer::Tile> gids;
+  std::vector<tmx::Object> objects;
+  for (const auto &layer : map.getLayers()) {
+    if (layer->getType() == tmx::Layer::Type::Tile) {
+      const auto &tileLayer = layer->getLayerAs<tmx::TileLayer>();
+      gids.insert(gids.end(), tileLayer.getTiles().begin(),
+                  tileLayer.getTiles().end());
+      tiles += tileLayer.getTiles().size();
+    } else if (layer->getType() == tmx::Layer::Type::Object) {
+      const auto &objectLayer = layer->getLayerAs<tmx::ObjectGroup>();
+      objects.insert(objects.end(), objectLayer.getObjects().begin(),
+                     objectLayer.getObjects().end());
+    }
+  }
+  return tiles;
+}
+
+// maps the level and streams in the chunks around its center, so it is as
+// ready to draw as a parsed map. false if it didn't load
+static bool loadLevel(const char *path) {
+  Tilemap map(path);
+  const SDL_Rect bounds = map.GetBounds();
+  if (bounds.w == 0) {
+    return false;
+  }
+  std::vector<uint32_t> loaded, unloaded;
+  map.Stream(glm::vec2(bounds.w / 2, bounds.h / 2), loaded, unloaded);
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  Tilemap::SetDeterministicStreaming(true);
+  const BenchMap maps[] = {
+      {TEST_MAP_DIR "/walls.tmx", TEST_LEVEL_DIR "/walls.level"},
+      {TEST_MAP_DIR "/rooms.tmx", TEST_LEVEL_DIR "/rooms.level"},
+  };
+
+  int failures = 0;
+  for (const auto &map : maps) {
+    const size_t tiles = loadTmx(map.tmx);
+    if (tiles == 0 || !loadLevel(map.level)) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%s didn't load", map.tmx);
+      failures++;
+      continue;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BENCH_LOADS; i++) {
+      loadTmx(map.tmx);
+    }
+    const double tmx = seconds(start) / BENCH_LOADS;
+    // the tilemap logs every load
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_WARN);
+    start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BENCH_LOADS; i++) {
+      loadLevel(map.level);
+    }
+    const double cooked = seconds(start) / BENCH_LOADS;
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO);
+
+    SDL_Log("%s, %zu tiles: TMX %.3f ms, cooked %.3f ms, %.1fx", map.tmx,
+            tiles, tmx * 1e3, cooked * 1e3, tmx / cooked);
+  }
+  return failures == 0 ? 0 : 1;
+}
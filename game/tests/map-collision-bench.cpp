@@ -0,0 +1,148 @@
+#include "tilemap.hpp"
+#include <SDL2/SDL.h>
+#include <random>
+
+// Collides 10k entities with the streamed in part of levels/rooms.tmx the
+// way collideWithMap does every tick. Times the tile by tile test of the
+// overlapped tiles looking up each one in the class grid and in the solid
+// bitset, against IsCollidingWith. All three have to agree.
+
+#define BENCH_ENTITIES 10000
+#define BENCH_TICKS 20
+#define ENTITY_MIN_SIZE 8
+#define ENTITY_MAX_SIZE 64
+#define TILE_SIZE 16 // of levels/rooms.tmx
+
+struct Contact {
+  SDL_Rect found = {0, 0, 0, 0};
+  bool isTouching = false;
+  bool isGrounded = false;
+};
+
+static double seconds(Uint64 start) {
+  return static_cast<double>(SDL_GetPerformanceCounter() - start) /
+         static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// the tile by tile test IsCollidingWith did before the solid tiles were
+// merged, solid(x, y) says whether a tile is solid. it starts a tile early
+// for the padding, the old loop didn't and missed the touch of a tile ending
+// right where the other rect starts
+template <class F>
+static Contact collideTiles(const SDL_Rect &other, F &&solid) {
+  Contact contact;
+  const int startX = glm::max((other.x - 1) / TILE_SIZE, 0);
+  const int startY = glm::max((other.y - 1) / TILE_SIZE, 0);
+  const int endX = (other.x + other.w + 1) / TILE_SIZE;
+  const int endY = (other.y + other.h + 1) / TILE_SIZE;
+  for (int y = startY; y <= endY; y++) {
+    for (int x = startX; x <= endX; x++) {
+      if (!solid(x, y)) {
+        continue;
+      }
+      const SDL_Rect tileRect = {x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE,
+                                 TILE_SIZE};
+      if (SDL_HasIntersection(&other, &tileRect)) {
+        if (contact.found.w == 0) {
+          contact.found = tileRect;
+        } else {
+          SDL_UnionRect(&contact.found, &tileRect, &contact.found);
+        }
+      }
+      const SDL_Rect paddedTileRect = {tileRect.x - 1, tileRect.y - 2,
+                                       tileRect.w + 2, tileRect.h + 3};
+      contact.isTouching |= SDL_HasIntersection(&other, &paddedTileRect);
+      const SDL_Rect aboveTileRect = {tileRect.x + 3, tileRect.y - 1,
+                                      tileRect.w - 7, 1};
+      contact.isGrounded |= SDL_HasIntersection(&other, &aboveTileRect);
+    }
+  }
+  return contact;
+}
+
+// grounded isn't compared, the merged rects are only inset at their ends
+static bool sameContact(const Contact &a, const Contact &b) {
+  return SDL_RectEquals(&a.found, &b.found) && a.isTouching == b.isTouching;
+}
+
+int main(int argc, char *argv[]) {
+  Tilemap::SetDeterministicStreaming(true);
+  Tilemap map(TEST_LEVEL_DIR "/rooms.level");
+  const SDL_Rect bounds = map.GetBounds();
+  const TileClass solidClass = map.FindTileClass("SOLID");
+  if (bounds.w == 0 || solidClass == NO_TILE_CLASS) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "rooms.level didn't load");
+    return 1;
+  }
+  const glm::vec2 center(bounds.w / 2, bounds.h / 2);
+  std::vector<uint32_t> loaded, unloaded;
+  map.Stream(center, loaded, unloaded);
+
+  // spread over the chunks streamed in around the center
+  const float reach =
+      (TILEMAP_STREAM_RADIUS + 0.5f) * LEVEL_CHUNK_TILES * TILE_SIZE;
+  std::minstd_rand random(30);
+  std::uniform_real_distribution<float> offset(-reach,
+                                               reach - ENTITY_MAX_SIZE);
+  std::uniform_int_distribution<int> size(ENTITY_MIN_SIZE, ENTITY_MAX_SIZE);
+  std::vector<SDL_Rect> entities(BENCH_ENTITIES);
+  for (auto &e : entities) {
+    e = {static_cast<int>(center.x + offset(random)),
+         static_cast<int>(center.y + offset(random)), size(random),
+         size(random)};
+  }
+
+  std::vector<Contact> byClass(BENCH_ENTITIES), byBitset(BENCH_ENTITIES),
+      byMap(BENCH_ENTITIES);
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int tick = 0; tick < BENCH_TICKS; tick++) {
+    for (int i = 0; i < BENCH_ENTITIES; i++) {
+      byClass[i] = collideTiles(entities[i], [&](int x, int y) {
+        return map.GetTileClass(x, y) == solidClass;
+      });
+    }
+  }
+  const double classTick = seconds(start) / BENCH_TICKS;
+
+  start = SDL_GetPerformanceCounter();
+  for (int tick = 0; tick < BENCH_TICKS; tick++) {
+    for (int i = 0; i < BENCH_ENTITIES; i++) {
+      byBitset[i] = collideTiles(entities[i], [&](int x, int y) {
+        return map.IsSolid(x, y);
+      });
+    }
+  }
+  const double bitsetTick = seconds(start) / BENCH_TICKS;
+
+  start = SDL_GetPerformanceCounter();
+  for (int tick = 0; tick < BENCH_TICKS; tick++) {
+    for (int i = 0; i < BENCH_ENTITIES; i++) {
+      Contact &contact = byMap[i];
+      contact = Contact();
+      map.IsCollidingWith(&entities[i], contact.found, contact.isTouching,
+                          contact.isGrounded);
+    }
+  }
+  const double mapTick = seconds(start) / BENCH_TICKS;
+
+  int failures = 0;
+  int touching = 0;
+  for (int i = 0; i < BENCH_ENTITIES; i++) {
+    touching += byClass[i].isTouching;
+    if (!sameContact(byClass[i], byBitset[i]) ||
+        byClass[i].isGrounded != byBitset[i].isGrounded ||
+        !sameContact(byClass[i], byMap[i])) {
+      failures++;
+    }
+  }
+  if (failures > 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "%d of %d entities got different contacts", failures,
+                 BENCH_ENTITIES);
+  }
+  SDL_Log("%d entities, %d touching the map: per tile from the class grid "
+          "%.3f ms per tick, from the bitset %.3f ms, IsCollidingWith %.3f ms",
+          BENCH_ENTITIES, touching, classTick * 1e3, bitsetTick * 1e3,
+          mapTick * 1e3);
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,348 @@
+#include "local-signaling.hpp"
+#include "net-transport.hpp"
+#include "net_manager.hpp"
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <cstring>
+
+// Soaks a mesh of loopback peers over bad links on a clock stepped by hand,
+// minutes of traffic in a fraction of the time, then checks what arrived
+// against the conditions. Then does the same for NetManager peers that find
+// each other through a LocalSignalingServer, no outside services either way.
+
+#define LOOPBACK_PEERS 8
+#define TICK_SECONDS (1.0 / 60.0)
+#define SOAK_SECONDS 120.0
+#define PAYLOAD_BYTES 64
+#define SOAK_CONDITIONS {60.0f, 20.0f, 0.05f, 512.0f, 250.0f}
+// a link narrower than the traffic, the rest has to be dropped at the queue
+#define CAPPED_CONDITIONS {60.0f, 0.0f, 0.0f, 16.0f, 100.0f}
+#define CAPPED_SECONDS 20.0
+// how far off the configured loss the soak may be
+#define LOSS_TOLERANCE 0.01f
+
+#define RTC_PEERS 3
+#define RTC_MESSAGES 200
+#define RTC_LATENCY_MS 50.0f
+#define RTC_TIMEOUT_MS 15000
+
+// a binary message, who sent it, its number on the link and when
+struct Payload {
+  uint32_t from;
+  uint32_t sequence;
+  double sent;
+};
+
+static std::vector<uint8_t> encode(const Payload &payload) {
+  std::vector<uint8_t> data(PAYLOAD_BYTES, 0);
+  std::memcpy(data.data(), &payload, sizeof(payload));
+  return data;
+}
+
+static Payload decode(const std::vector<uint8_t> &data) {
+  Payload payload = {};
+  if (data.size() >= sizeof(payload)) {
+    std::memcpy(&payload, data.data(), sizeof(payload));
+  }
+  return payload;
+}
+
+struct Link {
+  uint32_t sent = 0;
+  uint32_t received = 0;
+  uint64_t bytes = 0;
+  std::vector<bool> seen;
+};
+
+// a mesh of loopback peers, every peer sends to every other one each tick
+class LoopbackMesh {
+public:
+  LoopbackMesh(const LinkConditions &conditions, double &now)
+      : now(now), network(conditions, 1234, [&now]() { return now; }),
+        links(LOOPBACK_PEERS * LOOPBACK_PEERS) {
+    for (int i = 0; i < LOOPBACK_PEERS; i++) {
+      this->peers.push_back(
+          this->network.CreatePeer("peer" + std::to_string(i)));
+      this->peers[i]->setCallbacks(
+          [this, i](std::string peer) { this->connections[i]++; },
+          [this](std::string peer, std::string message) { this->failures++; },
+          [this, i](std::string peer, const std::vector<uint8_t> &data) {
+            this->receive(i, data);
+          });
+    }
+    for (auto &peer : this->peers) {
+      peer->connect();
+    }
+  }
+
+  // one tick of every peer sending and polling, the clock moves after it
+  void Tick() {
+    for (int from = 0; from < LOOPBACK_PEERS; from++) {
+      for (int to = 0; to < LOOPBACK_PEERS; to++) {
+        if (from != to) {
+          Link &link = this->links[from * LOOPBACK_PEERS + to];
+          this->peers[from]->sendBinaryTo(
+              this->peers[to]->getId(),
+              encode({static_cast<uint32_t>(from), link.sent++, this->now}));
+        }
+      }
+    }
+    for (auto &peer : this->peers) {
+      peer->poll();
+    }
+  }
+
+  // polls without sending until everything on the way arrived
+  void Drain(double seconds) {
+    for (double end = this->now + seconds; this->now < end;
+         this->now += TICK_SECONDS) {
+      for (auto &peer : this->peers) {
+        peer->poll();
+      }
+    }
+  }
+
+  double &now;
+  LoopbackNetwork network;
+  std::vector<std::unique_ptr<LoopbackTransport>> peers;
+  std::vector<Link> links; // by from * LOOPBACK_PEERS + to
+  int connections[LOOPBACK_PEERS] = {};
+  double minDelay = 1e9;
+  double maxDelay = 0.0;
+  int failures = 0;
+
+private:
+  void receive(int to, const std::vector<uint8_t> &data) {
+    const Payload payload = decode(data);
+    if (payload.from >= LOOPBACK_PEERS ||
+        payload.from == static_cast<uint32_t>(to)) {
+      this->failures++;
+      return;
+    }
+    Link &link = this->links[payload.from * LOOPBACK_PEERS + to];
+    if (payload.sequence >= link.sent) {
+      this->failures++;
+      return;
+    }
+    link.seen.resize(link.sent, false);
+    if (link.seen[payload.sequence]) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "peer%d got message %u from peer%u twice", to,
+                   payload.sequence, payload.from);
+      this->failures++;
+    }
+    link.seen[payload.sequence] = true;
+    link.received++;
+    link.bytes += data.size();
+    // seen at the poll, up to a tick after it arrived
+    const double delay = this->now - payload.sent;
+    this->minDelay = std::min(this->minDelay, delay);
+    this->maxDelay = std::max(this->maxDelay, delay);
+  }
+};
+
+// lossy links with jitter, the losses and the delays have to match them
+static int soakLoopback() {
+  const LinkConditions conditions = SOAK_CONDITIONS;
+  double now = 0.0;
+  LoopbackMesh mesh(conditions, now);
+  const Uint64 start = SDL_GetPerformanceCounter();
+  for (; now < SOAK_SECONDS; now += TICK_SECONDS) {
+    mesh.Tick();
+  }
+  mesh.Drain(1.0);
+  const double wall = static_cast<double>(SDL_GetPerformanceCounter() - start) /
+                      SDL_GetPerformanceFrequency();
+
+  int failures = mesh.failures;
+  for (int i = 0; i < LOOPBACK_PEERS; i++) {
+    if (mesh.connections[i] != LOOPBACK_PEERS - 1) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "peer%d connected to %d peers", i, mesh.connections[i]);
+      failures++;
+    }
+  }
+  uint64_t sent = 0, received = 0, bytes = 0;
+  for (const Link &link : mesh.links) {
+    sent += link.sent;
+    received += link.received;
+    bytes += link.bytes;
+  }
+  const LinkStats stats = mesh.network.GetStats();
+  if (stats.sent != sent || stats.sent - stats.dropped != received ||
+      stats.bytes != bytes) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "the link stats don't add up to what was sent and received");
+    failures++;
+  }
+  const float loss = 1.0f - static_cast<float>(received) / sent;
+  if (std::abs(loss - conditions.loss) > LOSS_TOLERANCE) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "lost %.3f instead of %.3f",
+                 loss, conditions.loss);
+    failures++;
+  }
+  const double earliest = (conditions.latencyMs - conditions.jitterMs) / 1000.0;
+  const double latest = (conditions.latencyMs + conditions.jitterMs +
+                         conditions.queueMs) / 1000.0 + TICK_SECONDS;
+  if (mesh.minDelay < earliest || mesh.maxDelay > latest) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "delays of %.1f to %.1fms, outside %.1f to %.1fms",
+                 mesh.minDelay * 1000.0, mesh.maxDelay * 1000.0,
+                 earliest * 1000.0, latest * 1000.0);
+    failures++;
+  }
+
+  SDL_Log("loopback soak: %d peers, %.0fs of traffic in %.2fs, %llu messages "
+          "(%.0f/s), %.3f lost, delays %.1f to %.1fms",
+          LOOPBACK_PEERS, SOAK_SECONDS, wall,
+          static_cast<unsigned long long>(sent), sent / wall, loss,
+          mesh.minDelay * 1000.0, mesh.maxDelay * 1000.0);
+  return failures;
+}
+
+// links narrower than the traffic, what gets through is bounded by the cap
+static int soakCapped() {
+  const LinkConditions conditions = CAPPED_CONDITIONS;
+  double now = 0.0;
+  LoopbackMesh mesh(conditions, now);
+  for (; now < CAPPED_SECONDS; now += TICK_SECONDS) {
+    mesh.Tick();
+  }
+  mesh.Drain(1.0);
+
+  int failures = mesh.failures;
+  // what fits through the link, plus what was queued when it started
+  const double capacity = conditions.bandwidthKbps * 1000.0 / 8.0 *
+                              (CAPPED_SECONDS + conditions.queueMs / 1000.0) +
+                          PAYLOAD_BYTES;
+  uint64_t least = UINT64_MAX, most = 0;
+  for (int from = 0; from < LOOPBACK_PEERS; from++) {
+    for (int to = 0; to < LOOPBACK_PEERS; to++) {
+      if (from != to) {
+        const Link &link = mesh.links[from * LOOPBACK_PEERS + to];
+        least = std::min(least, link.bytes);
+        most = std::max(most, link.bytes);
+      }
+    }
+  }
+  // and the link is kept busy, nearly all of it is used
+  if (most > capacity || least < capacity * 0.9) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "%llu to %llu bytes over links that fit %.0f",
+                 static_cast<unsigned long long>(least),
+                 static_cast<unsigned long long>(most), capacity);
+    failures++;
+  }
+  SDL_Log("capped soak: %llu to %llu of %.0f bytes per link",
+          static_cast<unsigned long long>(least),
+          static_cast<unsigned long long>(most), capacity);
+  return failures;
+}
+
+// NetManager peers in one room of a LocalSignalingServer, behind
+// conditioners on the hand stepped clock. WebRTC runs on its own threads
+// and in real time, only the conditioned delivery follows the clock
+static int soakLocalSignaling() {
+  LocalSignalingServer server;
+  NetSettings settings;
+  settings.signalingUrl = server.getUrl();
+  settings.iceServers.clear(); // host candidates on one machine
+
+  std::atomic<double> now = 0.0;
+  const LinkConditions conditions = {RTC_LATENCY_MS, 0.0f, 0.0f, 0.0f, 0.0f};
+  std::vector<std::unique_ptr<ConditionedTransport>> peers;
+  std::vector<std::vector<std::string>> connected(RTC_PEERS);
+  std::vector<int> received(RTC_PEERS, 0);
+  int failures = 0;
+  for (int i = 0; i < RTC_PEERS; i++) {
+    // the first hosts room 1001, the first one the server hands out
+    auto manager = std::make_unique<NetManager>(
+        i == 0 ? "host" : "join", "1001", nullptr, nullptr, settings);
+    peers.push_back(std::make_unique<ConditionedTransport>(
+        std::move(manager), conditions, i, [&now]() { return now.load(); }));
+    peers[i]->setCallbacks(
+        [&connected, i](std::string peer) { connected[i].push_back(peer); },
+        [&received, &failures, &now, i](std::string peer,
+                                        std::string message) {
+          // not before the latency on the hand stepped clock, the sent
+          // time is rounded to the microsecond
+          const double delay = now.load() - std::stod(message);
+          if (delay < RTC_LATENCY_MS / 1000.0 - 1e-6) {
+            failures++;
+          }
+          received[i]++;
+        },
+        nullptr);
+    peers[i]->connect();
+    // the joins fail until the room is there
+    const Uint32 deadline = SDL_GetTicks() + RTC_TIMEOUT_MS;
+    while (i == 0 && !server.hasRoom("1001") && SDL_GetTicks() < deadline) {
+      SDL_Delay(10);
+    }
+  }
+
+  // the whole mesh, the clock steps so the connections come through
+  const Uint32 deadline = SDL_GetTicks() + RTC_TIMEOUT_MS;
+  const auto meshed = [&connected]() {
+    for (const auto &list : connected) {
+      if (list.size() != RTC_PEERS - 1) {
+        return false;
+      }
+    }
+    return true;
+  };
+  while (!meshed() && SDL_GetTicks() < deadline) {
+    now = now + TICK_SECONDS;
+    for (auto &peer : peers) {
+      peer->poll();
+    }
+    SDL_Delay(1);
+  }
+  if (!meshed()) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "the peers didn't connect through the local signaling");
+    return failures + 1;
+  }
+
+  // the data channels are reliable, everything has to arrive
+  for (int m = 0; m < RTC_MESSAGES; m++) {
+    for (int i = 0; i < RTC_PEERS; i++) {
+      for (const auto &peer : connected[i]) {
+        peers[i]->sendTo(peer, std::to_string(now.load()));
+      }
+    }
+    now = now + TICK_SECONDS;
+    for (auto &peer : peers) {
+      peer->poll();
+    }
+  }
+  const int expected = RTC_MESSAGES * (RTC_PEERS - 1);
+  const auto allReceived = [&received, expected]() {
+    return std::all_of(received.begin(), received.end(),
+                       [expected](int count) { return count == expected; });
+  };
+  while (!allReceived() && SDL_GetTicks() < deadline + RTC_TIMEOUT_MS) {
+    now = now + TICK_SECONDS;
+    for (auto &peer : peers) {
+      peer->poll();
+    }
+    SDL_Delay(1);
+  }
+  for (int i = 0; i < RTC_PEERS; i++) {
+    if (received[i] != expected) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "peer %d got %d of %d messages", i, received[i], expected);
+      failures++;
+    }
+  }
+  SDL_Log("local signaling soak: %d peers, %d messages each", RTC_PEERS,
+          expected);
+  return failures;
+}
+
+int main(int argc, char *argv[]) {
+  int failures = soakLoopback();
+  failures += soakCapped();
+  failures += soakLocalSignaling();
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+#include "plugins/enemy.hpp"
+#include "plugins/physics.hpp"
+#include "plugins/timer.hpp"
+#include <SDL2/SDL.h>
+#include <random>
+
+// 50k enemies patrolling shared routes of the PathTable through
+// EnemyPlugin, every one has to stay on its route. Then the memory of the
+// table against every enemy owning a copy of its route, as Path did before,
+// and enemyUpdate against the same patrol over those per enemy copies.
+
+#define BENCH_ENEMIES 50000
+#define PATROL_ROUTES 64
+#define ROUTE_MIN_POINTS 2
+#define ROUTE_MAX_POINTS 8
+#define ROUTE_SPREAD 400.0f // of a route's points around its first one
+#define PATROL_TICKS 600
+#define BENCH_TICK (1.0f / 60.0f)
+// enemyUpdate's speed, how far past a point an enemy may get in a tick
+#define ENEMY_SPEED 100.0f
+
+static double seconds(Uint64 start) {
+  return static_cast<double>(SDL_GetPerformanceCounter() - start) /
+         static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// the (min, max) bounds of a route's points
+static glm::vec4 routeBounds(const PathTable &paths, PathHandle route) {
+  const auto &r = paths.routes[route];
+  glm::vec2 min = paths.points[r.firstPoint];
+  glm::vec2 max = min;
+  for (uint32_t i = 1; i < r.pointCount; i++) {
+    min = glm::min(min, paths.points[r.firstPoint + i]);
+    max = glm::max(max, paths.points[r.firstPoint + i]);
+  }
+  return glm::vec4(min, max);
+}
+
+// the patrol of enemyUpdate with every enemy owning its route, as Path did
+// before the PathTable
+struct OwnedPath {
+  std::vector<glm::vec2> points;
+  uint32_t targetPointIndex = 0;
+};
+
+static void patrolOwned(int count, Velocity *v, OwnedPath *p, Transform2D *t,
+                        Sprite *s) {
+  for (int i = 0; i < count; i++) {
+    const auto targetPoint = p[i].points[p[i].targetPointIndex];
+    if (glm::distance(t[i].position, targetPoint) < 1.0f) {
+      p[i].targetPointIndex++;
+      if (p[i].targetPointIndex >= p[i].points.size()) {
+        p[i].targetPointIndex = 0;
+        continue;
+      }
+    }
+    const auto direction = glm::normalize(targetPoint - t[i].position);
+    s[i].flipX = direction.x < 0;
+    v[i].value = direction * ENEMY_SPEED;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  std::minstd_rand random(36);
+  std::uniform_int_distribution<int> pointCount(ROUTE_MIN_POINTS,
+                                                ROUTE_MAX_POINTS);
+  std::uniform_real_distribution<float> spread(-ROUTE_SPREAD, ROUTE_SPREAD);
+  PathTable paths;
+  for (int r = 0; r < PATROL_ROUTES; r++) {
+    const glm::vec2 origin(r % 8 * ROUTE_SPREAD * 3, r / 8 * ROUTE_SPREAD * 3);
+    std::vector<glm::vec2> route(pointCount(random), origin);
+    for (size_t i = 1; i < route.size(); i++) {
+      route[i] += glm::vec2(spread(random), spread(random));
+    }
+    paths.AddRoute(route);
+  }
+
+  flecs::world ecs;
+  ecs.set_pipeline(
+      ecs.pipeline().term(flecs::System).term<SimulationPhase>().build());
+  ecs.set<Timers>({});
+  ecs.set<PathTable>(paths);
+  TimerPlugin().addSystems(ecs);
+  PhysicsPlugin().addSystems(ecs);
+  EnemyPlugin().addSystems(ecs);
+  std::vector<flecs::entity> enemies;
+  for (int i = 0; i < BENCH_ENEMIES; i++) {
+    const PathHandle route = i % PATROL_ROUTES;
+    const glm::vec2 start = paths.points[paths.routes[route].firstPoint];
+    enemies.push_back(ecs.entity()
+                          .set<Transform2D>(Transform2D().WithPosition(start))
+                          .set<Sprite>({nullptr, false})
+                          .set<Velocity>({glm::vec2(0, 0)})
+                          .set<Enemy>(Enemy())
+                          .set<Path>(Path(route)));
+  }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int tick = 0; tick < PATROL_TICKS; tick++) {
+    ecs.progress(BENCH_TICK);
+  }
+  const double perTick = seconds(start) / PATROL_TICKS;
+
+  int strays = 0;
+  const float slack = ENEMY_SPEED * BENCH_TICK + 1.0f;
+  for (const auto &e : enemies) {
+    const glm::vec2 position = e.get<Transform2D>()->position;
+    const glm::vec4 bounds = routeBounds(paths, e.get<Path>()->route);
+    strays += position.x < bounds.x - slack || position.y < bounds.y - slack ||
+              position.x > bounds.z + slack || position.y > bounds.w + slack;
+  }
+  if (strays > 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "%d of %d enemies left their route", strays, BENCH_ENEMIES);
+  }
+  SDL_Log("%d enemies on %d routes: %.3f ms per tick", BENCH_ENEMIES,
+          PATROL_ROUTES, perTick * 1e3);
+
+  // the same patrol outside flecs, over the table and over per enemy copies
+  std::vector<Velocity> v(BENCH_ENEMIES, {glm::vec2(0, 0)});
+  std::vector<Transform2D> t(BENCH_ENEMIES);
+  std::vector<Sprite> s(BENCH_ENEMIES, {nullptr, false});
+  std::vector<Path> shared(BENCH_ENEMIES);
+  std::vector<OwnedPath> owned(BENCH_ENEMIES);
+  size_t ownedBytes = 0;
+  for (int i = 0; i < BENCH_ENEMIES; i++) {
+    const auto &route = paths.routes[i % PATROL_ROUTES];
+    const glm::vec2 *first = paths.points.data() + route.firstPoint;
+    t[i].position = *first;
+    shared[i] = Path(i % PATROL_ROUTES);
+    owned[i].points.assign(first, first + route.pointCount);
+    ownedBytes += sizeof(OwnedPath) + route.pointCount * sizeof(glm::vec2);
+  }
+  const size_t sharedBytes = BENCH_ENEMIES * sizeof(Path) +
+                             paths.points.size() * sizeof(glm::vec2) +
+                             paths.routes.size() * sizeof(PathTable::Route);
+
+  const auto patrol = [&](auto &&update) {
+    const Uint64 start = SDL_GetPerformanceCounter();
+    for (int tick = 0; tick < PATROL_TICKS; tick++) {
+      update();
+      for (int i = 0; i < BENCH_ENEMIES; i++) {
+        t[i].position += v[i].value * BENCH_TICK;
+      }
+    }
+    return seconds(start) / PATROL_TICKS;
+  };
+  const double sharedTick = patrol([&]() {
+    enemyUpdate(paths, BENCH_ENEMIES, v.data(), shared.data(), t.data(),
+                s.data());
+  });
+  for (int i = 0; i < BENCH_ENEMIES; i++) {
+    t[i].position = owned[i].points[0];
+  }
+  const double ownedTick = patrol([&]() {
+    patrolOwned(BENCH_ENEMIES, v.data(), owned.data(), t.data(), s.data());
+  });
+  SDL_Log("path storage: %.2f MB in the table, %.2f MB owned per enemy "
+          "before allocator overhead",
+          sharedBytes / 1e6, ownedBytes / 1e6);
+  SDL_Log("patrol update: %.3f ms per tick over the table, %.3f ms over the "
+          "owned copies",
+          sharedTick * 1e3, ownedTick * 1e3);
+  return strays == 0 ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include "plugins/physics.hpp"
+#include "plugins/pool.hpp"
+#include "plugins/timer.hpp"
+#include "plugins/transform.hpp"
+#include <SDL2/SDL.h>
+#include <new>
+
+// Fires 10k projectiles a second that expire after a second, like the
+// player's balls, once handed out by the EntityPool and once created and
+// destroyed. Reports the time of a tick, the worst tick and the allocations
+// of flecs and the standard containers per tick. Both have to keep the same
+// number of projectiles alive, and the pool can't grow past them.
+
+#define SPAWNS_PER_TICK 167 // 10k a second at 60 ticks a second
+#define PROJECTILE_LIFETIME 1.0f
+#define WARMUP_TICKS 120
+#define BENCH_TICKS 600
+#define BENCH_TICK (1.0f / 60.0f)
+
+static size_t allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  if (void *p = malloc(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+
+void operator delete(void *p, size_t size) noexcept { free(p); }
+
+static ecs_os_api_malloc_t flecsMalloc;
+static ecs_os_api_calloc_t flecsCalloc;
+static ecs_os_api_realloc_t flecsRealloc;
+
+// counts what flecs allocates through its os api
+static void countFlecsAllocations() {
+  ecs_os_set_api_defaults();
+  ecs_os_api_t api = ecs_os_api;
+  flecsMalloc = api.malloc_;
+  flecsCalloc = api.calloc_;
+  flecsRealloc = api.realloc_;
+  api.malloc_ = [](ecs_size_t size) {
+    allocations++;
+    return flecsMalloc(size);
+  };
+  api.calloc_ = [](ecs_size_t size) {
+    allocations++;
+    return flecsCalloc(size);
+  };
+  api.realloc_ = [](void *p, ecs_size_t size) {
+    allocations++;
+    return flecsRealloc(p, size);
+  };
+  ecs_os_set_api(&api);
+}
+
+static double seconds(Uint64 start) {
+  return static_cast<double>(SDL_GetPerformanceCounter() - start) /
+         static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// the simulation systems a projectile goes through, and a gun firing them.
+// returns the projectile prefab
+static flecs::entity buildWorld(flecs::world &ecs, bool pooled) {
+  ecs.set_pipeline(
+      ecs.pipeline().term(flecs::System).term<SimulationPhase>().build());
+  ecs.set<Gravity>({.value = 980.0f});
+  ecs.set<Timers>({});
+  ecs.set<EntityPool>({});
+  TimerPlugin().addSystems(ecs);
+  PoolPlugin().addSystems(ecs);
+
+  const auto prefab =
+      ecs.prefab("Ball")
+          .set<Transform2D>(Transform2D(glm::vec2(0, 0), glm::vec2(1, 1), 0))
+          .set<Velocity>({glm::vec2(0, 0)})
+          .set<Groundable>({false})
+          .set<CollisionVolume>({glm::vec4(0, 0, 16, 16)});
+  ecs.system<EntityPool>().kind<SimulationPhase>().iter(
+      [prefab, pooled](flecs::iter it, EntityPool *pool) {
+        const auto world = it.world();
+        for (int i = 0; i < SPAWNS_PER_TICK; i++) {
+          const auto direction =
+              glm::vec2(i % 16 - 8.0f, -static_cast<float>(i % 7));
+          const auto projectile = pooled ? pool->Acquire(world, prefab)
+                                         : world.entity().is_a(prefab);
+          projectile.set<Transform2D>(Transform2D())
+              .set<Velocity>({direction * 100.0f})
+              .set<Groundable>({false})
+              .set<LiveFor>({PROJECTILE_LIFETIME});
+        }
+      });
+
+  PhysicsPlugin().addSystems(ecs);
+  Transform2DPlugin().addSystems(ecs);
+  return prefab;
+}
+
+int main(int argc, char *argv[]) {
+  countFlecsAllocations();
+  const int expectedLive =
+      SPAWNS_PER_TICK * static_cast<int>(PROJECTILE_LIFETIME / BENCH_TICK);
+  int failures = 0;
+  for (const bool pooled : {true, false}) {
+    const char *name = pooled ? "pooled" : "create/destroy";
+    flecs::world ecs;
+    const auto prefab = buildWorld(ecs, pooled);
+    for (int tick = 0; tick < WARMUP_TICKS; tick++) {
+      ecs.progress(BENCH_TICK);
+    }
+
+    double total = 0.0, worst = 0.0;
+    allocations = 0;
+    for (int tick = 0; tick < BENCH_TICKS; tick++) {
+      const Uint64 start = SDL_GetPerformanceCounter();
+      ecs.progress(BENCH_TICK);
+      const double elapsed = seconds(start);
+      total += elapsed;
+      worst = glm::max(worst, elapsed);
+    }
+    const double perTick = static_cast<double>(allocations) / BENCH_TICKS;
+
+    // disabled instances waiting in the pool aren't matched by the query
+    int live = 0;
+    ecs.query<const LiveFor>().each([&live](const LiveFor &) { live++; });
+    const int instances = ecs.count(flecs::IsA, prefab);
+    if (glm::abs(live - expectedLive) > 2 * SPAWNS_PER_TICK ||
+        instances > live + 2 * SPAWNS_PER_TICK) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "%s: %d projectiles alive in %d instances, expected %d",
+                   name, live, instances, expectedLive);
+      failures++;
+    }
+    SDL_Log("%s, %d alive in %d instances: %.3f ms per tick, worst %.3f ms, "
+            "%.1f allocations per tick",
+            name, live, instances, total / BENCH_TICKS * 1e3, worst * 1e3,
+            perTick);
+  }
+  return failures == 0 ? 0 : 1;
+}
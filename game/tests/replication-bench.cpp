@@ -0,0 +1,165 @@
+#include "components.hpp"
+#include "net-transport.hpp"
+#include "plugins/physics.hpp"
+#include "replication.hpp"
+#include <SDL2/SDL.h>
+#include <random>
+
+// Replicates a crowd from a server to clients over a LoopbackNetwork with
+// lossy links, on a clock stepped by hand so it runs as fast as it encodes.
+// Reports the bandwidth per entity and the encode and decode throughput,
+// then checks the clients ended up with the server's state.
+
+#define BENCH_ENTITIES 2000
+#define BENCH_CLIENTS 4
+#define BENCH_TICKS 3600
+#define TICK_SECONDS (1.0 / 60.0)
+// of the entities, how many move and how often one is replaced
+#define MOVING_EVERY 4
+#define RESPAWN_TICKS 30
+#define BENCH_CONDITIONS {50.0f, 10.0f, 0.05f, 0.0f, 0.0f}
+// ticks without loss or movement at the end, for the clients to catch up
+#define SETTLE_TICKS 60
+
+struct Client {
+  std::unique_ptr<LoopbackTransport> transport;
+  ReplicationClient replication;
+  flecs::world world;
+  int rejected = 0;
+};
+
+static flecs::entity spawn(flecs::world &world, ReplicationServer &server,
+                           std::minstd_rand &random) {
+  std::uniform_real_distribution<float> position(0.0f, 4096.0f);
+  std::uniform_real_distribution<float> speed(-200.0f, 200.0f);
+  auto e = world.entity()
+               .set<Transform2D>(Transform2D().WithPosition(
+                   glm::vec2(position(random), position(random))))
+               .set<Health>({100.0f});
+  if (random() % MOVING_EVERY == 0) {
+    e.set<Velocity>({glm::vec2(speed(random), speed(random))});
+  }
+  server.Track(e);
+  return e;
+}
+
+int main(int argc, char *argv[]) {
+  double now = 0.0;
+  LoopbackNetwork network(BENCH_CONDITIONS, 1, [&now]() { return now; });
+  std::minstd_rand random(1);
+
+  flecs::world world;
+  ReplicationServer server;
+  std::vector<flecs::entity> crowd;
+  for (int i = 0; i < BENCH_ENTITIES; i++) {
+    crowd.push_back(spawn(world, server, random));
+  }
+
+  auto serverTransport = network.CreatePeer("server");
+  std::vector<std::string> peers;
+  serverTransport->setCallbacks(
+      [&peers](std::string peer) { peers.push_back(peer); }, nullptr,
+      [&server](std::string peer, const std::vector<uint8_t> &data) {
+        BitReader in(data.data(), data.size());
+        if (in.Read(8) == NET_PACKET_ACK) {
+          server.ReadAck(peer, in);
+        }
+      });
+  serverTransport->connect();
+
+  std::vector<std::unique_ptr<Client>> clients;
+  for (int i = 0; i < BENCH_CLIENTS; i++) {
+    auto client = std::make_unique<Client>();
+    client->transport = network.CreatePeer("client" + std::to_string(i));
+    Client *c = client.get();
+    c->transport->setCallbacks(
+        nullptr, nullptr,
+        [c](std::string peer, const std::vector<uint8_t> &data) {
+          BitReader in(data.data(), data.size());
+          if (in.Read(8) != NET_PACKET_SNAPSHOT) {
+            return;
+          }
+          // older or without its baseline after a loss, the next one does
+          if (!c->replication.Decode(in)) {
+            c->rejected++;
+            return;
+          }
+          c->replication.Apply(c->world);
+          BitWriter ack;
+          c->replication.EncodeAck(ack);
+          c->transport->sendBinaryTo(peer, ack.GetData());
+        });
+    c->transport->connect();
+    clients.push_back(std::move(client));
+  }
+
+  BitWriter out;
+  const auto tick = [&](uint32_t t, bool moving) {
+    if (moving) {
+      world.filter<Transform2D, const Velocity>().each(
+          [](Transform2D &transform, const Velocity &v) {
+            transform.position += v.value * static_cast<float>(TICK_SECONDS);
+          });
+      if (t % RESPAWN_TICKS == 0) {
+        const size_t i = random() % crowd.size();
+        crowd[i].destruct();
+        crowd[i] = spawn(world, server, random);
+        crowd[(i + 1) % crowd.size()].get_mut<Health>()->value -= 10.0f;
+      }
+    }
+    server.Capture(world, t);
+    for (const auto &peer : peers) {
+      out.Clear();
+      if (server.Encode(peer, out)) {
+        serverTransport->sendBinaryTo(peer, out.GetData());
+      }
+    }
+    now += TICK_SECONDS;
+    serverTransport->poll();
+    for (auto &client : clients) {
+      client->transport->poll();
+    }
+  };
+
+  uint32_t t = 1;
+  for (; t <= BENCH_TICKS; t++) {
+    tick(t, true);
+  }
+  network.SetConditions({});
+  for (const uint32_t end = t + SETTLE_TICKS; t < end; t++) {
+    tick(t, false);
+  }
+
+  server.GetStats().Report("replication encode");
+  int failures = 0;
+  std::vector<NetEntityState> expected, replicated;
+  CaptureNetState(world, expected);
+  for (size_t i = 0; i < clients.size(); i++) {
+    const std::string name = "replication decode, client" + std::to_string(i);
+    clients[i]->replication.GetStats().Report(name.c_str());
+    CaptureNetState(clients[i]->world, replicated);
+    if (replicated.size() != expected.size() ||
+        !std::equal(expected.begin(), expected.end(), replicated.begin(),
+                    [](const NetEntityState &a, const NetEntityState &b) {
+                      return a.netId == b.netId &&
+                             a.components == b.components &&
+                             a.position == b.position &&
+                             a.velocity == b.velocity && a.health == b.health;
+                    })) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "client%zu has %zu entities that don't match the "
+                   "server's %zu",
+                   i, replicated.size(), expected.size());
+      failures++;
+    }
+  }
+  const LinkStats stats = network.GetStats();
+  SDL_Log("replication over loopback: %d entities to %d clients, %.1f bytes "
+          "per entity per tick on the wire, %llu of %llu packets lost",
+          BENCH_ENTITIES, BENCH_CLIENTS,
+          static_cast<double>(stats.bytes) /
+              (static_cast<double>(t - 1) * BENCH_ENTITIES * BENCH_CLIENTS),
+          static_cast<unsigned long long>(stats.dropped),
+          static_cast<unsigned long long>(stats.sent));
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+#include "plugins/map.hpp"
+#include "plugins/physics.hpp"
+#include "plugins/timer.hpp"
+#include "plugins/timestep.hpp"
+#include "plugins/transform.hpp"
+#include "replay.hpp"
+#include "rollback-world.hpp"
+#include "tilemap.hpp"
+#include <SDL2/SDL.h>
+#include <deque>
+#include <memory>
+
+// Two peers run the bodies of levels/rooms.tmx through RollbackWorld, each
+// driving half of them with scripted inputs the other gets some ticks late,
+// while a camera streams the rooms in and out between the ticks. Every
+// rollback depth has to end on the state of the peers that got the inputs
+// right away, and a peer that moves its bodies a bit differently has to
+// trip the checksums. Reports the re-simulation cost per depth.
+
+#define TEST_BODIES 2000
+#define TEST_TICKS 1200
+#define BODY_SIZE 12.0f
+#define DRIVE_SPEED 120.0f
+#define INPUT_HOLD_TICKS 8 // the scripted inputs change this often
+#define CAMERA_STEP 6.0f   // px per tick, back and forth across the rooms
+#define CHECKSUM_INTERVAL 10
+
+// moved by a player's inputs
+struct Driven {
+  int player;
+};
+
+struct Peer {
+  flecs::world ecs;
+  std::shared_ptr<Tilemap> map;
+  std::unique_ptr<RollbackWorld> world;
+  std::unique_ptr<RollbackSession> session;
+  uint32_t streamEpochs[ROLLBACK_HISTORY] = {};
+};
+
+// an input sent from one peer to the other, delivered on frame
+struct Message {
+  int frame;
+  int player;
+  uint32_t tick;
+  RollbackInput input;
+};
+
+static double counterToMs(uint64_t counter) {
+  return counter * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+// left, right and jump, held for a few ticks at a time
+static RollbackInput scriptedInput(int player, uint32_t tick) {
+  uint32_t x = (tick / INPUT_HOLD_TICKS) * 2654435761u + player * 40503u;
+  x ^= x >> 15;
+  return x % 8;
+}
+
+static void buildPeer(Peer &peer, float driveSpeed) {
+  flecs::world &ecs = peer.ecs;
+  peer.map = std::make_shared<Tilemap>(TEST_LEVEL_DIR "/rooms.level");
+  ecs.set<FixedTimestep>(
+      {.settings = {DEFAULT_TICK_RATE, DEFAULT_MAX_CATCH_UP_STEPS, 1}});
+  ecs.set<Gravity>({.value = 980.0f});
+  ecs.set<Timers>({});
+  ecs.set<Map>({peer.map});
+  ecs.set<PathTable>({});
+  // the level's enemies need a renderer, none of them spawn
+  ecs.set<SpawnState>(
+      {std::vector<bool>(peer.map->GetSpawns().size(), true)});
+  ecs.set<StreamedChunks>({});
+  TimestepPlugin().addSystems(ecs);
+  TimerPlugin().addSystems(ecs);
+  ecs.system<Velocity, const Driven, const RollbackInputs>()
+      .kind<SimulationPhase>()
+      .term_at(3)
+      .singleton()
+      .each([driveSpeed](Velocity &v, const Driven &d,
+                         const RollbackInputs &inputs) {
+        const uint32_t down = inputs.players[d.player].actionsDown;
+        v.value.x = ((down & 1) ? driveSpeed : 0.0f) -
+                    ((down & 2) ? driveSpeed : 0.0f);
+        if (down & 4) {
+          v.value.y = -driveSpeed;
+        }
+      });
+  PhysicsPlugin().addSystems(ecs);
+  MapPlugin().addSystems(ecs);
+  Transform2DPlugin().addSystems(ecs);
+
+  const SDL_Rect bounds = peer.map->GetBounds();
+  for (int i = 0; i < TEST_BODIES; i++) {
+    const glm::vec2 position((i * 7919) % (bounds.w - 64) + 32,
+                             (i * 104729) % (bounds.h - 64) + 32);
+    ecs.entity()
+        .set<Transform2D>(Transform2D().WithPosition(position))
+        .set<Velocity>({glm::vec2(0, 0)})
+        .set<Groundable>({false, false})
+        .set<CollisionVolume>({glm::vec4(0, 0, BODY_SIZE, BODY_SIZE)})
+        .set<Driven>({i % 2});
+  }
+
+  peer.world = std::make_unique<RollbackWorld>(ecs);
+  peer.world->Track<Timers>();
+  peer.world->Track<SpawnState>();
+  peer.world->TrackBetweenTicks<StreamedChunks>();
+}
+
+// the peers' final state hashes, with the inputs lateTicks late. the
+// checksums are compared on the way, desynced is set if they differed
+static void run(int lateTicks, bool perturbed, uint64_t hashes[2],
+                bool &desynced, RollbackStats &stats) {
+  Peer peers[2];
+  const RollbackSettings settings[2] = {
+      {2, 0, lateTicks + 1, 0.0f, CHECKSUM_INTERVAL},
+      {2, 1, lateTicks + 1, 0.0f, CHECKSUM_INTERVAL}};
+  for (int p = 0; p < 2; p++) {
+    buildPeer(peers[p],
+              perturbed && p == 1 ? DRIVE_SPEED + 1.0f : DRIVE_SPEED);
+    peers[p].session =
+        std::make_unique<RollbackSession>(*peers[p].world, settings[p]);
+  }
+
+  std::deque<Message> inFlight[2]; // to each peer
+  const auto deliver = [&](int frame) {
+    for (int p = 0; p < 2; p++) {
+      while (!inFlight[p].empty() && inFlight[p].front().frame <= frame) {
+        const Message &m = inFlight[p].front();
+        peers[p].session->AddRemoteInput(m.player, m.tick, m.input);
+        inFlight[p].pop_front();
+      }
+    }
+  };
+  const auto exchangeChecksums = [&]() {
+    for (int p = 0; p < 2; p++) {
+      uint32_t tick;
+      uint64_t checksum;
+      while (peers[p].session->PopChecksum(tick, checksum)) {
+        peers[1 - p].session->AddRemoteChecksum(p, tick, checksum);
+      }
+    }
+  };
+
+  const SDL_Rect bounds = peers[0].map->GetBounds();
+  for (int frame = 0; frame < TEST_TICKS; frame++) {
+    const float travel = static_cast<float>(
+        static_cast<int>(frame * CAMERA_STEP) % (2 * bounds.w));
+    const glm::vec2 camera(travel < bounds.w ? travel : 2 * bounds.w - travel,
+                           bounds.h / 2);
+    for (int p = 0; p < 2; p++) {
+      Peer &peer = peers[p];
+      streamMap(*peer.map, *peer.ecs.get_mut<StreamedChunks>(), camera);
+      // as Game::stepRollback, the chunks of the oldest tick that can still
+      // be re-simulated stay pinned
+      const uint32_t tick = peer.session->GetTick();
+      peer.streamEpochs[tick % ROLLBACK_HISTORY] = peer.map->GetStreamEpoch();
+      const uint32_t oldest =
+          tick >= ROLLBACK_HISTORY - 1 ? tick - (ROLLBACK_HISTORY - 1) : 0;
+      peer.map->PinEpoch(peer.streamEpochs[oldest % ROLLBACK_HISTORY]);
+
+      const RollbackInput input = scriptedInput(p, tick);
+      peer.session->AddLocalInput(input);
+      inFlight[1 - p].push_back({frame + lateTicks, p, tick, input});
+    }
+    deliver(frame);
+    for (int p = 0; p < 2; p++) {
+      if (!peers[p].session->AdvanceTick()) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "late %d: peer %d stalled at tick %u", lateTicks, p,
+                     peers[p].session->GetTick());
+      }
+    }
+    exchangeChecksums();
+  }
+
+  // the last inputs arrive, the peers correct and settle their checksums
+  deliver(INT32_MAX);
+  for (int p = 0; p < 2; p++) {
+    peers[p].session->Rollback();
+  }
+  exchangeChecksums();
+
+  desynced = false;
+  for (int p = 0; p < 2; p++) {
+    hashes[p] = HashWorldState(peers[p].ecs);
+    desynced |= peers[p].session->IsDesynced();
+  }
+  stats = peers[0].session->GetStats();
+}
+
+int main(int argc, char *argv[]) {
+  Tilemap::SetDeterministicStreaming(true);
+  int failures = 0;
+
+  // no rollbacks, every input is in before its tick
+  uint64_t expected[2];
+  bool desynced;
+  RollbackStats stats;
+  run(0, false, expected, desynced, stats);
+  if (expected[0] != expected[1] || desynced || stats.rollbacks != 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "the peers differ without late inputs");
+    return 1;
+  }
+
+  for (const int lateTicks : {1, 4, 8, ROLLBACK_HISTORY - 2}) {
+    uint64_t hashes[2];
+    run(lateTicks, false, hashes, desynced, stats);
+    if (hashes[0] != expected[0] || hashes[1] != expected[0] || desynced) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "late %d: ended on %016llx and %016llx instead of %016llx"
+                   "%s",
+                   lateTicks, static_cast<unsigned long long>(hashes[0]),
+                   static_cast<unsigned long long>(hashes[1]),
+                   static_cast<unsigned long long>(expected[0]),
+                   desynced ? ", desynced" : "");
+      failures++;
+    }
+    SDL_Log("late %2d ticks: %llu rollbacks re-simulating %.1f ticks each, "
+            "%.3f ms mean, %.3f ms max, %llu checksums compared",
+            lateTicks, static_cast<unsigned long long>(stats.rollbacks),
+            stats.rollbacks > 0 ? static_cast<double>(stats.resimulatedTicks) /
+                                      stats.rollbacks
+                                : 0.0,
+            stats.rollbacks > 0
+                ? counterToMs(stats.resimulateCounter) / stats.rollbacks
+                : 0.0,
+            counterToMs(stats.maxResimulateCounter),
+            static_cast<unsigned long long>(stats.checksumsCompared));
+  }
+
+  // the second peer's bodies are a bit faster, the checksums have to catch it
+  uint64_t hashes[2];
+  run(ROLLBACK_HISTORY - 2, true, hashes, desynced, stats);
+  if (!desynced) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "a perturbed peer wasn't caught by the checksums");
+    failures++;
+  }
+  return failures == 0 ? 0 : 1;
+}
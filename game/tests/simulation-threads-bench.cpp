@@ -0,0 +1,116 @@
+#include "plugins/map.hpp"
+#include "plugins/physics.hpp"
+#include "plugins/timer.hpp"
+#include "plugins/timestep.hpp"
+#include "plugins/transform.hpp"
+#include "replay.hpp"
+#include "tilemap.hpp"
+#include <SDL2/SDL.h>
+#include <random>
+#include <thread>
+
+// Runs the simulation pipeline of 100k falling and sliding bodies on the
+// walls of levels/platforms.tmx with 1 worker thread and more. Reports the
+// time of a tick for each count, and checks every count ends on the same
+// world state hash.
+
+#define BENCH_ENTITIES 100000
+#define WARMUP_TICKS 10
+#define BENCH_TICKS 120
+#define BODY_SIZE 12.0f
+
+static double seconds(Uint64 start) {
+  return static_cast<double>(SDL_GetPerformanceCounter() - start) /
+         static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// the simulation systems of a level that don't draw or read input
+static void buildWorld(flecs::world &ecs, std::shared_ptr<Tilemap> map,
+                       int threads) {
+  ecs.set<FixedTimestep>(
+      {.settings = {DEFAULT_TICK_RATE, DEFAULT_MAX_CATCH_UP_STEPS, threads}});
+  ecs.set<Gravity>({.value = 980.0f});
+  ecs.set<Timers>({});
+  ecs.set<Map>({map});
+  ecs.set<PathTable>({});
+  ecs.set<SpawnState>({std::vector<bool>(map->GetSpawns().size())});
+  ecs.set<StreamedChunks>({});
+  TimestepPlugin().addSystems(ecs);
+  TimerPlugin().addSystems(ecs);
+  PhysicsPlugin().addSystems(ecs);
+  MapPlugin().addSystems(ecs);
+  Transform2DPlugin().addSystems(ecs);
+
+  const SDL_Rect bounds = map->GetBounds();
+  std::minstd_rand random(34);
+  std::uniform_real_distribution<float> x(0.0f, bounds.w - BODY_SIZE);
+  std::uniform_real_distribution<float> y(0.0f, bounds.h - BODY_SIZE);
+  std::uniform_real_distribution<float> speed(-300.0f, 300.0f);
+  for (int i = 0; i < BENCH_ENTITIES; i++) {
+    ecs.entity()
+        .set<Transform2D>(
+            Transform2D().WithPosition(glm::vec2(x(random), y(random))))
+        .set<Velocity>({glm::vec2(speed(random), speed(random))})
+        .set<Groundable>({false, false})
+        .set<CollisionVolume>({glm::vec4(0, 0, BODY_SIZE, BODY_SIZE)});
+  }
+  ecs.set_threads(threads);
+}
+
+int main(int argc, char *argv[]) {
+  Tilemap::SetDeterministicStreaming(true);
+  auto map = std::make_shared<Tilemap>(TEST_LEVEL_DIR "/platforms.level");
+  const SDL_Rect bounds = map->GetBounds();
+  if (bounds.w == 0) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "platforms.level didn't load");
+    return 1;
+  }
+  // the whole map is in the streaming radius of its center
+  std::vector<uint32_t> loaded, unloaded;
+  map->Stream(glm::vec2(bounds.w / 2, bounds.h / 2), loaded, unloaded);
+
+  const int cores =
+      glm::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+  std::vector<int> counts = {1};
+  for (int threads = 2; threads < cores; threads *= 2) {
+    counts.push_back(threads);
+  }
+  if (cores > 1) {
+    counts.push_back(cores);
+  }
+
+  int failures = 0;
+  uint64_t expected = 0;
+  double single = 0.0;
+  for (const int threads : counts) {
+    flecs::world ecs;
+    buildWorld(ecs, map, threads);
+    const float tick = 1.0f / DEFAULT_TICK_RATE;
+    ecs.set_pipeline(ecs.get<FixedTimestep>()->simulation);
+    for (int i = 0; i < WARMUP_TICKS; i++) {
+      ecs.progress(tick);
+    }
+    const Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < BENCH_TICKS; i++) {
+      ecs.progress(tick);
+    }
+    const double perTick = seconds(start) / BENCH_TICKS;
+    if (threads == 1) {
+      single = perTick;
+    }
+
+    const uint64_t hash = HashWorldState(ecs);
+    if (threads == 1) {
+      expected = hash;
+    } else if (hash != expected) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "%d threads ended on state %016llx instead of %016llx",
+                   threads, static_cast<unsigned long long>(hash),
+                   static_cast<unsigned long long>(expected));
+      failures++;
+    }
+    SDL_Log("%d entities on %2d threads: %.3f ms per tick, %.2fx",
+            BENCH_ENTITIES, threads, perTick * 1e3, single / perTick);
+  }
+  return failures == 0 ? 0 : 1;
+}
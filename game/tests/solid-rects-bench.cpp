@@ -0,0 +1,126 @@
+#include "tilemap.hpp"
+#include <SDL2/SDL.h>
+#include <random>
+
+// Collides entities of a few sizes with levels/platforms.tmx, a dense map of
+// floors, stairs and platforms. Times testing the overlapped solid tiles one
+// at a time against IsCollidingWith testing the merged solid rects. Both
+// have to find the same contacts.
+
+#define BENCH_ENTITIES 10000
+#define BENCH_TICKS 20
+#define TILE_SIZE 16 // of levels/platforms.tmx
+#define MAP_TILES 128
+
+struct Contact {
+  SDL_Rect found = {0, 0, 0, 0};
+  bool isTouching = false;
+  bool isGrounded = false;
+};
+
+static double seconds(Uint64 start) {
+  return static_cast<double>(SDL_GetPerformanceCounter() - start) /
+         static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// one solid tile at a time, the padding included. returns the solid tiles
+// it tested
+static int collideTiles(const Tilemap &map, const SDL_Rect &other,
+                        Contact &contact) {
+  int tested = 0;
+  const int startX = glm::max((other.x - 1) / TILE_SIZE, 0);
+  const int startY = glm::max((other.y - 1) / TILE_SIZE, 0);
+  const int endX = glm::min((other.x + other.w + 1) / TILE_SIZE, MAP_TILES - 1);
+  const int endY = glm::min((other.y + other.h + 1) / TILE_SIZE, MAP_TILES - 1);
+  for (int y = startY; y <= endY; y++) {
+    for (int x = startX; x <= endX; x++) {
+      if (!map.IsSolid(x, y)) {
+        continue;
+      }
+      tested++;
+      const SDL_Rect tileRect = {x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE,
+                                 TILE_SIZE};
+      if (SDL_HasIntersection(&other, &tileRect)) {
+        if (contact.found.w == 0) {
+          contact.found = tileRect;
+        } else {
+          SDL_UnionRect(&contact.found, &tileRect, &contact.found);
+        }
+      }
+      const SDL_Rect paddedTileRect = {tileRect.x - 1, tileRect.y - 2,
+                                       tileRect.w + 2, tileRect.h + 3};
+      contact.isTouching |= SDL_HasIntersection(&other, &paddedTileRect);
+      const SDL_Rect aboveTileRect = {tileRect.x + 3, tileRect.y - 1,
+                                      tileRect.w - 7, 1};
+      contact.isGrounded |= SDL_HasIntersection(&other, &aboveTileRect);
+    }
+  }
+  return tested;
+}
+
+int main(int argc, char *argv[]) {
+  Tilemap::SetDeterministicStreaming(true);
+  Tilemap map(TEST_LEVEL_DIR "/platforms.level");
+  const SDL_Rect bounds = map.GetBounds();
+  if (bounds.w != MAP_TILES * TILE_SIZE) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "platforms.level didn't load");
+    return 1;
+  }
+  // the whole map is in the streaming radius of its center
+  std::vector<uint32_t> loaded, unloaded;
+  map.Stream(glm::vec2(bounds.w / 2, bounds.h / 2), loaded, unloaded);
+
+  std::minstd_rand random(31);
+  int failures = 0;
+  // projectiles, players and the bosses
+  for (const glm::ivec2 size : {glm::ivec2(8, 24), glm::ivec2(32, 64),
+                                glm::ivec2(96, 192)}) {
+    std::uniform_int_distribution<int> side(size.x, size.y);
+    std::uniform_int_distribution<int> position(0, bounds.w - size.y);
+    std::vector<SDL_Rect> entities(BENCH_ENTITIES);
+    for (auto &e : entities) {
+      e = {position(random), position(random), side(random), side(random)};
+    }
+
+    std::vector<Contact> byTile(BENCH_ENTITIES), byRect(BENCH_ENTITIES);
+    long tested = 0;
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int tick = 0; tick < BENCH_TICKS; tick++) {
+      tested = 0;
+      for (int i = 0; i < BENCH_ENTITIES; i++) {
+        byTile[i] = Contact();
+        tested += collideTiles(map, entities[i], byTile[i]);
+      }
+    }
+    const double tileTick = seconds(start) / BENCH_TICKS;
+
+    start = SDL_GetPerformanceCounter();
+    for (int tick = 0; tick < BENCH_TICKS; tick++) {
+      for (int i = 0; i < BENCH_ENTITIES; i++) {
+        Contact &contact = byRect[i];
+        contact = Contact();
+        map.IsCollidingWith(&entities[i], contact.found, contact.isTouching,
+                            contact.isGrounded);
+      }
+    }
+    const double rectTick = seconds(start) / BENCH_TICKS;
+
+    // grounded isn't compared, the merged rects are only inset at their ends
+    int different = 0;
+    for (int i = 0; i < BENCH_ENTITIES; i++) {
+      different += !SDL_RectEquals(&byTile[i].found, &byRect[i].found) ||
+                   byTile[i].isTouching != byRect[i].isTouching;
+    }
+    if (different > 0) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "%d to %d px: %d of %d entities got different contacts",
+                   size.x, size.y, different, BENCH_ENTITIES);
+      failures++;
+    }
+    SDL_Log("%3d to %3d px entities, %.1f solid tiles each: per tile %.3f ms "
+            "per tick, merged rects %.3f ms, %.1fx",
+            size.x, size.y, static_cast<double>(tested) / BENCH_ENTITIES,
+            tileTick * 1e3, rectTick * 1e3, tileTick / rectTick);
+  }
+  return failures == 0 ? 0 : 1;
+}
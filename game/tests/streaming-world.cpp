@@ -0,0 +1,132 @@
+#include "tilemap.hpp"
+#include <SDL2/SDL.h>
+#include <unordered_set>
+#ifdef __linux__
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+// Walks a camera corner to corner across a generated 100k x 100k tile world,
+// see scripts/level_cooker.py --generate. The chunks around the camera have
+// to be resident with the right tiles and spawns the whole way, while the
+// resident chunks and the memory stay under a fixed ceiling.
+
+#define WORLD_TILES 100000
+#define TILE_SIZE 16 // GENERATED_TILE_SIZE
+#define SPAWN_SPACING 16 // GENERATED_SPAWN_SPACING
+#define CAMERA_STEP 200.0f // along both axes, per frame
+// growth of the resident memory from before the level loads to the end of
+// the walk. the pages of the mapped level count too, so the chunk table can't
+// be paged in as the camera crosses it
+#define MEMORY_CEILING_BYTES (16 * 1024 * 1024)
+
+// the resident bytes of the process, 0 where they aren't known
+static size_t residentBytes() {
+#ifdef __linux__
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) {
+    return 0;
+  }
+  unsigned long size, resident;
+  const int read = fscanf(statm, "%lu %lu", &size, &resident);
+  fclose(statm);
+  return read == 2 ? resident * sysconf(_SC_PAGESIZE) : 0;
+#else
+  return 0;
+#endif
+}
+
+// whether the generator made the tile solid
+static bool expectSolid(int x, int y) {
+  const int pattern = (x / LEVEL_CHUNK_TILES + y / LEVEL_CHUNK_TILES) % 4;
+  return ((pattern & 1) && y % LEVEL_CHUNK_TILES == LEVEL_CHUNK_TILES - 1) ||
+         ((pattern & 2) && x % LEVEL_CHUNK_TILES == 0);
+}
+
+int main(int argc, char *argv[]) {
+  Tilemap::SetDeterministicStreaming(true);
+  const size_t baseline = residentBytes();
+  Tilemap map(TEST_LEVEL_DIR "/generated_100000x100000.level");
+  const SDL_Rect bounds = map.GetBounds();
+  if (bounds.w != WORLD_TILES * TILE_SIZE) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "the generated world didn't load");
+    return 1;
+  }
+  const int chunks = WORLD_TILES / LEVEL_CHUNK_TILES;
+  const float chunkPixels = LEVEL_CHUNK_TILES * TILE_SIZE;
+
+  std::unordered_set<uint32_t> resident;
+  std::vector<uint32_t> loaded, unloaded;
+  size_t peakMemory = 0;
+  size_t peakResident = 0;
+  int failures = 0;
+  int frames = 0;
+  for (float at = 0.0f; at < bounds.w; at += CAMERA_STEP, frames++) {
+    const glm::vec2 camera(at, at);
+    loaded.clear();
+    unloaded.clear();
+    map.Stream(camera, loaded, unloaded);
+
+    for (const uint32_t chunk : unloaded) {
+      failures += resident.erase(chunk) == 1 ? 0 : 1;
+    }
+    for (const uint32_t chunk : loaded) {
+      failures += resident.insert(chunk).second ? 0 : 1;
+      // one spawn in the middle of every SPAWN_SPACING chunks
+      const int cx = chunk % chunks;
+      const int cy = chunk / chunks;
+      const auto spawns = map.GetChunkSpawns(chunk);
+      const bool hasSpawn = cx % SPAWN_SPACING == 0 && cy % SPAWN_SPACING == 0;
+      bool right = spawns.size() == (hasSpawn ? 1u : 0u);
+      if (right && hasSpawn) {
+        const glm::ivec2 in(glm::vec2(spawns[0].x, spawns[0].y) / chunkPixels);
+        right = map.GetString(spawns[0].className) == "ANYA" &&
+                in == glm::ivec2(cx, cy);
+      }
+      if (!right) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "wrong spawns in chunk %d, %d", cx, cy);
+        failures++;
+      }
+    }
+    peakResident = glm::max(peakResident, resident.size());
+
+    // the tiles around the camera have to be in, or things fall through
+    const glm::ivec2 tile(camera / static_cast<float>(TILE_SIZE));
+    for (int y = -LEVEL_CHUNK_TILES; y <= LEVEL_CHUNK_TILES; y += 7) {
+      for (int x = -LEVEL_CHUNK_TILES; x <= LEVEL_CHUNK_TILES; x += 7) {
+        const int tx = tile.x + x;
+        const int ty = tile.y + y;
+        if (tx < 0 || ty < 0 || tx >= WORLD_TILES || ty >= WORLD_TILES) {
+          continue;
+        }
+        if (map.IsSolid(tx, ty) != expectSolid(tx, ty)) {
+          SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                       "tile %d, %d near the camera is wrong", tx, ty);
+          failures++;
+        }
+      }
+    }
+
+    peakMemory = glm::max(peakMemory, residentBytes());
+  }
+
+  const size_t growth = peakMemory - baseline;
+  SDL_Log("streaming world: %d frames, at most %zu resident chunks, memory "
+          "grew %zu KB, %d failures",
+          frames, peakResident, growth / 1024, failures);
+  if (peakResident > TILEMAP_MAX_RESIDENT_CHUNKS) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "more than %d chunks were resident",
+                 TILEMAP_MAX_RESIDENT_CHUNKS);
+    failures++;
+  }
+  if (growth > MEMORY_CEILING_BYTES) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                 "the memory grew past the %d MB ceiling",
+                 MEMORY_CEILING_BYTES / (1024 * 1024));
+    failures++;
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#include "plugins/physics.hpp"
+#include "tilemap.hpp"
+#include <SDL2/SDL.h>
+
+// Projectiles fired at one tile thick walls at tick rates from a laggy 10Hz
+// up to 240Hz have to stop at the wall instead of tunneling through it. The
+// walls are tiles of levels/walls.tmx and a static body in the broadphase,
+// the projectiles are moved by sweepBody like the ContinuousCollision ones.
+
+#define PROJECTILE_SIZE 4.0f
+#define TEST_SECONDS 2.0f
+// of the walls in levels/walls.tmx, both one tile thick
+#define TILE_WALL glm::vec4(640, 0, 656, 512)
+#define TILE_FLOOR glm::vec4(0, 384, 640, 400)
+#define STATIC_BODY glm::vec4(900, 0, 916, 512)
+// how far into a wall the float math may leave a projectile
+#define SURFACE_EPSILON 0.01f
+// how far a sliding projectile may end up from where it should
+#define SLIDE_EPSILON 0.01f
+
+struct Shot {
+  const char *name;
+  glm::vec2 position;
+  glm::vec2 direction; // scaled by the speed
+  glm::vec4 wall;
+  // of the side of the wall facing the projectile, which it never goes past
+  glm::vec2 normal;
+  // slides along the floor into the tile wall, keeping all of its x motion
+  bool slides = false;
+};
+
+// how far the projectile is past the side of the wall facing it, <= 0 if it
+// isn't
+static float penetration(const Shot &shot, glm::vec2 position) {
+  if (shot.normal.x < 0.0f) {
+    return position.x + PROJECTILE_SIZE - shot.wall.x;
+  } else if (shot.normal.x > 0.0f) {
+    return shot.wall.z - position.x;
+  }
+  return position.y + PROJECTILE_SIZE - shot.wall.y;
+}
+
+int main(int argc, char *argv[]) {
+  Tilemap::SetDeterministicStreaming(true);
+  Tilemap map(TEST_LEVEL_DIR "/walls.level");
+  std::vector<uint32_t> loaded, unloaded;
+  map.Stream(glm::vec2(512, 256), loaded, unloaded);
+  if (loaded.empty()) {
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "walls.level didn't load");
+    return 1;
+  }
+
+  Broadphase b;
+  b.grid.Clear();
+  b.grid.Insert(STATIC_BODY);
+  b.flags.push_back(COLLIDER_STATIC_BODY);
+  b.grid.Build();
+
+  const Shot shots[] = {
+      {"tile wall from the left", {100, 100}, {1, 0}, TILE_WALL, {-1, 0}},
+      {"tile wall from the right", {800, 100}, {-1, 0}, TILE_WALL, {1, 0}},
+      {"tile floor from above", {100, 100}, {0.5f, 1}, TILE_FLOOR, {0, -1}},
+      {"static body", {700, 100}, {1, 0}, STATIC_BODY, {-1, 0}},
+      {"slide along the floor", {20, 300}, {0.05f, 1}, TILE_FLOOR, {0, -1},
+       true},
+  };
+  const CollisionVolume volume = {
+      glm::vec4(0, 0, PROJECTILE_SIZE, PROJECTILE_SIZE)};
+  const float speeds[] = {500.0f, 2000.0f, 8000.0f};
+  const float tickRates[] = {10.0f, 30.0f, 60.0f, 120.0f, 240.0f};
+
+  int failures = 0;
+  for (const auto &shot : shots) {
+    for (const float speed : speeds) {
+      for (const float tickRate : tickRates) {
+        const float dt = 1.0f / tickRate;
+        glm::vec2 position = shot.position;
+        glm::vec2 velocity = shot.direction * speed;
+        float deepest = -1.0f;
+        for (int tick = 0; tick < TEST_SECONDS * tickRate; tick++) {
+          sweepBody(map, b, volume, position, velocity, dt);
+          deepest = glm::max(deepest, penetration(shot, position));
+        }
+        // stopped against the wall, not short of it or past it
+        const bool stopped = shot.normal.x != 0.0f ? velocity.x == 0.0f
+                                                   : velocity.y == 0.0f;
+        if (deepest > SURFACE_EPSILON || !stopped) {
+          SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                       "%s at %.0f px/s and %.0f Hz: %s, %.3f px in",
+                       shot.name, speed, tickRate,
+                       stopped ? "tunneled" : "didn't stop", deepest);
+          failures++;
+        } else if (shot.slides) {
+          // none of the step left after hitting the floor is lost
+          const float expected =
+              glm::min(shot.position.x + shot.direction.x * speed *
+                                             TEST_SECONDS,
+                       TILE_WALL.x - PROJECTILE_SIZE);
+          if (glm::abs(position.x - expected) > SLIDE_EPSILON) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                         "%s at %.0f px/s and %.0f Hz: ended at x %.3f "
+                         "instead of %.3f",
+                         shot.name, speed, tickRate, position.x, expected);
+            failures++;
+          }
+        }
+      }
+    }
+  }
+
+  SDL_Log("swept collision: %d of %d shots failed", failures,
+          static_cast<int>(std::size(shots) * std::size(speeds) *
+                           std::size(tickRates)));
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#include "plugins/transform.hpp"
+#include <SDL2/SDL.h>
+
+// Propagates transforms down wide and deep hierarchies with
+// Transform2DPlugin. Times a tick with nothing moving, where the dirty flags
+// skip every subtree, against one with every root moving, where nothing can
+// be skipped. The leaves have to follow their root in the same tick.
+
+#define WIDE_ROOTS 100
+#define WIDE_CHILDREN 1000 // per root
+#define DEEP_CHAINS 1000
+#define DEEP_DEPTH 32
+#define BENCH_TICKS 60
+#define BENCH_TICK (1.0f / 60.0f)
+// of each child from its parent
+#define CHILD_OFFSET glm::vec2(2.0f, 1.0f)
+
+struct Hierarchy {
+  const char *name;
+  std::vector<flecs::entity> roots;
+  std::vector<flecs::entity> leaves;
+  std::vector<int> depths; // of the leaves
+};
+
+static double seconds(Uint64 start) {
+  return static_cast<double>(SDL_GetPerformanceCounter() - start) /
+         static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+static flecs::entity child(flecs::world &ecs, flecs::entity parent) {
+  return ecs.entity()
+      .child_of(parent)
+      .set<Transform2D>(Transform2D().WithPosition(CHILD_OFFSET));
+}
+
+static Hierarchy wide(flecs::world &ecs) {
+  Hierarchy h = {"wide"};
+  for (int r = 0; r < WIDE_ROOTS; r++) {
+    const auto root = ecs.entity().set<Transform2D>(Transform2D());
+    h.roots.push_back(root);
+    for (int c = 0; c < WIDE_CHILDREN; c++) {
+      h.leaves.push_back(child(ecs, root));
+      h.depths.push_back(1);
+    }
+  }
+  return h;
+}
+
+static Hierarchy deep(flecs::world &ecs) {
+  Hierarchy h = {"deep"};
+  for (int c = 0; c < DEEP_CHAINS; c++) {
+    flecs::entity e = ecs.entity().set<Transform2D>(Transform2D());
+    h.roots.push_back(e);
+    for (int d = 0; d < DEEP_DEPTH; d++) {
+      e = child(ecs, e);
+    }
+    h.leaves.push_back(e);
+    h.depths.push_back(DEEP_DEPTH);
+  }
+  return h;
+}
+
+// whether every leaf is where its root at rootPosition puts it this tick
+static bool leavesFollow(const Hierarchy &h, glm::vec2 rootPosition) {
+  for (size_t i = 0; i < h.leaves.size(); i++) {
+    const glm::vec2 expected =
+        rootPosition + CHILD_OFFSET * static_cast<float>(h.depths[i]);
+    if (glm::distance(h.leaves[i].get<Transform2D>()->global_position,
+                      expected) > 0.001f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// the time of a tick, moving the roots to rootPosition(tick) first
+template <class F>
+static double run(flecs::world &ecs, const Hierarchy &h, F &&rootPosition,
+                  bool &followed) {
+  double total = 0.0;
+  followed = true;
+  for (int tick = 0; tick < BENCH_TICKS; tick++) {
+    const glm::vec2 position = rootPosition(tick);
+    for (const auto &root : h.roots) {
+      root.get_mut<Transform2D>()->position = position;
+    }
+    const Uint64 start = SDL_GetPerformanceCounter();
+    ecs.progress(BENCH_TICK);
+    total += seconds(start);
+    followed = followed && leavesFollow(h, position);
+  }
+  return total / BENCH_TICKS;
+}
+
+int main(int argc, char *argv[]) {
+  int failures = 0;
+  for (const auto build : {wide, deep}) {
+    flecs::world ecs;
+    // only the transform systems, not the rest of the simulation pipeline
+    ecs.set_pipeline(
+        ecs.pipeline().term(flecs::System).term<SimulationPhase>().build());
+    Transform2DPlugin().addSystems(ecs);
+    const Hierarchy h = build(ecs);
+    // composed once, so the ticks with nothing moving have nothing to do
+    ecs.progress(BENCH_TICK);
+
+    bool staticFollowed, movingFollowed;
+    const double still = run(
+        ecs, h, [](int tick) { return glm::vec2(0, 0); }, staticFollowed);
+    const double moving = run(
+        ecs, h, [](int tick) { return glm::vec2(1 + tick, -1 - tick); },
+        movingFollowed);
+    if (!staticFollowed || !movingFollowed) {
+      SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                   "%s: the leaves didn't follow their roots%s", h.name,
+                   movingFollowed ? "" : " while they moved");
+      failures++;
+    }
+    SDL_Log("%s, %zu roots and %zu leaves: %.3f ms per tick with nothing "
+            "moving, %.3f ms with every root moving",
+            h.name, h.roots.size(), h.leaves.size(), still * 1e3,
+            moving * 1e3);
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -2,6 +2,7 @@
 
 #include <memory>
 
+#include "frame-latency.hpp"
 #include "renderer.hpp"
 #include "window.hpp"
 
@@ -19,7 +20,9 @@ void emscripten_update();
 
 class App {
 public:
-  App();
+  // --record <path> saves the session's input to path, --replay <path> plays
+  // it back as fast as possible in a hidden window and reports frame times
+  App(int argc, char **argv);
   ~App();
   void run();
   void update();
@@ -32,6 +35,7 @@ private:
   std::unique_ptr<Renderer> renderer;
 
   SharedData shared_data;
+  FrameLatency latency;
 
 #ifdef SHARED_GAME
   cr_plugin game_ctx;
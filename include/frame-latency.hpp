@@ -0,0 +1,52 @@
+#pragma once
+
+#include <SDL.h>
+#include <cstdint>
+#include <shared-data.hpp>
+
+// histogram resolution, anything slower than the last bucket is counted in it
+#define LATENCY_BUCKET_US 100
+#define LATENCY_BUCKETS 1000 // 100 ms
+// frames per report, the histograms start over after each
+#define LATENCY_REPORT_FRAMES 3600
+
+class LatencyHistogram {
+public:
+  void Add(uint64_t microseconds);
+  void Clear();
+  // upper edge of the bucket holding the p-th sample, in ms. never above the
+  // max
+  float Percentile(float p) const;
+  float Max() const { return this->max / 1000.0f; }
+  uint32_t Count() const { return this->count; }
+
+private:
+  uint32_t buckets[LATENCY_BUCKETS] = {};
+  uint32_t count = 0;
+  uint64_t max = 0;
+};
+
+enum LatencyStage {
+  LATENCY_INPUT_TO_SAMPLE, // event queued to the game reading it
+  LATENCY_SIMULATE,        // sampled to the world having progressed
+  LATENCY_SUBMIT,          // progressed to the sprite batch flushed
+  LATENCY_PRESENT,         // flushed to the swap returning
+  LATENCY_INPUT_TO_PRESENT,
+  LATENCY_STAGE_COUNT,
+};
+
+// Aggregates the FrameTiming of every presented frame into a histogram per
+// stage and logs the percentiles every LATENCY_REPORT_FRAMES frames.
+class FrameLatency {
+public:
+  // the performance counter value of an SDL event timestamp
+  static uint64_t EventCounter(Uint32 timestamp);
+
+  void Add(const FrameTiming &timing);
+  // logs the percentiles and starts over
+  void Report();
+
+private:
+  LatencyHistogram stages[LATENCY_STAGE_COUNT];
+  uint32_t frames = 0;
+};
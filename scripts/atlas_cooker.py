@@ -0,0 +1,83 @@
+import argparse
+import json
+import os
+import struct
+
+# Cooks the json .atlas files written by sprite_atlasser.py into the binary
+# .sheet format read by game/modules/render/src/spritesheet.cpp
+
+SHEET_MAGIC = 0x53534C47  # "GLSS"
+SHEET_VERSION = 1
+
+HEADER_FORMAT = "<11I"
+ANIMATION_FORMAT = "<5I"
+FRAME_FORMAT = "<If"
+
+
+def cook(atlas_path, output_path):
+    with open(atlas_path, "r") as atlas_file:
+        atlas = json.load(atlas_file)
+
+    rects = atlas["atlas"]
+    if len(rects) % 4 != 0 or len(rects) == 0:
+        raise ValueError(f"{atlas_path} atlas must be x, y, w, h quadruples")
+    rect_count = len(rects) // 4
+
+    strings = bytearray()
+
+    def add_string(value):
+        offset = len(strings)
+        encoded = value.encode("utf-8")
+        strings.extend(encoded + b"\0")
+        return offset, len(encoded)
+
+    animations = bytearray()
+    frames = bytearray()
+    frame_count = 0
+    for name, animation in atlas["animations"].items():
+        for frame in animation["frames"]:
+            if frame < 0 or frame >= rect_count:
+                raise ValueError(f"animation {name} uses missing rect {frame}")
+            frames += struct.pack(FRAME_FORMAT, frame, animation["frameTime"])
+        animations += struct.pack(ANIMATION_FORMAT, *add_string(name),
+                                  frame_count, len(animation["frames"]),
+                                  1 if animation["loop"] else 0)
+        frame_count += len(animation["frames"])
+
+    # the texture path stays relative to the sheet
+    texture = os.path.relpath(
+        os.path.join(os.path.dirname(atlas_path), atlas["texture"]),
+        os.path.dirname(output_path)).replace(os.sep, "/")
+    texture_offset = add_string(texture)[0]
+
+    body = bytearray(struct.calcsize(HEADER_FORMAT))
+    rects_offset = len(body)
+    body += struct.pack(f"<{len(rects)}i", *rects)
+    animations_offset = len(body)
+    body += animations
+    frames_offset = len(body)
+    body += frames
+    strings_offset = len(body)
+    body += strings
+    while len(body) % 4 != 0:
+        body.append(0)
+
+    struct.pack_into(HEADER_FORMAT, body, 0, SHEET_MAGIC, SHEET_VERSION,
+                     rect_count, rects_offset,
+                     len(atlas["animations"]), animations_offset,
+                     frame_count, frames_offset,
+                     strings_offset, len(strings), texture_offset)
+
+    with open(output_path, "wb") as sheet_file:
+        sheet_file.write(body)
+    print(f"Cooked {atlas_path} -> {output_path} ({len(body)} bytes)")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Cook json sprite atlases into the binary sheet format")
+    parser.add_argument("atlases", nargs="+", help="Paths to the .atlas files")
+    args = parser.parse_args()
+
+    for atlas_path in args.atlases:
+        cook(atlas_path, os.path.splitext(atlas_path)[0] + ".sheet")
@@ -0,0 +1,414 @@
+import argparse
+import base64
+import os
+import struct
+import xml.etree.ElementTree as ET
+import zlib
+
+# Cooks Tiled .tmx maps (and their .tsx tilesets) into the binary level format
+# read by game/src/tilemap.cpp, see game/include/level-format.hpp for the layout
+
+LEVEL_MAGIC = 0x564C4C47  # "GLLV"
+LEVEL_VERSION = 2
+LEVEL_NO_OBJECT = 0xFFFFFFFF
+LEVEL_EMPTY_CHUNK = 0xFFFFFFFF
+LEVEL_CHUNK_TILES = 32
+
+GID_MASK = 0x1FFFFFFF  # strip the tiled flip / rotation flags
+
+HEADER_FORMAT = "<23I"
+SPAWN_FORMAT = "<5I4f3I"
+CHUNK_FORMAT = "<3I"
+
+
+def align(data, alignment=4):
+    while len(data) % alignment != 0:
+        data.append(0)
+
+
+class StringTable:
+    def __init__(self):
+        self.data = bytearray()
+        self.offsets = {}
+
+    def add(self, value):
+        # returns an (offset, length) pair, identical strings are stored once
+        encoded = value.encode("utf-8")
+        if encoded not in self.offsets:
+            self.offsets[encoded] = len(self.data)
+            self.data += encoded + b"\0"
+        return self.offsets[encoded], len(encoded)
+
+
+def get_class(element):
+    # tiled >= 1.9 writes "class", older versions write "type"
+    return element.get("class", element.get("type", ""))
+
+
+def load_tileset(element, map_dir):
+    first_gid = int(element.get("firstgid"))
+    tileset_dir = map_dir
+    if element.get("source") is not None:
+        tsx_path = os.path.join(map_dir, element.get("source"))
+        tileset_dir = os.path.dirname(tsx_path)
+        element = ET.parse(tsx_path).getroot()
+
+    image = element.find("image")
+    image_path = ""
+    if image is not None:
+        image_path = os.path.join(tileset_dir, image.get("source"))
+
+    classes = {}
+    for tile in element.findall("tile"):
+        tile_class = get_class(tile)
+        if tile_class:
+            classes[first_gid + int(tile.get("id"))] = tile_class
+
+    return {"first_gid": first_gid, "image": image_path, "classes": classes}
+
+
+def decode_layer(layer, width, height):
+    data = layer.find("data")
+    encoding = data.get("encoding")
+    compression = data.get("compression")
+
+    if encoding == "csv":
+        gids = [int(v) for v in data.text.replace("\n", "").split(",") if v]
+    elif encoding == "base64":
+        raw = base64.b64decode(data.text.strip())
+        if compression == "zlib" or compression == "gzip":
+            raw = zlib.decompress(raw, 15 + 32)
+        elif compression is not None:
+            raise ValueError(f"unsupported layer compression: {compression}")
+        gids = list(struct.unpack(f"<{len(raw) // 4}I", raw))
+    else:
+        gids = [int(tile.get("gid", 0)) for tile in data.findall("tile")]
+
+    if len(gids) != width * height:
+        raise ValueError(f"layer {layer.get('name')} has {len(gids)} tiles, "
+                         f"expected {width * height}")
+    return [gid & GID_MASK for gid in gids]
+
+
+def chunk_size(layer_count):
+    tiles = LEVEL_CHUNK_TILES * LEVEL_CHUNK_TILES
+    return layer_count * tiles * 4 + tiles
+
+
+def cook_chunks(layers, collision, width, height):
+    # splits the map into square chunks, edge chunks are padded with empty
+    # tiles. returns the data of every chunk that isn't completely empty and
+    # the data index of each chunk, row major
+    columns = (width + LEVEL_CHUNK_TILES - 1) // LEVEL_CHUNK_TILES
+    rows = (height + LEVEL_CHUNK_TILES - 1) // LEVEL_CHUNK_TILES
+    data = bytearray()
+    indices = []
+    for cy in range(rows):
+        for cx in range(columns):
+            chunk_gids = []
+            for layer in layers:
+                for y in range(LEVEL_CHUNK_TILES):
+                    for x in range(LEVEL_CHUNK_TILES):
+                        tx = cx * LEVEL_CHUNK_TILES + x
+                        ty = cy * LEVEL_CHUNK_TILES + y
+                        inside = tx < width and ty < height
+                        chunk_gids.append(layer[tx + ty * width]
+                                          if inside else 0)
+            chunk_classes = bytearray(LEVEL_CHUNK_TILES * LEVEL_CHUNK_TILES)
+            for y in range(LEVEL_CHUNK_TILES):
+                for x in range(LEVEL_CHUNK_TILES):
+                    tx = cx * LEVEL_CHUNK_TILES + x
+                    ty = cy * LEVEL_CHUNK_TILES + y
+                    if tx < width and ty < height:
+                        chunk_classes[x + y * LEVEL_CHUNK_TILES] = \
+                            collision[tx + ty * width]
+
+            if not any(chunk_gids) and not any(chunk_classes):
+                indices.append(LEVEL_EMPTY_CHUNK)
+                continue
+            indices.append(len(data) // chunk_size(len(layers)))
+            data += struct.pack(f"<{len(chunk_gids)}I", *chunk_gids)
+            data += chunk_classes
+    return columns, rows, indices, data
+
+
+def load_objects(root):
+    objects = []
+    for group in root.iter("objectgroup"):
+        for obj in group.findall("object"):
+            x = float(obj.get("x", 0))
+            y = float(obj.get("y", 0))
+
+            points = []
+            shape = obj.find("polyline")
+            if shape is None:
+                shape = obj.find("polygon")
+            if shape is not None:
+                for point in shape.get("points").split(" "):
+                    px, py = point.split(",")
+                    points.append((float(px) + x, float(py) + y))
+
+            path = LEVEL_NO_OBJECT
+            properties = obj.find("properties")
+            if properties is not None:
+                for prop in properties.findall("property"):
+                    if prop.get("name") == "path" and prop.get("type") == "object":
+                        path = int(prop.get("value"))
+
+            objects.append({
+                "uid": int(obj.get("id")),
+                "class": get_class(obj),
+                "name": obj.get("name", ""),
+                "x": x,
+                "y": y,
+                "w": float(obj.get("width", 0)),
+                "h": float(obj.get("height", 0)),
+                "path": path,
+                "points": points,
+            })
+    objects.sort(key=lambda o: o["uid"])
+    return objects
+
+
+def cook(tmx_path, output_path):
+    root = ET.parse(tmx_path).getroot()
+    map_dir = os.path.dirname(tmx_path)
+    output_dir = os.path.dirname(output_path)
+
+    width = int(root.get("width"))
+    height = int(root.get("height"))
+    tile_width = int(root.get("tilewidth"))
+    tile_height = int(root.get("tileheight"))
+
+    tilesets = [load_tileset(ts, map_dir) for ts in root.findall("tileset")]
+    if len(tilesets) == 0:
+        raise ValueError("map has no tilesets")
+    if len(tilesets) > 1:
+        print(f"warning: {tmx_path} has {len(tilesets)} tilesets, "
+              "only the first is drawn")
+
+    # intern tile classes, class 0 means the tile has no class
+    classes = [""]
+    tile_classes = {}
+    for tileset in tilesets:
+        for gid, tile_class in tileset["classes"].items():
+            if tile_class not in classes:
+                classes.append(tile_class)
+            tile_classes[gid] = classes.index(tile_class)
+    if len(classes) > 255:
+        raise ValueError("too many tile classes for the collision grid")
+
+    layers = [decode_layer(layer, width, height)
+              for layer in root.findall("layer")]
+
+    # the collision grid holds the class of the top most classed tile
+    collision = bytearray(width * height)
+    for layer in layers:
+        for i, gid in enumerate(layer):
+            if gid in tile_classes:
+                collision[i] = tile_classes[gid]
+
+    columns, rows, chunk_indices, chunk_data = cook_chunks(
+        layers, collision, width, height)
+
+    # spawns are grouped by the chunk they are in so they can be streamed in
+    # with it
+    def chunk_of(obj):
+        chunk_w = LEVEL_CHUNK_TILES * tile_width
+        chunk_h = LEVEL_CHUNK_TILES * tile_height
+        cx = min(max(int(obj["x"] // chunk_w), 0), columns - 1)
+        cy = min(max(int(obj["y"] // chunk_h), 0), rows - 1)
+        return cx + cy * columns
+
+    objects = load_objects(root)
+    objects.sort(key=lambda o: (chunk_of(o), o["uid"]))
+    strings = StringTable()
+
+    body = bytearray(struct.calcsize(HEADER_FORMAT))
+
+    chunk_spawns = [[0, 0] for _ in chunk_indices]
+    for i, obj in enumerate(objects):
+        chunk = chunk_of(obj)
+        if chunk_spawns[chunk][1] == 0:
+            chunk_spawns[chunk][0] = i
+        chunk_spawns[chunk][1] += 1
+    chunks_offset = len(body)
+    for index, (first_spawn, spawn_count) in zip(chunk_indices, chunk_spawns):
+        body += struct.pack(CHUNK_FORMAT, index, first_spawn, spawn_count)
+
+    classes_offset = len(body)
+    for tile_class in classes:
+        body += struct.pack("<2I", *strings.add(tile_class))
+
+    points = []
+    spawns = bytearray()
+    for obj in objects:
+        first_point = len(points)
+        points += obj["points"]
+        spawns += struct.pack(SPAWN_FORMAT, obj["uid"],
+                              *strings.add(obj["class"]),
+                              *strings.add(obj["name"]),
+                              obj["x"], obj["y"], obj["w"], obj["h"],
+                              obj["path"], first_point, len(obj["points"]))
+    spawns_offset = len(body)
+    body += spawns
+
+    # uid -> spawn index table so lookups by handle are O(1)
+    uid_count = max(obj["uid"] for obj in objects) + 1 if objects else 0
+    uid_index = [LEVEL_NO_OBJECT] * uid_count
+    for i, obj in enumerate(objects):
+        uid_index[obj["uid"]] = i
+    uid_index_offset = len(body)
+    body += struct.pack(f"<{uid_count}I", *uid_index)
+
+    points_offset = len(body)
+    for point in points:
+        body += struct.pack("<2f", *point)
+
+    # a tileset without an image is never drawn, like in the test levels
+    image_path = tilesets[0]["image"]
+    if image_path:
+        image_path = os.path.relpath(image_path, output_dir)
+    tileset_image = strings.add(image_path.replace(os.sep, "/"))[0]
+
+    strings_offset = len(body)
+    body += strings.data
+    align(body)
+
+    # the chunk tiles go last, everything before them is loaded up front
+    chunk_data_offset = len(body)
+    body += chunk_data
+
+    struct.pack_into(HEADER_FORMAT, body, 0, LEVEL_MAGIC, LEVEL_VERSION,
+                     width, height, tile_width, tile_height,
+                     len(layers), columns, rows, chunks_offset,
+                     len(classes), classes_offset,
+                     len(objects), spawns_offset,
+                     uid_count, uid_index_offset,
+                     len(points), points_offset,
+                     strings_offset, len(strings.data),
+                     tileset_image, tilesets[0]["first_gid"],
+                     chunk_data_offset)
+
+    with open(output_path, "wb") as level_file:
+        level_file.write(body)
+    print(f"Cooked {tmx_path} -> {output_path} ({len(body)} bytes)")
+
+
+# generated levels, a repeating pattern of chunks so a world of any size cooks
+# quickly and its chunk tiles stay small. the chunk at (cx, cy) has pattern
+# (cx + cy) % 4: nothing, a floor along its bottom row, a wall along its left
+# column or both. every GENERATED_SPAWN_SPACING chunks along both axes has an
+# ANYA in its middle
+GENERATED_TILE_SIZE = 16
+GENERATED_SPAWN_SPACING = 16
+
+
+def generated_chunk(pattern):
+    gids = [0] * (LEVEL_CHUNK_TILES * LEVEL_CHUNK_TILES)
+    for i in range(LEVEL_CHUNK_TILES):
+        if pattern & 1:
+            gids[i + (LEVEL_CHUNK_TILES - 1) * LEVEL_CHUNK_TILES] = 1
+        if pattern & 2:
+            gids[i * LEVEL_CHUNK_TILES] = 1
+    data = bytearray(struct.pack(f"<{len(gids)}I", *gids))
+    data += bytes(gids)  # the solid class is 1, like the gid
+    return data
+
+
+def generate(width, height, output_path):
+    columns = (width + LEVEL_CHUNK_TILES - 1) // LEVEL_CHUNK_TILES
+    rows = (height + LEVEL_CHUNK_TILES - 1) // LEVEL_CHUNK_TILES
+    chunk_pixels = LEVEL_CHUNK_TILES * GENERATED_TILE_SIZE
+    strings = StringTable()
+    anya = strings.add("ANYA")
+    no_name = strings.add("")
+
+    body = bytearray(struct.calcsize(HEADER_FORMAT))
+
+    # the rows without spawns only differ by where the pattern starts
+    def chunk_index(pattern):
+        return LEVEL_EMPTY_CHUNK if pattern == 0 else pattern - 1
+
+    plain_rows = []
+    for start in range(4):
+        plain_rows.append(b"".join(
+            struct.pack(CHUNK_FORMAT, chunk_index((start + cx) % 4), 0, 0)
+            for cx in range(columns)))
+
+    spawns = bytearray()
+    spawn_count = 0
+    chunks_offset = len(body)
+    for cy in range(rows):
+        if cy % GENERATED_SPAWN_SPACING != 0:
+            body += plain_rows[cy % 4]
+            continue
+        for cx in range(columns):
+            index = chunk_index((cx + cy) % 4)
+            if cx % GENERATED_SPAWN_SPACING != 0:
+                body += struct.pack(CHUNK_FORMAT, index, 0, 0)
+                continue
+            body += struct.pack(CHUNK_FORMAT, index, spawn_count, 1)
+            spawn_count += 1
+            spawns += struct.pack(SPAWN_FORMAT, spawn_count, *anya, *no_name,
+                                  (cx + 0.5) * chunk_pixels,
+                                  (cy + 0.5) * chunk_pixels, 0.0, 0.0,
+                                  LEVEL_NO_OBJECT, 0, 0)
+
+    classes_offset = len(body)
+    for tile_class in ["", "SOLID"]:
+        body += struct.pack("<2I", *strings.add(tile_class))
+
+    spawns_offset = len(body)
+    body += spawns
+    # the uids are 1 up in spawn order
+    uid_index_offset = len(body)
+    body += struct.pack(f"<{spawn_count + 1}I", LEVEL_NO_OBJECT,
+                        *range(spawn_count))
+
+    points_offset = len(body)  # no points
+    tileset_image = strings.add("")[0]
+    strings_offset = len(body)
+    body += strings.data
+    align(body)
+
+    chunk_data_offset = len(body)
+    for pattern in range(1, 4):
+        body += generated_chunk(pattern)
+
+    struct.pack_into(HEADER_FORMAT, body, 0, LEVEL_MAGIC, LEVEL_VERSION,
+                     width, height, GENERATED_TILE_SIZE, GENERATED_TILE_SIZE,
+                     1, columns, rows, chunks_offset,
+                     2, classes_offset,
+                     spawn_count, spawns_offset,
+                     spawn_count + 1, uid_index_offset,
+                     0, points_offset,
+                     strings_offset, len(strings.data),
+                     tileset_image, 1,
+                     chunk_data_offset)
+
+    with open(output_path, "wb") as level_file:
+        level_file.write(body)
+    print(f"Generated {width}x{height} -> {output_path} ({len(body)} bytes)")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Cook Tiled maps into the binary level format")
+    parser.add_argument("maps", nargs="*", help="Paths to the .tmx maps")
+    parser.add_argument("-o", "--output", required=False,
+                        help="Output directory (defaults to next to the map)")
+    parser.add_argument("--generate", metavar="WIDTHxHEIGHT",
+                        help="Generate a level of that many tiles instead, "
+                        "written to generated_WIDTHxHEIGHT.level")
+    args = parser.parse_args()
+
+    if args.generate:
+        width, height = (int(v) for v in args.generate.split("x"))
+        name = f"generated_{width}x{height}.level"
+        generate(width, height, os.path.join(args.output or ".", name))
+
+    for tmx_path in args.maps:
+        output_dir = args.output or os.path.dirname(tmx_path)
+        name = os.path.splitext(os.path.basename(tmx_path))[0]
+        cook(tmx_path, os.path.join(output_dir, f"{name}.level"))
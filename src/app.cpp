@@ -2,6 +2,7 @@
 
 #include "app.hpp"
 
+#include <algorithm>
 #include <glm/glm.hpp>
 
 #include <stdio.h>
@@ -17,10 +18,25 @@ static App *app_instance;
 void emscripten_update() { app_instance->update(); }
 #endif
 
-App::App() {
+App::App(int argc, char **argv) {
   this->is_running = true;
   // memset clear the shared data buffer
   memset(&this->shared_data, 0, sizeof(this->shared_data));
+
+  for (int i = 1; i + 1 < argc; i++) {
+    if (strcmp(argv[i], "--rollback") == 0) {
+      this->shared_data.rollback_ticks = SDL_atoi(argv[++i]);
+      continue;
+    }
+    if (strcmp(argv[i], "--record") == 0) {
+      this->shared_data.input_mode = INPUT_RECORD;
+    } else if (strcmp(argv[i], "--replay") == 0) {
+      this->shared_data.input_mode = INPUT_REPLAY;
+    } else {
+      continue;
+    }
+    SDL_strlcpy(this->shared_data.input_path, argv[++i], INPUT_PATH_SIZE);
+  }
 }
 
 App::~App() {}
@@ -28,9 +44,14 @@ App::~App() {}
 void App::run() {
 
   const auto initial_window_size = glm::vec2(800, 600);
-  this->window = std::make_unique<Window>(GAME_NAME, initial_window_size.x,
-                                          initial_window_size.y);
+  const bool replaying = this->shared_data.input_mode == INPUT_REPLAY;
+  this->window = std::make_unique<Window>(
+      GAME_NAME, initial_window_size.x, initial_window_size.y,
+      replaying ? SDL_WINDOW_HIDDEN : 0);
   this->renderer = std::make_unique<Renderer>(this->window.get());
+  if (replaying) {
+    SDL_GL_SetSwapInterval(0); // a benchmark, don't wait for vsync
+  }
 
   SDL_StopTextInput(); // ensure this is off by default
 
@@ -46,7 +67,7 @@ void App::run() {
   app_instance = this;
   emscripten_set_main_loop(emscripten_update, 0, this->is_running);
 #else
-  while (this->is_running) {
+  while (this->is_running && !this->shared_data.quit) {
     this->update();
   }
 #endif
@@ -55,6 +76,12 @@ void App::run() {
 }
 
 void App::update() {
+  // input the game didn't sample last frame is reflected by this one
+  const FrameTiming &last = this->shared_data.timing;
+  const uint64_t carried = last.sampled == 0 ? last.input : 0;
+  this->shared_data.timing = {};
+  this->shared_data.timing.input = carried;
+
   this->renderer->Clear();
   this->poll_events();
 #ifdef SHARED_GAME
@@ -70,9 +97,12 @@ void App::update() {
   this->game.update();
 #endif
   this->renderer->Present();
+  this->shared_data.timing.presented = SDL_GetPerformanceCounter();
+  this->latency.Add(this->shared_data.timing);
 }
 
 void App::onClose() {
+  this->latency.Report();
 #ifdef SHARED_GAME
   cr_plugin_close(this->game_ctx);
   SDL_Log("App closed\n");
@@ -88,11 +118,22 @@ void App::onClose() {
 void App::poll_events() {
   SDL_Event event;
   while (SDL_PollEvent(&event)) {
+    if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP ||
+        event.type == SDL_TEXTINPUT) {
+      // the oldest event the frame has to reflect
+      auto &input = this->shared_data.timing.input;
+      const uint64_t queued =
+          FrameLatency::EventCounter(event.common.timestamp);
+      input = input == 0 ? queued : std::min(input, queued);
+    }
     switch (event.type) {
     case SDL_QUIT:
       this->is_running = false;
       break;
     case SDL_KEYDOWN:
+      if (this->shared_data.input_mode == INPUT_REPLAY) {
+        break; // the text input comes from the recording
+      }
       if (event.key.keysym.sym == SDLK_BACKSPACE &&
           strlen(this->shared_data.text_input_buffer) > 0) {
         this->shared_data
@@ -101,6 +142,9 @@ void App::poll_events() {
       }
       break;
     case SDL_TEXTINPUT:
+      if (this->shared_data.input_mode == INPUT_REPLAY) {
+        break;
+      }
       // add text to buffer
       if (strlen(this->shared_data.text_input_buffer) +
               strlen(event.text.text) <
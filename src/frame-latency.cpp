@@ -0,0 +1,82 @@
+#include "frame-latency.hpp"
+#include <algorithm>
+#include <cmath>
+
+static const char *stageNames[LATENCY_STAGE_COUNT] = {
+    "input to sample", "simulate", "submit", "present", "input to present",
+};
+
+void LatencyHistogram::Add(uint64_t microseconds) {
+  const uint64_t bucket = microseconds / LATENCY_BUCKET_US;
+  this->buckets[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+  this->count++;
+  if (microseconds > this->max) {
+    this->max = microseconds;
+  }
+}
+
+void LatencyHistogram::Clear() { *this = LatencyHistogram(); }
+
+float LatencyHistogram::Percentile(float p) const {
+  if (this->count == 0) {
+    return 0.0f;
+  }
+  // rank of the sample, 1 based
+  const uint32_t rank =
+      std::max(static_cast<uint32_t>(std::ceil(p * this->count)), 1u);
+  uint32_t seen = 0;
+  for (int i = 0; i < LATENCY_BUCKETS - 1; i++) {
+    seen += this->buckets[i];
+    if (seen >= rank) {
+      return std::min((i + 1) * LATENCY_BUCKET_US / 1000.0f, this->Max());
+    }
+  }
+  return this->Max();
+}
+
+uint64_t FrameLatency::EventCounter(Uint32 timestamp) {
+  const uint64_t now = SDL_GetPerformanceCounter();
+  const Uint32 age = SDL_GetTicks() - timestamp;
+  const uint64_t ageCounts =
+      static_cast<uint64_t>(age) * SDL_GetPerformanceFrequency() / 1000;
+  return ageCounts < now ? now - ageCounts : now;
+}
+
+void FrameLatency::Add(const FrameTiming &timing) {
+  // the frame stopped early, a level switch or the end of a replay
+  if (timing.sampled == 0 || timing.submitted == 0) {
+    return;
+  }
+  const uint64_t frequency = SDL_GetPerformanceFrequency();
+  const auto us = [frequency](uint64_t from, uint64_t to) {
+    return to > from ? (to - from) * 1000000 / frequency : 0;
+  };
+  this->stages[LATENCY_SIMULATE].Add(us(timing.sampled, timing.simulated));
+  this->stages[LATENCY_SUBMIT].Add(us(timing.simulated, timing.submitted));
+  this->stages[LATENCY_PRESENT].Add(us(timing.submitted, timing.presented));
+  if (timing.input != 0) {
+    this->stages[LATENCY_INPUT_TO_SAMPLE].Add(us(timing.input, timing.sampled));
+    this->stages[LATENCY_INPUT_TO_PRESENT].Add(
+        us(timing.input, timing.presented));
+  }
+
+  if (++this->frames >= LATENCY_REPORT_FRAMES) {
+    this->Report();
+  }
+}
+
+void FrameLatency::Report() {
+  if (this->frames == 0) {
+    return;
+  }
+  SDL_Log("Latency over %u frames, ms   p50    p90    p99    max  samples",
+          this->frames);
+  for (int i = 0; i < LATENCY_STAGE_COUNT; i++) {
+    const auto &stage = this->stages[i];
+    SDL_Log("  %-24s %6.2f %6.2f %6.2f %6.2f %8u", stageNames[i],
+            stage.Percentile(0.5f), stage.Percentile(0.9f),
+            stage.Percentile(0.99f), stage.Max(), stage.Count());
+    this->stages[i].Clear();
+  }
+  this->frames = 0;
+}
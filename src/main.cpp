@@ -1,7 +1,7 @@
 #include "app.hpp"
 
 int main(int argc, char **argv) {
-  App app;
+  App app(argc, argv);
   app.run();
   return 0;
 }
\ No newline at end of file